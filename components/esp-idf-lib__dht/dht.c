@@ -39,6 +39,7 @@
  * BSD Licensed as described in the file LICENSE
  */
 #include "dht.h"
+#include "dht_priv.h"
 
 #include <freertos/FreeRTOS.h>
 #include <string.h>
@@ -46,10 +47,30 @@
 #include <ets_sys.h>
 #include <esp_idf_lib_helpers.h>
 
+#if CONFIG_DHT_FAST_GPIO || CONFIG_DHT_USE_RMT
+#include <freertos/task.h>
+#include <esp_timer.h>
+#endif
+
+#if CONFIG_DHT_FAST_GPIO
+#include <esp_attr.h>
+#include <esp_cpu.h>
+#include <esp_rom_sys.h>
+#include <hal/gpio_ll.h>
+#include <soc/gpio_struct.h>
+#endif
+
+#if CONFIG_DHT_USE_RMT
+#include "dht_rmt.h"
+
+// Sensors read through RMT; further pins use GPIO polling
+#define DHT_RMT_MAX_PINS 4
+#endif
+
 // DHT timer precision in microseconds
 #define DHT_TIMER_INTERVAL 2
-#define DHT_DATA_BITS 40
-#define DHT_DATA_BYTES (DHT_DATA_BITS / 8)
+// Phases 'B', 'C', 'D' and a low/high pair per bit
+#define DHT_GPIO_PULSES (3 + DHT_DATA_BITS * 2)
 
 /*
  *  Note:
@@ -91,8 +112,6 @@ static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
 #define PORT_EXIT_CRITICAL() portEXIT_CRITICAL()
 #endif
 
-#define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
-
 #define CHECK_LOGE(x, msg, ...) do { \
         esp_err_t __; \
         if ((__ = x) != ESP_OK) { \
@@ -133,85 +152,288 @@ static esp_err_t dht_await_pin_state(gpio_num_t pin, uint32_t timeout,
 }
 
 /**
- * Request data from DHT and read raw bit stream.
+ * Request data from DHT and record the response pulse lengths, starting
+ * with the phase 'B' high, in DHT_TIMER_INTERVAL units.
  * The function call should be protected from task switching.
  * Return false if error occurred.
  */
-static inline esp_err_t dht_fetch_data(dht_sensor_type_t sensor_type, gpio_num_t pin, uint8_t data[DHT_DATA_BYTES])
+static inline esp_err_t dht_fetch_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
+                                       uint16_t durations[DHT_GPIO_PULSES], dht_diag_event_t *phase)
 {
-    uint32_t low_duration;
-    uint32_t high_duration;
+    uint32_t duration;
+    int n = 0;
 
     // Phase 'A' pulling signal low to initiate read sequence
     gpio_set_direction(pin, GPIO_MODE_OUTPUT_OD);
     gpio_set_level(pin, 0);
-    ets_delay_us(sensor_type == DHT_TYPE_SI7021 ? 500 : 20000);
+    ets_delay_us(dht_start_pulse_us(sensor_type));
     gpio_set_level(pin, 1);
 
     // Step through Phase 'B', 40us
-    CHECK_LOGE(dht_await_pin_state(pin, 40, 0, NULL),
+    *phase = DHT_DIAG_PHASE_B;
+    CHECK_LOGE(dht_await_pin_state(pin, 40, 0, &duration),
                "Initialization error, problem in phase 'B'");
+    durations[n++] = duration;
     // Step through Phase 'C', 88us
-    CHECK_LOGE(dht_await_pin_state(pin, 88, 1, NULL),
+    *phase = DHT_DIAG_PHASE_C;
+    CHECK_LOGE(dht_await_pin_state(pin, 88, 1, &duration),
                "Initialization error, problem in phase 'C'");
+    durations[n++] = duration;
     // Step through Phase 'D', 88us
-    CHECK_LOGE(dht_await_pin_state(pin, 88, 0, NULL),
+    *phase = DHT_DIAG_PHASE_D;
+    CHECK_LOGE(dht_await_pin_state(pin, 88, 0, &duration),
                "Initialization error, problem in phase 'D'");
+    durations[n++] = duration;
 
     // Read in each of the 40 bits of data...
     for (int i = 0; i < DHT_DATA_BITS; i++)
     {
-        CHECK_LOGE(dht_await_pin_state(pin, 65, 1, &low_duration),
+        *phase = DHT_DIAG_BIT_LOW;
+        CHECK_LOGE(dht_await_pin_state(pin, 65, 1, &duration),
                    "LOW bit timeout");
-        CHECK_LOGE(dht_await_pin_state(pin, 75, 0, &high_duration),
+        durations[n++] = duration;
+        *phase = DHT_DIAG_BIT_HIGH;
+        CHECK_LOGE(dht_await_pin_state(pin, 75, 0, &duration),
                    "HIGH bit timeout");
+        durations[n++] = duration;
+    }
+
+    return ESP_OK;
+}
+
+#if CONFIG_DHT_FAST_GPIO
+/**
+ * Busy-wait on the GPIO input register for the pin to reach a state.
+ * Elapsed time is measured with the CPU cycle counter, so call overhead
+ * does not shorten the measured pulses.
+ */
+static inline IRAM_ATTR esp_err_t dht_await_pin_state_fast(uint32_t pin, uint32_t timeout,
+                                                          int expected_pin_state, uint16_t *duration)
+{
+    uint32_t start = esp_cpu_get_cycle_count();
+    uint32_t elapsed;
+
+    do
+    {
+        elapsed = esp_cpu_get_cycle_count() - start;
+        if (gpio_ll_get_level(&GPIO, pin) == expected_pin_state)
+        {
+            *duration = elapsed;
+            return ESP_OK;
+        }
+    } while (elapsed < timeout);
+
+    return ESP_ERR_TIMEOUT;
+}
+
+/**
+ * Same as dht_fetch_data(), run from IRAM with the pin already configured
+ * as open drain with input enabled, and without the start pulse, which the
+ * caller performs before entering the critical section. Durations are
+ * returned in CPU cycles (at most 88 us each, which fits 16 bits).
+ */
+static IRAM_ATTR esp_err_t dht_fetch_data_fast(uint32_t pin, uint32_t cycles_per_us,
+                                               uint16_t durations[DHT_GPIO_PULSES], dht_diag_event_t *phase)
+{
+    int n = 0;
+
+    // End of phase 'A'
+    gpio_ll_set_level(&GPIO, pin, 1);
+
+    *phase = DHT_DIAG_PHASE_B;
+    if (dht_await_pin_state_fast(pin, 40 * cycles_per_us, 0, &durations[n++]) != ESP_OK)
+        return ESP_ERR_TIMEOUT;
+    *phase = DHT_DIAG_PHASE_C;
+    if (dht_await_pin_state_fast(pin, 88 * cycles_per_us, 1, &durations[n++]) != ESP_OK)
+        return ESP_ERR_TIMEOUT;
+    *phase = DHT_DIAG_PHASE_D;
+    if (dht_await_pin_state_fast(pin, 88 * cycles_per_us, 0, &durations[n++]) != ESP_OK)
+        return ESP_ERR_TIMEOUT;
+
+    for (int i = 0; i < DHT_DATA_BITS; i++)
+    {
+        *phase = DHT_DIAG_BIT_LOW;
+        if (dht_await_pin_state_fast(pin, 65 * cycles_per_us, 1, &durations[n++]) != ESP_OK)
+            return ESP_ERR_TIMEOUT;
+        *phase = DHT_DIAG_BIT_HIGH;
+        if (dht_await_pin_state_fast(pin, 75 * cycles_per_us, 0, &durations[n++]) != ESP_OK)
+            return ESP_ERR_TIMEOUT;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t dht_gpio_capture_fast(dht_sensor_type_t sensor_type, gpio_num_t pin,
+                                       uint16_t durations[DHT_GPIO_PULSES], dht_diag_event_t *phase)
+{
+    uint32_t cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+
+    // Direction is set once: the line is driven low and released through
+    // the output register while the input stays readable
+    gpio_set_direction(pin, GPIO_MODE_INPUT_OUTPUT_OD);
+
+    // Phase 'A' pulling signal low to initiate read sequence. The start
+    // pulse runs outside of the critical section; the DHT11 one sleeps
+    // its 20 ms instead of spinning.
+    gpio_set_level(pin, 0);
+    dht_wait_start_pulse(sensor_type, esp_timer_get_time());
+
+    PORT_ENTER_CRITICAL();
+    esp_err_t result = dht_fetch_data_fast(pin, cycles_per_us, durations, phase);
+    PORT_EXIT_CRITICAL();
+
+    gpio_set_direction(pin, GPIO_MODE_OUTPUT_OD);
+    gpio_set_level(pin, 1);
+
+    if (result != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Timeout in %s", dht_diag_event_name(*phase));
+        return result;
+    }
 
-        uint8_t b = i / 8;
-        uint8_t m = i % 8;
-        if (!m)
-            data[b] = 0;
+    for (int i = 0; i < DHT_GPIO_PULSES; i++)
+        durations[i] = (durations[i] + cycles_per_us / 2) / cycles_per_us;
 
-        data[b] |= (high_duration > low_duration) << (7 - m);
+    return ESP_OK;
+}
+#endif // CONFIG_DHT_FAST_GPIO
+
+#if CONFIG_DHT_FAST_GPIO || CONFIG_DHT_USE_RMT
+void dht_wait_start_pulse(dht_sensor_type_t sensor_type, int64_t start_us)
+{
+    const int64_t tick_us = 1000 * portTICK_PERIOD_MS;
+    uint32_t pulse_us = dht_start_pulse_us(sensor_type);
+    int64_t end_us = start_us + pulse_us;
+    int64_t left = end_us - esp_timer_get_time();
+
+    // AM2301 and Si7021 pulses are shorter than a tick and have an upper
+    // bound, so they are still timed with a short busy-wait
+    if (pulse_us < tick_us)
+    {
+        if (left > 0)
+            ets_delay_us(left);
+        return;
+    }
+
+    // The DHT11 only needs a minimum low time: sleep in whole ticks, rounded
+    // up. vTaskDelay(n) may return up to a tick early, so check again.
+    while (left > 0)
+    {
+        vTaskDelay((left + tick_us - 1) / tick_us);
+        left = end_us - esp_timer_get_time();
     }
+}
+#endif
+
+esp_err_t dht_process_pulses(dht_sensor_type_t sensor_type, gpio_num_t pin,
+                             const uint16_t *durations, size_t count, int first_level,
+                             int16_t *humidity, int16_t *temperature)
+{
+    dht_decode_result_t frame;
+
+    switch (dht_decode(durations, count, first_level, &frame))
+    {
+        case DHT_DECODE_OK:
+            dht_diag_record(pin, DHT_DIAG_OK, durations, &frame);
+            break;
+        case DHT_DECODE_BAD_CHECKSUM:
+            dht_diag_record(pin, DHT_DIAG_CRC, durations, &frame);
+            ESP_LOGE(TAG, "Checksum failed, invalid data received from sensor");
+            return ESP_ERR_INVALID_CRC;
+        case DHT_DECODE_BAD_PREAMBLE:
+            dht_diag_record(pin, DHT_DIAG_PREAMBLE, durations, &frame);
+            ESP_LOGE(TAG, "Invalid response preamble (%u/%u)", frame.preamble_low, frame.preamble_high);
+            return ESP_ERR_INVALID_RESPONSE;
+        default:
+            dht_diag_record(pin, DHT_DIAG_TRUNCATED, NULL, NULL);
+            ESP_LOGE(TAG, "Incomplete frame (%u pulses)", (unsigned)count);
+            return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    dht_decode_convert(sensor_type, frame.data, humidity, temperature);
+
+    ESP_LOGD(TAG, "Sensor data: humidity=%d, temp=%d, margin=%u (bit %u)",
+             humidity ? *humidity : 0, temperature ? *temperature : 0,
+             frame.min_margin, frame.weakest_bit);
 
     return ESP_OK;
 }
 
+#if CONFIG_DHT_USE_RMT
+typedef struct
+{
+    gpio_num_t pin;
+    dht_sensor_type_t sensor_type;
+    bool ready;             // false while the channel is being created
+    dht_rmt_handle_t rmt;   // NULL if no channel could be allocated
+} dht_rmt_slot_t;
+
+static portMUX_TYPE rmt_mux = portMUX_INITIALIZER_UNLOCKED;
+static dht_rmt_slot_t rmt_slots[DHT_RMT_MAX_PINS];
+static int rmt_slot_count = 0;
+
 /**
- * Pack two data bytes into single value and take into account sign bit.
+ * Find or lazily create the RMT channel of a pin.
+ * Returns NULL when the pin has to be read by GPIO polling.
  */
-static inline int16_t dht_convert_data(dht_sensor_type_t sensor_type, uint8_t msb, uint8_t lsb)
+static dht_rmt_handle_t dht_rmt_get(dht_sensor_type_t sensor_type, gpio_num_t pin)
 {
-    int16_t data;
+    dht_rmt_slot_t *slot = NULL;
 
-    if (sensor_type == DHT_TYPE_DHT11)
+    portENTER_CRITICAL(&rmt_mux);
+    for (int i = 0; i < rmt_slot_count; i++)
     {
-        data = msb * 10;
+        if (rmt_slots[i].pin == pin)
+        {
+            dht_rmt_handle_t rmt = rmt_slots[i].ready && rmt_slots[i].sensor_type == sensor_type
+                                   ? rmt_slots[i].rmt : NULL;
+            portEXIT_CRITICAL(&rmt_mux);
+            return rmt;
+        }
     }
-    else
+    if (rmt_slot_count < DHT_RMT_MAX_PINS)
     {
-        data = msb & 0x7F;
-        data <<= 8;
-        data |= lsb;
-        if (msb & BIT(7))
-            data = -data;       // convert it to negative
+        slot = &rmt_slots[rmt_slot_count++];
+        slot->pin = pin;
+        slot->sensor_type = sensor_type;
+        slot->ready = false;
+        slot->rmt = NULL;
     }
+    portEXIT_CRITICAL(&rmt_mux);
 
-    return data;
+    if (!slot)
+        return NULL;
+
+    dht_rmt_handle_t rmt = NULL;
+    if (dht_rmt_new(sensor_type, pin, &rmt) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Falling back to GPIO polling on pin %d", pin);
+        rmt = NULL;
+    }
+
+    portENTER_CRITICAL(&rmt_mux);
+    slot->rmt = rmt;
+    slot->ready = true;
+    portEXIT_CRITICAL(&rmt_mux);
+
+    return rmt;
 }
+#endif
 
-esp_err_t dht_read_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
-                        int16_t *humidity, int16_t *temperature)
+esp_err_t dht_gpio_read_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
+                             int16_t *humidity, int16_t *temperature)
 {
-    CHECK_ARG(humidity || temperature);
-
-    uint8_t data[DHT_DATA_BYTES] = { 0 };
+    uint16_t durations[DHT_GPIO_PULSES];
+    dht_diag_event_t phase = DHT_DIAG_OK;
 
+#if CONFIG_DHT_FAST_GPIO
+    esp_err_t result = dht_gpio_capture_fast(sensor_type, pin, durations, &phase);
+#else
     gpio_set_direction(pin, GPIO_MODE_OUTPUT_OD);
     gpio_set_level(pin, 1);
 
     PORT_ENTER_CRITICAL();
-    esp_err_t result = dht_fetch_data(sensor_type, pin, data);
+    esp_err_t result = dht_fetch_data(sensor_type, pin, durations, &phase);
     if (result == ESP_OK)
         PORT_EXIT_CRITICAL();
 
@@ -219,24 +441,30 @@ esp_err_t dht_read_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
      * GPIO direction mode changes */
     gpio_set_direction(pin, GPIO_MODE_OUTPUT_OD);
     gpio_set_level(pin, 1);
+#endif
 
     if (result != ESP_OK)
-        return result;
-
-    if (data[4] != ((data[0] + data[1] + data[2] + data[3]) & 0xFF))
     {
-        ESP_LOGE(TAG, "Checksum failed, invalid data received from sensor");
-        return ESP_ERR_INVALID_CRC;
+        dht_diag_record(pin, phase, NULL, NULL);
+        return result;
     }
 
-    if (humidity)
-        *humidity = dht_convert_data(sensor_type, data[0], data[1]);
-    if (temperature)
-        *temperature = dht_convert_data(sensor_type, data[2], data[3]);
+    // Decode outside of the critical section
+    return dht_process_pulses(sensor_type, pin, durations, DHT_GPIO_PULSES, 1, humidity, temperature);
+}
+
+esp_err_t dht_read_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
+                        int16_t *humidity, int16_t *temperature)
+{
+    CHECK_ARG(humidity || temperature);
 
-    ESP_LOGD(TAG, "Sensor data: humidity=%d, temp=%d", *humidity, *temperature);
+#if CONFIG_DHT_USE_RMT
+    dht_rmt_handle_t rmt = dht_rmt_get(sensor_type, pin);
+    if (rmt)
+        return dht_rmt_read(rmt, humidity, temperature);
+#endif
 
-    return ESP_OK;
+    return dht_gpio_read_data(sensor_type, pin, humidity, temperature);
 }
 
 esp_err_t dht_read_float_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
@@ -48,21 +48,12 @@
 
 #include <driver/gpio.h>
 #include <esp_err.h>
+#include "dht_decode.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/**
- * Sensor type
- */
-typedef enum
-{
-    DHT_TYPE_DHT11 = 0,   //!< DHT11
-    DHT_TYPE_AM2301,      //!< AM2301 (DHT21, DHT22, AM2302, AM2321)
-    DHT_TYPE_SI7021       //!< Itead Si7021
-} dht_sensor_type_t;
-
 /**
  * @brief Read integer data from sensor on specified pin
  *
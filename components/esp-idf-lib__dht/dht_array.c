@@ -0,0 +1,274 @@
+/**
+ * @file dht_array.c
+ *
+ * Scheduler for several DHT sensors on separate GPIOs
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+#include "dht_array.h"
+#include "dht_priv.h"
+
+#include <stdlib.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+#include <esp_log.h>
+
+#if CONFIG_DHT_USE_RMT
+#include "dht_rmt.h"
+
+// Capture of one frame takes ~5 ms after release
+#define DHT_ARRAY_WAIT_MS 20
+#endif
+
+static const char *TAG = "dht_array";
+
+typedef struct
+{
+    dht_sensor_type_t sensor_type;
+    gpio_num_t pin;
+    int64_t min_interval;   // us
+    int64_t last_start;     // us, 0 if never read
+#if CONFIG_DHT_USE_RMT
+    dht_rmt_handle_t rmt;
+#endif
+    dht_array_value_t value;
+} dht_array_sensor_t;
+
+struct dht_array_s
+{
+    portMUX_TYPE lock;      // protects value tables
+    int count;
+#if CONFIG_DHT_USE_RMT
+    // More sensors than RMT channels: allocate channels per batch
+    bool rotating;
+#endif
+    dht_array_sensor_t sensors[DHT_ARRAY_MAX_SENSORS];
+};
+
+static uint32_t dht_default_interval_ms(dht_sensor_type_t sensor_type)
+{
+    return sensor_type == DHT_TYPE_AM2301 ? 2000 : 1000;
+}
+
+static void dht_array_store(dht_array_handle_t array, dht_array_sensor_t *s, esp_err_t res,
+                            int16_t humidity, int16_t temperature)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&array->lock);
+    s->value.status = res;
+    s->value.reads++;
+    if (res == ESP_OK)
+    {
+        s->value.humidity = humidity;
+        s->value.temperature = temperature;
+        s->value.timestamp = now;
+    }
+    else
+        s->value.errors++;
+    portEXIT_CRITICAL(&array->lock);
+}
+
+#if CONFIG_DHT_USE_RMT
+static void dht_array_release_channels(dht_array_handle_t array)
+{
+    for (int i = 0; i < array->count; i++)
+    {
+        if (array->sensors[i].rmt)
+        {
+            dht_rmt_del(array->sensors[i].rmt);
+            array->sensors[i].rmt = NULL;
+        }
+    }
+}
+
+/**
+ * Read a batch of sensors that all have an RMT channel.
+ * All start pulses begin together; dht_rmt_arm() sleeps once for the
+ * first sensor and releases the others right after it.
+ */
+static void dht_array_read_batch(dht_array_handle_t array, dht_array_sensor_t **batch, int n)
+{
+    esp_err_t res[DHT_ARRAY_MAX_SENSORS];
+
+    for (int i = 0; i < n; i++)
+    {
+        batch[i]->last_start = esp_timer_get_time();
+        res[i] = dht_rmt_start(batch[i]->rmt);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        if (res[i] == ESP_OK)
+            res[i] = dht_rmt_arm(batch[i]->rmt);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        int16_t humidity = 0, temperature = 0;
+        if (res[i] == ESP_OK)
+            res[i] = dht_rmt_wait(batch[i]->rmt, pdMS_TO_TICKS(DHT_ARRAY_WAIT_MS) + 1,
+                                  &humidity, &temperature);
+        dht_array_store(array, batch[i], res[i], humidity, temperature);
+    }
+}
+#endif
+
+static void dht_array_read_gpio(dht_array_handle_t array, dht_array_sensor_t *s)
+{
+    int16_t humidity = 0, temperature = 0;
+
+    s->last_start = esp_timer_get_time();
+    esp_err_t res = dht_gpio_read_data(s->sensor_type, s->pin, &humidity, &temperature);
+    dht_array_store(array, s, res, humidity, temperature);
+}
+
+esp_err_t dht_array_new(dht_array_handle_t *array)
+{
+    CHECK_ARG(array);
+
+    dht_array_handle_t a = calloc(1, sizeof(*a));
+    if (!a)
+        return ESP_ERR_NO_MEM;
+    portMUX_INITIALIZE(&a->lock);
+
+    *array = a;
+    return ESP_OK;
+}
+
+esp_err_t dht_array_del(dht_array_handle_t array)
+{
+    CHECK_ARG(array);
+
+#if CONFIG_DHT_USE_RMT
+    dht_array_release_channels(array);
+#endif
+    free(array);
+
+    return ESP_OK;
+}
+
+esp_err_t dht_array_add(dht_array_handle_t array, dht_sensor_type_t sensor_type, gpio_num_t pin,
+                        uint32_t min_interval_ms, int *index)
+{
+    CHECK_ARG(array);
+
+    if (array->count == DHT_ARRAY_MAX_SENSORS)
+        return ESP_ERR_NO_MEM;
+
+    dht_array_sensor_t *s = &array->sensors[array->count];
+    s->sensor_type = sensor_type;
+    s->pin = pin;
+    s->min_interval = (int64_t)(min_interval_ms ? min_interval_ms : dht_default_interval_ms(sensor_type)) * 1000;
+    s->last_start = 0;
+    s->value.status = ESP_ERR_INVALID_STATE;
+
+    gpio_set_direction(pin, GPIO_MODE_OUTPUT_OD);
+    gpio_set_level(pin, 1);
+
+#if CONFIG_DHT_USE_RMT
+    s->rmt = NULL;
+    if (!array->rotating && dht_rmt_new(sensor_type, pin, &s->rmt) != ESP_OK)
+    {
+        ESP_LOGI(TAG, "Out of RMT channels, sharing them between batches");
+        array->rotating = true;
+        dht_array_release_channels(array);
+    }
+#endif
+
+    if (index)
+        *index = array->count;
+    array->count++;
+
+    return ESP_OK;
+}
+
+esp_err_t dht_array_scan(dht_array_handle_t array, uint32_t *next_ms)
+{
+    CHECK_ARG(array);
+
+    dht_array_sensor_t *due[DHT_ARRAY_MAX_SENSORS];
+    int n_due = 0;
+    int64_t now = esp_timer_get_time();
+
+    for (int i = 0; i < array->count; i++)
+    {
+        dht_array_sensor_t *s = &array->sensors[i];
+        if (!s->last_start || now - s->last_start >= s->min_interval)
+            due[n_due++] = s;
+    }
+
+#if CONFIG_DHT_USE_RMT
+    int i = 0;
+    while (i < n_due)
+    {
+        dht_array_sensor_t *batch[DHT_ARRAY_MAX_SENSORS];
+        int n = 0;
+
+        while (i < n_due)
+        {
+            dht_array_sensor_t *s = due[i];
+            if (!s->rmt && dht_rmt_new(s->sensor_type, s->pin, &s->rmt) != ESP_OK)
+            {
+                s->rmt = NULL;
+                // Channels are busy with this batch; retry after it
+                if (n)
+                    break;
+                // A persistent failure would log on every scan: warn once,
+                // then only count
+                portENTER_CRITICAL(&array->lock);
+                bool first = s->value.gpio_reads++ == 0;
+                portEXIT_CRITICAL(&array->lock);
+                if (first)
+                    ESP_LOGW(TAG, "No RMT channel for GPIO %d, falling back to GPIO polling", s->pin);
+                dht_array_read_gpio(array, s);
+                i++;
+                continue;
+            }
+            batch[n++] = s;
+            i++;
+        }
+        if (n)
+        {
+            dht_array_read_batch(array, batch, n);
+            ESP_LOGD(TAG, "Batch of %d sensors read", n);
+        }
+        if (array->rotating)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                dht_rmt_del(batch[j]->rmt);
+                batch[j]->rmt = NULL;
+            }
+        }
+    }
+#else
+    for (int i = 0; i < n_due; i++)
+        dht_array_read_gpio(array, due[i]);
+#endif
+
+    if (next_ms)
+    {
+        now = esp_timer_get_time();
+        int64_t next = INT64_MAX;
+        for (int i = 0; i < array->count; i++)
+        {
+            dht_array_sensor_t *s = &array->sensors[i];
+            int64_t left = s->last_start + s->min_interval - now;
+            if (left < next)
+                next = left;
+        }
+        *next_ms = next == INT64_MAX || next <= 0 ? 0 : (uint32_t)((next + 999) / 1000);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t dht_array_get(dht_array_handle_t array, int index, dht_array_value_t *value)
+{
+    CHECK_ARG(array && value && index >= 0 && index < array->count);
+
+    portENTER_CRITICAL(&array->lock);
+    *value = array->sensors[index].value;
+    portEXIT_CRITICAL(&array->lock);
+
+    return ESP_OK;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file dht_array.h
+ * @defgroup dht_array dht_array
+ * @{
+ *
+ * Scheduler for several DHT sensors on separate GPIOs
+ *
+ * Sensors are read in batches: the start pulses of a batch run at the same
+ * time and the sensors are released one after another, so the responses
+ * are captured concurrently by the RMT receivers. A batch of N sensors
+ * takes about as long as a single read (~25 ms). Sensors that cannot get
+ * an RMT channel are read one at a time by GPIO polling.
+ *
+ * If there are more sensors than RMT RX channels, channels are created for
+ * each batch and released afterwards.
+ *
+ * Each sensor is read at most once per its minimum interval; the latest
+ * values are kept in a table that can be queried from any task.
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+#ifndef __DHT_ARRAY_H__
+#define __DHT_ARRAY_H__
+
+#include <stdint.h>
+#include "dht.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DHT_ARRAY_MAX_SENSORS 8
+
+/**
+ * Sensor array handle
+ */
+typedef struct dht_array_s *dht_array_handle_t;
+
+/**
+ * Latest state of a sensor
+ */
+typedef struct
+{
+    int16_t humidity;       //!< Humidity, percents * 10, of the last good read
+    int16_t temperature;    //!< Temperature, degrees Celsius * 10, of the last good read
+    int64_t timestamp;      //!< esp_timer time of the last good read, 0 if none yet
+    esp_err_t status;       //!< Result of the last read attempt
+    uint32_t reads;         //!< Read attempts
+    uint32_t errors;        //!< Failed read attempts
+    uint32_t gpio_reads;    //!< Reads done by GPIO polling because no RMT channel could be allocated
+} dht_array_value_t;
+
+/**
+ * @brief Create an empty sensor array
+ *
+ * @param[out] array Created array
+ * @return `ESP_OK` on success
+ */
+esp_err_t dht_array_new(dht_array_handle_t *array);
+
+/**
+ * @brief Delete a sensor array and release its RMT channels
+ *
+ * @param array Array handle
+ * @return `ESP_OK` on success
+ */
+esp_err_t dht_array_del(dht_array_handle_t array);
+
+/**
+ * @brief Register a sensor
+ *
+ * @param array Array handle
+ * @param sensor_type Sensor type
+ * @param pin GPIO pin connected to sensor OUT
+ * @param min_interval_ms Minimum time between two reads, 0 for the sensor
+ *                        type default (1 s for DHT11 and Si7021, 2 s for AM2301)
+ * @param[out] index Index of the sensor in the value table, nullable
+ * @return `ESP_OK` on success, `ESP_ERR_NO_MEM` if the array is full
+ */
+esp_err_t dht_array_add(dht_array_handle_t array, dht_sensor_type_t sensor_type, gpio_num_t pin,
+                        uint32_t min_interval_ms, int *index);
+
+/**
+ * @brief Read every sensor whose minimum interval has elapsed
+ *
+ * Blocks for the duration of the acquisition, about 25 ms per batch.
+ *
+ * @param array Array handle
+ * @param[out] next_ms Time until the next sensor is due, nullable
+ * @return `ESP_OK` on success, even if some sensors failed; see
+ *         dht_array_get() for per-sensor status
+ */
+esp_err_t dht_array_scan(dht_array_handle_t array, uint32_t *next_ms);
+
+/**
+ * @brief Get the latest state of a sensor
+ *
+ * @param array Array handle
+ * @param index Sensor index returned by dht_array_add()
+ * @param[out] value Latest state
+ * @return `ESP_OK` on success
+ */
+esp_err_t dht_array_get(dht_array_handle_t array, int index, dht_array_value_t *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif  // __DHT_ARRAY_H__
@@ -0,0 +1,138 @@
+/**
+ * @file dht_decode.c
+ *
+ * Waveform decoder for DHT11, AM2301 (DHT21, DHT22, AM2302, AM2321),
+ * Itead Si7021
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+#include "dht_decode.h"
+
+#include <string.h>
+
+/*
+ *  Nominal timings, us:
+ *
+ *  Phase C (response low)   80
+ *  Phase D (response high)  80
+ *  Bit low                  50
+ *  Bit high                 26-28 for '0', 70 for '1'
+ *
+ *  The sensors run from an RC oscillator and the capture tick is not always
+ *  1 us, so the '0'/'1' threshold is scaled from the measured preamble:
+ *  (C + D) * 3 / 10 is 48 at nominal timing, halfway between both bit
+ *  lengths. The preamble itself is checked against the mean bit low.
+ */
+
+static inline int8_t saturate_i8(int v)
+{
+    return v > INT8_MAX ? INT8_MAX : v < INT8_MIN ? INT8_MIN : v;
+}
+
+static inline int preamble_ok(uint32_t pulse, uint32_t bit_low)
+{
+    // Nominal ratio is 1.6
+    return pulse * 4 > bit_low * 5 && pulse < bit_low * 3;
+}
+
+dht_decode_status_t dht_decode(const uint16_t *durations, size_t count, int first_level,
+                               dht_decode_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+
+    // Drop the trailing low that ends the frame, if captured
+    size_t end = count;
+    if (end && ((first_level ^ (end - 1)) & 1) == 0)
+        end--;
+
+    // durations[end - 1] is now the high of the last bit; count the complete
+    // low/high pairs that precede it
+    size_t pairs = end / 2;
+    if (pairs < DHT_DATA_BITS)
+    {
+        result->status = DHT_DECODE_TRUNCATED;
+        return result->status;
+    }
+
+    result->bits_offset = end - DHT_DATA_BITS * 2;
+    const uint16_t *bits = &durations[result->bits_offset];
+
+    uint32_t low_sum = 0;
+    for (int i = 0; i < DHT_DATA_BITS; i++)
+        low_sum += bits[i * 2];
+    uint32_t bit_low = low_sum / DHT_DATA_BITS;
+
+    int preamble = 0;
+    if (pairs > DHT_DATA_BITS)
+    {
+        result->preamble_low = bits[-2];
+        result->preamble_high = bits[-1];
+        preamble = preamble_ok(result->preamble_low, bit_low)
+                   && preamble_ok(result->preamble_high, bit_low);
+    }
+    // Without a usable preamble fall back to the mean bit low, which also
+    // sits between both bit lengths
+    uint32_t threshold = preamble
+                         ? (result->preamble_low + result->preamble_high) * 3 / 10
+                         : bit_low;
+    result->threshold = threshold;
+
+    result->min_margin = UINT8_MAX;
+    for (int i = 0; i < DHT_DATA_BITS; i++)
+    {
+        uint16_t high = bits[i * 2 + 1];
+        int margin = (int)high - (int)threshold;
+
+        result->data[i / 8] |= (margin > 0) << (7 - i % 8);
+        result->margin[i] = saturate_i8(margin);
+
+        int abs_margin = margin < 0 ? -margin : margin;
+        if (abs_margin < result->min_margin)
+        {
+            result->min_margin = abs_margin;
+            result->weakest_bit = i;
+        }
+    }
+
+    const uint8_t *d = result->data;
+    if (!preamble)
+        result->status = DHT_DECODE_BAD_PREAMBLE;
+    else if (d[4] != ((d[0] + d[1] + d[2] + d[3]) & 0xFF))
+        result->status = DHT_DECODE_BAD_CHECKSUM;
+    else
+        result->status = DHT_DECODE_OK;
+
+    return result->status;
+}
+
+/**
+ * Pack two data bytes into single value and take into account sign bit.
+ */
+static inline int16_t dht_convert_data(dht_sensor_type_t sensor_type, uint8_t msb, uint8_t lsb)
+{
+    int16_t data;
+
+    if (sensor_type == DHT_TYPE_DHT11)
+    {
+        data = msb * 10;
+    }
+    else
+    {
+        data = msb & 0x7F;
+        data <<= 8;
+        data |= lsb;
+        if (msb & 0x80)
+            data = -data;       // convert it to negative
+    }
+
+    return data;
+}
+
+void dht_decode_convert(dht_sensor_type_t sensor_type, const uint8_t data[DHT_DATA_BYTES],
+                        int16_t *humidity, int16_t *temperature)
+{
+    if (humidity)
+        *humidity = dht_convert_data(sensor_type, data[0], data[1]);
+    if (temperature)
+        *temperature = dht_convert_data(sensor_type, data[2], data[3]);
+}
@@ -0,0 +1,103 @@
+/**
+ * @file dht_decode.h
+ * @defgroup dht_decode dht_decode
+ * @{
+ *
+ * Waveform decoder for DHT11, AM2301 (DHT21, DHT22, AM2302, AM2321),
+ * Itead Si7021
+ *
+ * Turns a list of measured pulse durations into the 5 data bytes. It does
+ * not touch any hardware and depends only on the C library, so the same
+ * code serves every capture backend and can be built and run on a host.
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+#ifndef __DHT_DECODE_H__
+#define __DHT_DECODE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DHT_DATA_BITS 40
+#define DHT_DATA_BYTES (DHT_DATA_BITS / 8)
+
+/**
+ * Sensor type
+ */
+typedef enum
+{
+    DHT_TYPE_DHT11 = 0,   //!< DHT11
+    DHT_TYPE_AM2301,      //!< AM2301 (DHT21, DHT22, AM2302, AM2321)
+    DHT_TYPE_SI7021       //!< Itead Si7021
+} dht_sensor_type_t;
+
+/**
+ * Decoding status
+ */
+typedef enum
+{
+    DHT_DECODE_OK = 0,        //!< Frame decoded and checksum matches
+    DHT_DECODE_BAD_CHECKSUM,  //!< 40 bits decoded, checksum does not match
+    DHT_DECODE_BAD_PREAMBLE,  //!< 40 bits decoded, response preamble missing or out of range
+    DHT_DECODE_TRUNCATED,     //!< Fewer than 40 bits in the capture
+} dht_decode_status_t;
+
+/**
+ * Decoding result
+ */
+typedef struct
+{
+    dht_decode_status_t status;
+    uint8_t data[DHT_DATA_BYTES];   //!< Raw frame, valid unless truncated
+    uint16_t threshold;             //!< High pulse length separating '0' from '1'
+    uint16_t preamble_low;          //!< Sensor response low (phase 'C'), 0 if missing
+    uint16_t preamble_high;         //!< Sensor response high (phase 'D'), 0 if missing
+    int8_t margin[DHT_DATA_BITS];   //!< High pulse minus threshold, per bit, saturated
+    uint8_t min_margin;             //!< Smallest absolute margin
+    uint8_t weakest_bit;            //!< Bit with the smallest margin
+    uint16_t bits_offset;           //!< Index in the input of the first bit low
+} dht_decode_result_t;
+
+/**
+ * @brief Decode a captured response
+ *
+ * `durations` holds consecutive pulse lengths of alternating line level,
+ * the first one at level `first_level`. Units only have to be consistent:
+ * thresholds are derived from the sensor response preamble, so polling
+ * loops whose tick is not exactly 1 us decode as well as an RMT capture.
+ *
+ * The frame is anchored at its end: the last 40 complete low/high pairs
+ * are the data bits and the pair before them is the preamble. Pulses
+ * captured before the preamble are ignored.
+ *
+ * @param durations Pulse lengths
+ * @param count Number of pulse lengths
+ * @param first_level Line level of `durations[0]`, 0 or 1
+ * @param[out] result Decoded frame and timing margins
+ * @return `result->status`
+ */
+dht_decode_status_t dht_decode(const uint16_t *durations, size_t count, int first_level,
+                               dht_decode_result_t *result);
+
+/**
+ * @brief Convert a raw frame to humidity and temperature
+ *
+ * @param sensor_type Sensor type
+ * @param data Raw frame
+ * @param[out] humidity Humidity, percents * 10, nullable
+ * @param[out] temperature Temperature, degrees Celsius * 10, nullable
+ */
+void dht_decode_convert(dht_sensor_type_t sensor_type, const uint8_t data[DHT_DATA_BYTES],
+                        int16_t *humidity, int16_t *temperature);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif  // __DHT_DECODE_H__
@@ -0,0 +1,155 @@
+/**
+ * @file dht_diag.c
+ *
+ * Read diagnostics for DHT sensors
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+#include "dht_diag.h"
+#include "dht_priv.h"
+
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+
+static const char *const event_names[DHT_DIAG_MAX] = {
+    [DHT_DIAG_OK] = "ok",
+    [DHT_DIAG_PHASE_B] = "phase_b",
+    [DHT_DIAG_PHASE_C] = "phase_c",
+    [DHT_DIAG_PHASE_D] = "phase_d",
+    [DHT_DIAG_BIT_LOW] = "bit_low",
+    [DHT_DIAG_BIT_HIGH] = "bit_high",
+    [DHT_DIAG_PREAMBLE] = "preamble",
+    [DHT_DIAG_TRUNCATED] = "truncated",
+    [DHT_DIAG_CRC] = "crc",
+};
+
+const char *dht_diag_event_name(dht_diag_event_t event)
+{
+    return event < DHT_DIAG_MAX ? event_names[event] : "unknown";
+}
+
+#if CONFIG_DHT_DIAGNOSTICS
+
+static portMUX_TYPE diag_mux = portMUX_INITIALIZER_UNLOCKED;
+static dht_diag_t diag_table[DHT_DIAG_MAX_PINS];
+static int diag_count = 0;
+
+// Must be called with diag_mux held
+static dht_diag_t *dht_diag_find(gpio_num_t pin, bool create)
+{
+    for (int i = 0; i < diag_count; i++)
+        if (diag_table[i].pin == pin)
+            return &diag_table[i];
+    if (!create || diag_count == DHT_DIAG_MAX_PINS)
+        return NULL;
+
+    dht_diag_t *d = &diag_table[diag_count++];
+    memset(d, 0, sizeof(*d));
+    d->pin = pin;
+    d->worst_margin = UINT8_MAX;
+    return d;
+}
+
+static inline int dht_diag_bucket(uint16_t duration)
+{
+    int b = duration / DHT_DIAG_BUCKET_US;
+    return b < DHT_DIAG_BUCKETS ? b : DHT_DIAG_BUCKETS - 1;
+}
+
+void dht_diag_record(gpio_num_t pin, dht_diag_event_t event, const uint16_t *durations,
+                     const dht_decode_result_t *frame)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&diag_mux);
+    dht_diag_t *d = dht_diag_find(pin, true);
+    if (d)
+    {
+        d->count[event]++;
+        if (event != DHT_DIAG_OK)
+            d->last_failure = now;
+        if (frame && frame->status != DHT_DECODE_TRUNCATED)
+        {
+            const uint16_t *bits = &durations[frame->bits_offset];
+            for (int i = 0; i < DHT_DATA_BITS; i++)
+            {
+                d->low_hist[dht_diag_bucket(bits[i * 2])]++;
+                d->high_hist[dht_diag_bucket(bits[i * 2 + 1])]++;
+            }
+            d->last_margin = frame->min_margin;
+            if (event == DHT_DIAG_OK && frame->min_margin < d->worst_margin)
+                d->worst_margin = frame->min_margin;
+        }
+    }
+    portEXIT_CRITICAL(&diag_mux);
+}
+
+esp_err_t dht_diag_get(gpio_num_t pin, dht_diag_t *diag)
+{
+    CHECK_ARG(diag);
+
+    esp_err_t res = ESP_ERR_NOT_FOUND;
+    portENTER_CRITICAL(&diag_mux);
+    dht_diag_t *d = dht_diag_find(pin, false);
+    if (d)
+    {
+        *diag = *d;
+        res = ESP_OK;
+    }
+    portEXIT_CRITICAL(&diag_mux);
+
+    return res;
+}
+
+esp_err_t dht_diag_get_index(int index, dht_diag_t *diag)
+{
+    CHECK_ARG(diag && index >= 0);
+
+    esp_err_t res = ESP_ERR_NOT_FOUND;
+    portENTER_CRITICAL(&diag_mux);
+    if (index < diag_count)
+    {
+        *diag = diag_table[index];
+        res = ESP_OK;
+    }
+    portEXIT_CRITICAL(&diag_mux);
+
+    return res;
+}
+
+esp_err_t dht_diag_reset(gpio_num_t pin)
+{
+    esp_err_t res = ESP_ERR_NOT_FOUND;
+    portENTER_CRITICAL(&diag_mux);
+    dht_diag_t *d = dht_diag_find(pin, false);
+    if (d)
+    {
+        memset(d, 0, sizeof(*d));
+        d->pin = pin;
+        d->worst_margin = UINT8_MAX;
+        res = ESP_OK;
+    }
+    portEXIT_CRITICAL(&diag_mux);
+
+    return res;
+}
+
+#else
+
+esp_err_t dht_diag_get(gpio_num_t pin, dht_diag_t *diag)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t dht_diag_get_index(int index, dht_diag_t *diag)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t dht_diag_reset(gpio_num_t pin)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_DHT_DIAGNOSTICS
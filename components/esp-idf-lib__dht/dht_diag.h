@@ -0,0 +1,98 @@
+/**
+ * @file dht_diag.h
+ * @defgroup dht_diag dht_diag
+ * @{
+ *
+ * Read diagnostics for DHT sensors
+ *
+ * Every read, whatever the capture backend, is accounted per pin: failures
+ * by protocol phase, histograms of the measured data bit pulse lengths and
+ * the decision margin of the weakest bit. Enabled with
+ * CONFIG_DHT_DIAGNOSTICS.
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+#ifndef __DHT_DIAG_H__
+#define __DHT_DIAG_H__
+
+#include <stdint.h>
+#include "dht.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DHT_DIAG_MAX_PINS 8
+#define DHT_DIAG_BUCKETS 16
+// Histogram bucket width, us; the last bucket also counts longer pulses
+#define DHT_DIAG_BUCKET_US 8
+
+/**
+ * Read outcome
+ */
+typedef enum
+{
+    DHT_DIAG_OK = 0,        //!< Successful read
+    DHT_DIAG_PHASE_B,       //!< Sensor did not pull the line low after start
+    DHT_DIAG_PHASE_C,       //!< Response low too long
+    DHT_DIAG_PHASE_D,       //!< Response high too long
+    DHT_DIAG_BIT_LOW,       //!< Data bit low too long
+    DHT_DIAG_BIT_HIGH,      //!< Data bit high too long
+    DHT_DIAG_PREAMBLE,      //!< Response preamble out of range
+    DHT_DIAG_TRUNCATED,     //!< Fewer than 40 bits captured
+    DHT_DIAG_CRC,           //!< Checksum mismatch
+    DHT_DIAG_MAX
+} dht_diag_event_t;
+
+/**
+ * Diagnostics of one sensor pin
+ */
+typedef struct
+{
+    gpio_num_t pin;
+    uint32_t count[DHT_DIAG_MAX];           //!< Reads by outcome
+    uint32_t low_hist[DHT_DIAG_BUCKETS];    //!< Data bit low lengths
+    uint32_t high_hist[DHT_DIAG_BUCKETS];   //!< Data bit high lengths
+    uint8_t last_margin;                    //!< Weakest bit margin of the last decoded frame
+    uint8_t worst_margin;                   //!< Smallest margin seen on a good read
+    int64_t last_failure;                   //!< esp_timer time of the last failure, 0 if none
+} dht_diag_t;
+
+/**
+ * @brief Name of a read outcome, e.g. "phase_b"
+ */
+const char *dht_diag_event_name(dht_diag_event_t event);
+
+/**
+ * @brief Get the diagnostics of a pin
+ *
+ * @param pin Sensor GPIO
+ * @param[out] diag Copy of the counters
+ * @return `ESP_OK` on success, `ESP_ERR_NOT_FOUND` if the pin was never read
+ */
+esp_err_t dht_diag_get(gpio_num_t pin, dht_diag_t *diag);
+
+/**
+ * @brief Get the diagnostics of the n-th pin that has been read
+ *
+ * @param index 0 to DHT_DIAG_MAX_PINS - 1
+ * @param[out] diag Copy of the counters
+ * @return `ESP_OK` on success, `ESP_ERR_NOT_FOUND` past the last pin
+ */
+esp_err_t dht_diag_get_index(int index, dht_diag_t *diag);
+
+/**
+ * @brief Clear the counters of a pin
+ *
+ * @param pin Sensor GPIO
+ * @return `ESP_OK` on success, `ESP_ERR_NOT_FOUND` if the pin was never read
+ */
+esp_err_t dht_diag_reset(gpio_num_t pin);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif  // __DHT_DIAG_H__
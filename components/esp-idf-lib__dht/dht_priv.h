@@ -0,0 +1,69 @@
+/**
+ * @file dht_priv.h
+ *
+ * Internals shared by the DHT read backends
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+#ifndef __DHT_PRIV_H__
+#define __DHT_PRIV_H__
+
+#include "dht.h"
+#include "dht_diag.h"
+
+#define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
+
+/**
+ * Length of the phase 'A' start pulse, in microseconds. DHT11 needs at
+ * least 18 ms; AM2301 0.8 ms and a longer one only delays the response.
+ */
+static inline uint32_t dht_start_pulse_us(dht_sensor_type_t sensor_type)
+{
+    switch (sensor_type)
+    {
+        case DHT_TYPE_DHT11:
+            return 20000;
+        case DHT_TYPE_AM2301:
+            return 1000;
+        default:
+            return 500;
+    }
+}
+
+/**
+ * Wait until the start pulse begun at `start_us` (esp_timer time) is long
+ * enough. Pulses of a tick or more (DHT11) are slept in whole ticks and may
+ * run up to a tick long; shorter ones are busy-waited.
+ */
+void dht_wait_start_pulse(dht_sensor_type_t sensor_type, int64_t start_us);
+
+/**
+ * Decode a captured response and convert it to humidity and temperature.
+ * Decoder statuses are mapped to `ESP_ERR_INVALID_RESPONSE` (truncated
+ * frame or bad preamble) and `ESP_ERR_INVALID_CRC`.
+ */
+esp_err_t dht_process_pulses(dht_sensor_type_t sensor_type, gpio_num_t pin,
+                             const uint16_t *durations, size_t count, int first_level,
+                             int16_t *humidity, int16_t *temperature);
+
+/**
+ * Read a sensor by polling its GPIO inside a critical section.
+ */
+esp_err_t dht_gpio_read_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
+                             int16_t *humidity, int16_t *temperature);
+
+/**
+ * Account a read outcome. `durations` and `frame` are NULL when the capture
+ * failed before decoding.
+ */
+#if CONFIG_DHT_DIAGNOSTICS
+void dht_diag_record(gpio_num_t pin, dht_diag_event_t event, const uint16_t *durations,
+                     const dht_decode_result_t *frame);
+#else
+static inline void dht_diag_record(gpio_num_t pin, dht_diag_event_t event, const uint16_t *durations,
+                                   const dht_decode_result_t *frame)
+{
+}
+#endif
+
+#endif  // __DHT_PRIV_H__
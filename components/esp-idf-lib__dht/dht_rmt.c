@@ -0,0 +1,215 @@
+/**
+ * @file dht_rmt.c
+ *
+ * RMT capture backend for DHT11, AM2301 (DHT21, DHT22, AM2302, AM2321),
+ * Itead Si7021
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+#include <sdkconfig.h>
+
+#if CONFIG_DHT_USE_RMT
+
+#include "dht_rmt.h"
+#include "dht_priv.h"
+
+#include <stdlib.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <driver/rmt_rx.h>
+#include <soc/soc_caps.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <esp_log.h>
+
+// 1 tick = 1 us
+#define DHT_RMT_RESOLUTION_HZ 1000000
+// Longest pulse of a valid frame is ~90 us; a longer idle ends the capture
+#define DHT_RMT_IDLE_NS 200000
+// Shorter pulses are glitches
+#define DHT_RMT_GLITCH_NS 1000
+// Response, 40 bits and the trailing low: 43 symbols
+#define DHT_RMT_SYMBOLS SOC_RMT_MEM_WORDS_PER_CHANNEL
+// A full frame takes ~5 ms
+#define DHT_RMT_FRAME_TIMEOUT_MS 20
+
+static const char *TAG = "dht_rmt";
+
+struct dht_rmt_s
+{
+    dht_sensor_type_t sensor_type;
+    gpio_num_t pin;
+    rmt_channel_handle_t channel;
+    QueueHandle_t done;
+    int64_t start_us;
+    rmt_symbol_word_t symbols[DHT_RMT_SYMBOLS];
+};
+
+static bool IRAM_ATTR dht_rmt_on_recv_done(rmt_channel_handle_t channel,
+                                           const rmt_rx_done_event_data_t *edata, void *user_ctx)
+{
+    BaseType_t woken = pdFALSE;
+    xQueueSendFromISR((QueueHandle_t)user_ctx, edata, &woken);
+    return woken == pdTRUE;
+}
+
+/**
+ * Flatten RMT symbols into alternating pulse lengths for the decoder,
+ * merging neighbours of the same level. Returns the number of pulses.
+ */
+static size_t dht_rmt_flatten(const rmt_symbol_word_t *symbols, size_t count,
+                              uint16_t *durations, int *first_level)
+{
+    size_t n = 0;
+    int level = -1;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint16_t dur[2] = { symbols[i].duration0, symbols[i].duration1 };
+        int lvl[2] = { symbols[i].level0, symbols[i].level1 };
+        for (int h = 0; h < 2; h++)
+        {
+            if (!dur[h])
+                return n;
+            if (lvl[h] == level)
+                durations[n - 1] += dur[h];
+            else
+            {
+                if (!n)
+                    *first_level = lvl[h];
+                durations[n++] = dur[h];
+                level = lvl[h];
+            }
+        }
+    }
+
+    return n;
+}
+
+esp_err_t dht_rmt_new(dht_sensor_type_t sensor_type, gpio_num_t pin, dht_rmt_handle_t *handle)
+{
+    CHECK_ARG(handle);
+
+    dht_rmt_handle_t h = calloc(1, sizeof(*h));
+    if (!h)
+        return ESP_ERR_NO_MEM;
+    h->sensor_type = sensor_type;
+    h->pin = pin;
+
+    h->done = xQueueCreate(1, sizeof(rmt_rx_done_event_data_t));
+    if (!h->done)
+    {
+        free(h);
+        return ESP_ERR_NO_MEM;
+    }
+
+    rmt_rx_channel_config_t config = {
+        .gpio_num = pin,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = DHT_RMT_RESOLUTION_HZ,
+        .mem_block_symbols = DHT_RMT_SYMBOLS,
+    };
+    esp_err_t res = rmt_new_rx_channel(&config, &h->channel);
+    if (res != ESP_OK)
+    {
+        // Expected when the channels are shared between batches; callers
+        // report the fallback themselves
+        ESP_LOGD(TAG, "Could not allocate RX channel for GPIO %d: %s", pin, esp_err_to_name(res));
+        vQueueDelete(h->done);
+        free(h);
+        return res;
+    }
+
+    rmt_rx_event_callbacks_t cbs = { .on_recv_done = dht_rmt_on_recv_done };
+    rmt_rx_register_event_callbacks(h->channel, &cbs, h->done);
+    rmt_enable(h->channel);
+
+    // Open drain with input enabled: the RMT keeps listening while we drive
+    gpio_set_direction(pin, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_level(pin, 1);
+
+    *handle = h;
+    return ESP_OK;
+}
+
+esp_err_t dht_rmt_del(dht_rmt_handle_t handle)
+{
+    CHECK_ARG(handle);
+
+    rmt_disable(handle->channel);
+    rmt_del_channel(handle->channel);
+    vQueueDelete(handle->done);
+    gpio_set_direction(handle->pin, GPIO_MODE_OUTPUT_OD);
+    gpio_set_level(handle->pin, 1);
+    free(handle);
+
+    return ESP_OK;
+}
+
+esp_err_t dht_rmt_start(dht_rmt_handle_t handle)
+{
+    CHECK_ARG(handle);
+
+    xQueueReset(handle->done);
+    // Phase 'A' pulling signal low to initiate read sequence
+    gpio_set_level(handle->pin, 0);
+    handle->start_us = esp_timer_get_time();
+
+    return ESP_OK;
+}
+
+esp_err_t dht_rmt_arm(dht_rmt_handle_t handle)
+{
+    CHECK_ARG(handle);
+
+    dht_wait_start_pulse(handle->sensor_type, handle->start_us);
+
+    // The receiver starts on the first edge, which is our own release
+    rmt_receive_config_t config = {
+        .signal_range_min_ns = DHT_RMT_GLITCH_NS,
+        .signal_range_max_ns = DHT_RMT_IDLE_NS,
+    };
+    esp_err_t res = rmt_receive(handle->channel, handle->symbols, sizeof(handle->symbols), &config);
+    gpio_set_level(handle->pin, 1);
+    if (res != ESP_OK)
+        ESP_LOGE(TAG, "Could not start capture on GPIO %d: %s", handle->pin, esp_err_to_name(res));
+
+    return res;
+}
+
+esp_err_t dht_rmt_wait(dht_rmt_handle_t handle, TickType_t timeout,
+                       int16_t *humidity, int16_t *temperature)
+{
+    CHECK_ARG(handle && (humidity || temperature));
+
+    rmt_rx_done_event_data_t edata;
+    if (xQueueReceive(handle->done, &edata, timeout) != pdTRUE)
+    {
+        // Abort the pending capture so the channel can be armed again
+        rmt_disable(handle->channel);
+        rmt_enable(handle->channel);
+        ESP_LOGE(TAG, "No response from sensor on GPIO %d", handle->pin);
+        dht_diag_record(handle->pin, DHT_DIAG_PHASE_B, NULL, NULL);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    uint16_t durations[DHT_RMT_SYMBOLS * 2];
+    int first_level = 0;
+    size_t count = dht_rmt_flatten(edata.received_symbols, edata.num_symbols, durations, &first_level);
+
+    return dht_process_pulses(handle->sensor_type, handle->pin, durations, count, first_level,
+                              humidity, temperature);
+}
+
+esp_err_t dht_rmt_read(dht_rmt_handle_t handle, int16_t *humidity, int16_t *temperature)
+{
+    esp_err_t res = dht_rmt_start(handle);
+    if (res == ESP_OK)
+        res = dht_rmt_arm(handle);
+    if (res == ESP_OK)
+        res = dht_rmt_wait(handle, pdMS_TO_TICKS(DHT_RMT_FRAME_TIMEOUT_MS) + 1, humidity, temperature);
+
+    return res;
+}
+
+#endif // CONFIG_DHT_USE_RMT
@@ -0,0 +1,104 @@
+/**
+ * @file dht_rmt.h
+ * @defgroup dht_rmt dht_rmt
+ * @{
+ *
+ * RMT capture backend for DHT11, AM2301 (DHT21, DHT22, AM2302, AM2321),
+ * Itead Si7021
+ *
+ * The start pulse is timed with the scheduler instead of a busy wait, and the
+ * sensor response is captured by the RMT receiver, so no critical section is
+ * held and interrupts stay enabled during a read. Decoding runs afterwards in
+ * the calling task.
+ *
+ * A read is split in three steps so a caller can overlap several sensors:
+ * dht_rmt_start() pulls the line low, dht_rmt_arm() releases it and starts
+ * the capture once the start pulse is long enough, and dht_rmt_wait() blocks
+ * until the frame has been received.
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+#ifndef __DHT_RMT_H__
+#define __DHT_RMT_H__
+
+#include <freertos/FreeRTOS.h>
+#include "dht.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * RMT capture handle, one per sensor pin
+ */
+typedef struct dht_rmt_s *dht_rmt_handle_t;
+
+/**
+ * @brief Create an RMT receive channel for a sensor
+ *
+ * @param sensor_type Sensor type
+ * @param pin GPIO pin connected to sensor OUT
+ * @param[out] handle Created handle
+ * @return `ESP_OK` on success, `ESP_ERR_NOT_FOUND` if no RMT RX channel is free
+ */
+esp_err_t dht_rmt_new(dht_sensor_type_t sensor_type, gpio_num_t pin, dht_rmt_handle_t *handle);
+
+/**
+ * @brief Release the RMT channel of a sensor
+ *
+ * @param handle Handle created by dht_rmt_new()
+ * @return `ESP_OK` on success
+ */
+esp_err_t dht_rmt_del(dht_rmt_handle_t handle);
+
+/**
+ * @brief Begin the start pulse (pull the line low) and return immediately
+ *
+ * @param handle Sensor handle
+ * @return `ESP_OK` on success
+ */
+esp_err_t dht_rmt_start(dht_rmt_handle_t handle);
+
+/**
+ * @brief End the start pulse and capture the sensor response
+ *
+ * Waits for whatever is left of the start pulse, sleeping in whole ticks
+ * when it lasts a tick or more (DHT11), then arms the receiver and releases
+ * the line.
+ *
+ * @param handle Sensor handle
+ * @return `ESP_OK` on success
+ */
+esp_err_t dht_rmt_arm(dht_rmt_handle_t handle);
+
+/**
+ * @brief Wait for the captured frame and decode it
+ *
+ * @param handle Sensor handle
+ * @param timeout Maximum time to wait, 0 to poll
+ * @param[out] humidity Humidity, percents * 10, nullable
+ * @param[out] temperature Temperature, degrees Celsius * 10, nullable
+ * @return `ESP_OK` on success, `ESP_ERR_TIMEOUT` if no frame arrived,
+ *         `ESP_ERR_INVALID_RESPONSE` if the frame is malformed,
+ *         `ESP_ERR_INVALID_CRC` on checksum mismatch
+ */
+esp_err_t dht_rmt_wait(dht_rmt_handle_t handle, TickType_t timeout,
+                       int16_t *humidity, int16_t *temperature);
+
+/**
+ * @brief Complete read: start pulse, capture and decode
+ *
+ * @param handle Sensor handle
+ * @param[out] humidity Humidity, percents * 10, nullable
+ * @param[out] temperature Temperature, degrees Celsius * 10, nullable
+ * @return `ESP_OK` on success
+ */
+esp_err_t dht_rmt_read(dht_rmt_handle_t handle, int16_t *humidity, int16_t *temperature);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif  // __DHT_RMT_H__
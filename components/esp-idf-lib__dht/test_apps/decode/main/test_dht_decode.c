@@ -0,0 +1,257 @@
+/**
+ * @file test_dht_decode.c
+ *
+ * Host tests and benchmark for the waveform decoder
+ *
+ * Every case is generated from a seed by waveform.c, so a failure prints
+ * what is needed to replay it. The process exits with the number of failed
+ * checks, capped at 255.
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dht_decode.h"
+#include "waveform.h"
+
+// Random frames per combination of sensor, capture, drift and jitter
+#define FRAMES_PER_CASE 50
+#define BENCH_FRAMES 200000
+
+static const char *const sensor_names[] = { "DHT11", "AM2301", "Si7021" };
+static const char *const status_names[] = { "ok", "bad checksum", "bad preamble", "truncated" };
+
+static int checks;
+static int failures;
+
+static void fail(const char *what, const wave_params_t *p, uint32_t seed, const dht_decode_result_t *r)
+{
+    if (failures++ < 20)
+        printf("FAIL %s: %s %s drift %.2f tick %.0f jitter %d glitches %d head %d tail %d "
+               "seed %08x -> %s\n",
+               what, sensor_names[p->sensor_type], p->capture == WAVE_RMT ? "rmt" : "gpio",
+               p->drift, p->tick_us, p->jitter_us, p->glitches, p->drop_head, p->drop_tail,
+               (unsigned)seed, status_names[r->status]);
+}
+
+// A reading the sensor can report: DHT11 only has whole units and no
+// negative temperatures
+static void random_reading(dht_sensor_type_t sensor_type, uint32_t *seed,
+                           int16_t *humidity, int16_t *temperature)
+{
+    if (sensor_type == DHT_TYPE_DHT11)
+    {
+        *humidity = 200 + wave_rand(seed) % 71 * 10;
+        *temperature = wave_rand(seed) % 51 * 10;
+    }
+    else
+    {
+        *humidity = wave_rand(seed) % 1001;
+        *temperature = (int)(wave_rand(seed) % 1201) - 400;
+    }
+}
+
+/**
+ * Decode one generated frame and check the outcome: `expect` is the
+ * required status, or -1 for "anything but a wrong frame reported as ok".
+ */
+static void check_case(const char *what, const wave_params_t *p, uint32_t *seed, int expect)
+{
+    int16_t humidity, temperature, h, t;
+    uint8_t data[DHT_DATA_BYTES];
+    uint16_t durations[WAVE_MAX_PULSES];
+    dht_decode_result_t r;
+    int first_level;
+    uint32_t replay = *seed;
+
+    random_reading(p->sensor_type, seed, &humidity, &temperature);
+    wave_frame(p->sensor_type, humidity, temperature, data);
+    size_t n = wave_generate(p, data, seed, durations, &first_level);
+    dht_decode(durations, n, first_level, &r);
+    checks++;
+
+    bool same = memcmp(r.data, data, sizeof(data)) == 0;
+    if (expect == -1)
+    {
+        if (r.status == DHT_DECODE_OK && !same)
+            fail(what, p, replay, &r);
+        return;
+    }
+    if ((int)r.status != expect)
+    {
+        fail(what, p, replay, &r);
+        return;
+    }
+    if (expect != DHT_DECODE_OK)
+        return;
+
+    dht_decode_convert(p->sensor_type, r.data, &h, &t);
+    if (!same || h != humidity || t != temperature)
+        fail(what, p, replay, &r);
+}
+
+static void test_clean_and_jitter(uint32_t *seed)
+{
+    static const float drifts[] = { 0.85f, 1.0f, 1.15f };
+    static const int jitters[] = { 0, 4, 8 };
+    // Fast polling and RMT count in us, the plain polling loop in 2 us
+    static const struct { wave_capture_t capture; float tick_us; } captures[] = {
+        { WAVE_GPIO, 1 }, { WAVE_GPIO, 2 }, { WAVE_RMT, 1 },
+    };
+
+    for (int s = DHT_TYPE_DHT11; s <= DHT_TYPE_SI7021; s++)
+        for (size_t c = 0; c < sizeof(captures) / sizeof(captures[0]); c++)
+            for (size_t d = 0; d < sizeof(drifts) / sizeof(drifts[0]); d++)
+                for (size_t j = 0; j < sizeof(jitters) / sizeof(jitters[0]); j++)
+                {
+                    wave_params_t p = {
+                        .sensor_type = s,
+                        .capture = captures[c].capture,
+                        .tick_us = captures[c].tick_us,
+                        .drift = drifts[d],
+                        .jitter_us = jitters[j],
+                    };
+                    for (int i = 0; i < FRAMES_PER_CASE; i++)
+                        check_case("clean/jitter", &p, seed, DHT_DECODE_OK);
+                }
+}
+
+static void test_truncated(uint32_t *seed)
+{
+    for (int s = DHT_TYPE_DHT11; s <= DHT_TYPE_SI7021; s++)
+        for (wave_capture_t c = WAVE_GPIO; c <= WAVE_RMT; c++)
+        {
+            wave_params_t p = { .sensor_type = s, .capture = c, .drift = 1, .tick_us = 1, .jitter_us = 4 };
+
+            // Any lost bit pulse fails; from 4 on too few bits are left
+            for (p.drop_tail = 1; p.drop_tail <= DHT_DATA_BITS * 2; p.drop_tail++)
+                check_case("lost tail", &p, seed, p.drop_tail < 4 ? -1 : DHT_DECODE_TRUNCATED);
+            p.drop_tail = 0;
+
+            // Phase 'B' is not needed; without 'C' the preamble is gone
+            p.drop_head = 1;
+            check_case("lost 'B'", &p, seed, DHT_DECODE_OK);
+            for (p.drop_head = 2; p.drop_head <= 3; p.drop_head++)
+                check_case("lost preamble", &p, seed, DHT_DECODE_BAD_PREAMBLE);
+            for (p.drop_head = 5; p.drop_head <= DHT_DATA_BITS * 2; p.drop_head++)
+                check_case("lost head", &p, seed, DHT_DECODE_TRUNCATED);
+        }
+}
+
+static void test_noise(uint32_t *seed)
+{
+    int safe = 0, total = 0;
+
+    for (int s = DHT_TYPE_DHT11; s <= DHT_TYPE_SI7021; s++)
+        for (wave_capture_t c = WAVE_GPIO; c <= WAVE_RMT; c++)
+            for (int g = 1; g <= 3; g++)
+                for (int i = 0; i < FRAMES_PER_CASE * 4; i++)
+                {
+                    wave_params_t p = {
+                        .sensor_type = s, .capture = c, .drift = 1, .tick_us = 1,
+                        .jitter_us = 4, .glitches = g,
+                    };
+                    int before = failures;
+                    check_case("glitch", &p, seed, -1);
+                    total++;
+                    safe += failures == before;
+                }
+    printf("  glitches: %d/%d frames never reported wrong\n", safe, total);
+}
+
+static void test_convert(void)
+{
+    static const struct
+    {
+        dht_sensor_type_t sensor_type;
+        uint8_t data[DHT_DATA_BYTES];
+        int16_t humidity, temperature;
+    } vectors[] = {
+        { DHT_TYPE_DHT11,  { 55, 0, 23, 0 },       550,  230 },
+        { DHT_TYPE_DHT11,  { 20, 9, 0, 5 },        200,    0 },
+        { DHT_TYPE_AM2301, { 0x02, 0x8C, 0x01, 0x5F }, 652, 351 },
+        { DHT_TYPE_AM2301, { 0x01, 0xF4, 0x80, 0x65 }, 500, -101 },
+        { DHT_TYPE_SI7021, { 0x03, 0xE8, 0x80, 0x00 }, 1000,  0 },
+    };
+
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+    {
+        int16_t h, t;
+        dht_decode_convert(vectors[i].sensor_type, vectors[i].data, &h, &t);
+        checks++;
+        if (h != vectors[i].humidity || t != vectors[i].temperature)
+        {
+            failures++;
+            printf("FAIL convert %zu: %d/%d, expected %d/%d\n", i, h, t,
+                   vectors[i].humidity, vectors[i].temperature);
+        }
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void benchmark(uint32_t *seed)
+{
+    enum { CORPUS = 64 };
+    static uint16_t durations[CORPUS][WAVE_MAX_PULSES];
+    static size_t count[CORPUS];
+    static int first_level[CORPUS];
+
+    for (int i = 0; i < CORPUS; i++)
+    {
+        wave_params_t p = {
+            .sensor_type = i % 3, .capture = i / 3 % 2, .drift = 1, .tick_us = 1, .jitter_us = 4,
+        };
+        int16_t h, t;
+        uint8_t data[DHT_DATA_BYTES];
+        random_reading(p.sensor_type, seed, &h, &t);
+        wave_frame(p.sensor_type, h, t, data);
+        count[i] = wave_generate(&p, data, seed, durations[i], &first_level[i]);
+    }
+
+    dht_decode_result_t r;
+    volatile unsigned sink = 0;
+    double start = now_ns();
+    for (int i = 0; i < BENCH_FRAMES; i++)
+    {
+        int k = i % CORPUS;
+        sink += dht_decode(durations[k], count[k], first_level[k], &r);
+    }
+    double elapsed = now_ns() - start;
+    printf("  benchmark: %.0f ns per frame (%d frames)\n", elapsed / BENCH_FRAMES, BENCH_FRAMES);
+}
+
+static int run(void)
+{
+    uint32_t seed = 0x2545F491;
+
+    printf("dht_decode host tests\n");
+    test_clean_and_jitter(&seed);
+    test_truncated(&seed);
+    test_noise(&seed);
+    test_convert();
+    printf("  %d checks, %d failed\n", checks, failures);
+    benchmark(&seed);
+
+    return failures > 255 ? 255 : failures;
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void)
+{
+    exit(run());
+}
+#else
+int main(void)
+{
+    return run();
+}
+#endif
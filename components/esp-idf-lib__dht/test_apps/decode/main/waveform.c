@@ -0,0 +1,120 @@
+/**
+ * @file waveform.c
+ *
+ * Synthetic sensor responses for the decoder tests
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+#include "waveform.h"
+
+#include <string.h>
+
+/*
+ *  Typical timings of each sensor, us. Phase 'B' is the sensor waiting
+ *  after the host releases the line; the rest is driven by the sensor.
+ */
+typedef struct
+{
+    float b, c, d;
+    float bit_low, bit_0, bit_1;
+} wave_timing_t;
+
+static const wave_timing_t timings[] = {
+    [DHT_TYPE_DHT11]  = { 30, 83, 87, 54, 24, 71 },
+    [DHT_TYPE_AM2301] = { 30, 80, 80, 50, 26, 70 },
+    [DHT_TYPE_SI7021] = { 25, 75, 75, 50, 25, 70 },
+};
+
+uint32_t wave_rand(uint32_t *seed)
+{
+    uint32_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *seed = x;
+}
+
+// Uniform in [lo, hi]
+static int rand_range(uint32_t *seed, int lo, int hi)
+{
+    return lo + (int)(wave_rand(seed) % (uint32_t)(hi - lo + 1));
+}
+
+static void encode16(int16_t value, uint8_t *msb, uint8_t *lsb)
+{
+    uint16_t magnitude = value < 0 ? -value : value;
+    *msb = (magnitude >> 8) | (value < 0 ? 0x80 : 0);
+    *lsb = magnitude & 0xFF;
+}
+
+void wave_frame(dht_sensor_type_t sensor_type, int16_t humidity, int16_t temperature,
+                uint8_t data[DHT_DATA_BYTES])
+{
+    memset(data, 0, DHT_DATA_BYTES);
+    if (sensor_type == DHT_TYPE_DHT11)
+    {
+        data[0] = humidity / 10;
+        data[2] = temperature / 10;
+    }
+    else
+    {
+        encode16(humidity, &data[0], &data[1]);
+        encode16(temperature, &data[2], &data[3]);
+    }
+    data[4] = data[0] + data[1] + data[2] + data[3];
+}
+
+size_t wave_generate(const wave_params_t *params, const uint8_t data[DHT_DATA_BYTES],
+                     uint32_t *seed, uint16_t durations[WAVE_MAX_PULSES], int *first_level)
+{
+    const wave_timing_t *t = &timings[params->sensor_type];
+    float us[WAVE_MAX_PULSES];
+    size_t n = 0;
+
+    // Every capture starts high at phase 'B'
+    us[n++] = t->b;
+    us[n++] = t->c;
+    us[n++] = t->d;
+    for (int i = 0; i < DHT_DATA_BITS; i++)
+    {
+        us[n++] = t->bit_low;
+        us[n++] = (data[i / 8] >> (7 - i % 8)) & 1 ? t->bit_1 : t->bit_0;
+    }
+    if (params->capture == WAVE_RMT)
+        us[n++] = t->bit_low;
+
+    for (size_t i = 0; i < n; i++)
+        us[i] *= params->drift;
+
+    // A spike of the opposite level splits a bit pulse in three
+    for (int g = 0; g < params->glitches && g < WAVE_MAX_GLITCHES; g++)
+    {
+        size_t i = rand_range(seed, 3, 3 + DHT_DATA_BITS * 2 - 1);
+        if (us[i] < 12)
+            continue;
+        float spike = rand_range(seed, 1, 3);
+        float before = rand_range(seed, 3, (int)us[i] - 6);
+        memmove(&us[i + 3], &us[i + 1], (n - i - 1) * sizeof(us[0]));
+        us[i + 2] = us[i] - before - spike;
+        us[i + 1] = spike;
+        us[i] = before;
+        n += 2;
+    }
+
+    if (params->drop_tail > 0 && params->capture == WAVE_RMT)
+        n--;
+    n = params->drop_tail < (int)n ? n - params->drop_tail : 0;
+    size_t head = params->drop_head < (int)n ? (size_t)params->drop_head : n;
+    *first_level = (head & 1) == 0;
+
+    for (size_t i = 0; i + head < n; i++)
+    {
+        float v = us[i + head];
+        if (params->jitter_us)
+            v += rand_range(seed, -params->jitter_us, params->jitter_us);
+        v = v / params->tick_us + 0.5f;
+        durations[i] = v < 1 ? 1 : v > UINT16_MAX ? UINT16_MAX : (uint16_t)v;
+    }
+
+    return n - head;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file waveform.h
+ *
+ * Synthetic sensor responses for the decoder tests
+ *
+ * Builds the pulse list a capture backend would hand to dht_decode() for a
+ * given frame: per-sensor nominal timings, scaled by the sensor clock drift
+ * and the capture tick, with optional jitter, glitches and lost pulses.
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+#ifndef __WAVEFORM_H__
+#define __WAVEFORM_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dht_decode.h"
+
+// Phases 'B', 'C', 'D', 40 bits and the trailing low, plus room for
+// glitches
+#define WAVE_MAX_GLITCHES 8
+#define WAVE_MAX_PULSES (3 + DHT_DATA_BITS * 2 + 1 + WAVE_MAX_GLITCHES * 2)
+
+typedef enum
+{
+    WAVE_GPIO,  //!< Polling: starts at phase 'B', no trailing low
+    WAVE_RMT,   //!< RMT: starts at phase 'B', ends with the trailing low
+} wave_capture_t;
+
+typedef struct
+{
+    dht_sensor_type_t sensor_type;
+    wave_capture_t capture;
+    float drift;        //!< Sensor clock, 1.0 nominal, >1 slower
+    float tick_us;      //!< Capture tick, 1 for RMT and fast polling
+    int jitter_us;      //!< Uniform +-jitter added to every pulse
+    int glitches;       //!< 1-3 us spikes splitting random bit pulses, up to WAVE_MAX_GLITCHES
+    int drop_head;      //!< Pulses lost at the start of the capture
+    int drop_tail;      //!< Data pulses lost at the end, plus the trailing low
+} wave_params_t;
+
+/**
+ * Deterministic xorshift32, so a failing case can be replayed from its seed
+ */
+uint32_t wave_rand(uint32_t *seed);
+
+/**
+ * Build a valid frame for a reading, checksum included. DHT11 only carries
+ * whole units, so the tenths of `humidity` and `temperature` are dropped.
+ */
+void wave_frame(dht_sensor_type_t sensor_type, int16_t humidity, int16_t temperature,
+                uint8_t data[DHT_DATA_BYTES]);
+
+/**
+ * Generate the captured pulses for a frame.
+ *
+ * @return Number of pulses written to `durations`
+ */
+size_t wave_generate(const wave_params_t *params, const uint8_t data[DHT_DATA_BYTES],
+                     uint32_t *seed, uint16_t durations[WAVE_MAX_PULSES], int *first_level);
+
+#endif  // __WAVEFORM_H__
@@ -0,0 +1,357 @@
+/**
+ * @file i2c_bus.c
+ *
+ * Shared I2C master bus manager
+ *
+ * MIT Licensed
+ */
+#include "i2c_bus.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <esp_log.h>
+
+#define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
+
+static const char *TAG = "i2c_bus";
+
+/*
+ * Arbitration: `state` protects the fields below it and is only held for a
+ * few instructions. The bus itself is a flag handed over directly from the
+ * releasing task to the highest priority waiter: each priority has a
+ * counting semaphore, and waiters are counted so the releaser knows which
+ * one to give.
+ */
+typedef struct
+{
+    i2c_master_bus_handle_t handle;
+    gpio_num_t sda;
+    gpio_num_t scl;
+    SemaphoreHandle_t state;
+    SemaphoreHandle_t grant[I2C_BUS_PRIO_MAX];
+
+    bool busy;
+    TaskHandle_t owner;
+    int depth;
+    int64_t acquired;
+    uint16_t waiting[I2C_BUS_PRIO_MAX];
+    i2c_bus_stats_t stats;
+    int64_t window_start;
+} i2c_bus_t;
+
+struct i2c_bus_dev_s
+{
+    i2c_bus_t *bus;
+    i2c_master_dev_handle_t handle;
+    i2c_bus_prio_t prio;
+    uint16_t address;
+};
+
+static i2c_bus_t *buses[I2C_NUM_MAX];
+static portMUX_TYPE buses_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline TickType_t to_ticks(int timeout_ms)
+{
+    return timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+}
+
+static esp_err_t bus_acquire(i2c_bus_t *bus, i2c_bus_prio_t prio, int timeout_ms)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    int64_t start = esp_timer_get_time();
+    bool granted = false;
+
+    xSemaphoreTake(bus->state, portMAX_DELAY);
+    if (bus->busy && bus->owner == self)
+    {
+        bus->depth++;
+        xSemaphoreGive(bus->state);
+        return ESP_OK;
+    }
+    if (!bus->busy)
+    {
+        bus->busy = true;
+        granted = true;
+    }
+    else
+        bus->waiting[prio]++;
+    xSemaphoreGive(bus->state);
+
+    if (!granted && xSemaphoreTake(bus->grant[prio], to_ticks(timeout_ms)) != pdTRUE)
+    {
+        xSemaphoreTake(bus->state, portMAX_DELAY);
+        // The bus may have been handed over right after the timeout
+        if (xSemaphoreTake(bus->grant[prio], 0) != pdTRUE)
+        {
+            bus->waiting[prio]--;
+            bus->stats.timeouts++;
+            xSemaphoreGive(bus->state);
+            return ESP_ERR_TIMEOUT;
+        }
+        xSemaphoreGive(bus->state);
+    }
+
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(bus->state, portMAX_DELAY);
+    bus->owner = self;
+    bus->depth = 1;
+    bus->acquired = now;
+    bus->stats.transactions[prio]++;
+    if (now - start > bus->stats.max_wait_us[prio])
+        bus->stats.max_wait_us[prio] = now - start;
+    xSemaphoreGive(bus->state);
+
+    return ESP_OK;
+}
+
+static void bus_release(i2c_bus_t *bus)
+{
+    xSemaphoreTake(bus->state, portMAX_DELAY);
+    if (--bus->depth > 0)
+    {
+        xSemaphoreGive(bus->state);
+        return;
+    }
+    bus->stats.busy_us += esp_timer_get_time() - bus->acquired;
+    bus->owner = NULL;
+    for (int p = I2C_BUS_PRIO_MAX - 1; p >= 0; p--)
+    {
+        if (bus->waiting[p])
+        {
+            // Hand over: the bus stays busy for the woken waiter
+            bus->waiting[p]--;
+            xSemaphoreGive(bus->grant[p]);
+            xSemaphoreGive(bus->state);
+            return;
+        }
+    }
+    bus->busy = false;
+    xSemaphoreGive(bus->state);
+}
+
+static esp_err_t bus_account(i2c_bus_t *bus, esp_err_t res, size_t bytes)
+{
+    xSemaphoreTake(bus->state, portMAX_DELAY);
+    bus->stats.bytes += bytes;
+    if (res != ESP_OK)
+        bus->stats.errors++;
+    xSemaphoreGive(bus->state);
+
+    return res;
+}
+
+esp_err_t i2c_bus_init(i2c_port_t port, gpio_num_t sda, gpio_num_t scl)
+{
+    CHECK_ARG(port >= 0 && port < I2C_NUM_MAX);
+
+    portENTER_CRITICAL(&buses_mux);
+    i2c_bus_t *existing = buses[port];
+    portEXIT_CRITICAL(&buses_mux);
+    if (existing)
+    {
+        if (existing->sda != sda || existing->scl != scl)
+        {
+            ESP_LOGE(TAG, "Port %d already used with SDA %d, SCL %d", port, existing->sda, existing->scl);
+            return ESP_ERR_INVALID_STATE;
+        }
+        return ESP_OK;
+    }
+
+    i2c_bus_t *bus = calloc(1, sizeof(*bus));
+    if (!bus)
+        return ESP_ERR_NO_MEM;
+    bus->sda = sda;
+    bus->scl = scl;
+    bus->state = xSemaphoreCreateMutex();
+    bool ok = bus->state != NULL;
+    for (int p = 0; p < I2C_BUS_PRIO_MAX; p++)
+    {
+        bus->grant[p] = xSemaphoreCreateCounting(UINT16_MAX, 0);
+        ok = ok && bus->grant[p];
+    }
+
+    i2c_master_bus_config_t config = {
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .i2c_port = port,
+        .scl_io_num = scl,
+        .sda_io_num = sda,
+        .flags.enable_internal_pullup = true,
+    };
+    esp_err_t res = ok ? i2c_new_master_bus(&config, &bus->handle) : ESP_ERR_NO_MEM;
+    if (res != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Could not create bus on port %d: %s", port, esp_err_to_name(res));
+        for (int p = 0; p < I2C_BUS_PRIO_MAX; p++)
+            if (bus->grant[p])
+                vSemaphoreDelete(bus->grant[p]);
+        if (bus->state)
+            vSemaphoreDelete(bus->state);
+        free(bus);
+        return res;
+    }
+    bus->window_start = esp_timer_get_time();
+
+    portENTER_CRITICAL(&buses_mux);
+    buses[port] = bus;
+    portEXIT_CRITICAL(&buses_mux);
+
+    ESP_LOGI(TAG, "Bus on port %d: SDA %d, SCL %d", port, sda, scl);
+    return ESP_OK;
+}
+
+static i2c_bus_t *bus_get(i2c_port_t port)
+{
+    if (port < 0 || port >= I2C_NUM_MAX)
+        return NULL;
+
+    portENTER_CRITICAL(&buses_mux);
+    i2c_bus_t *bus = buses[port];
+    portEXIT_CRITICAL(&buses_mux);
+
+    return bus;
+}
+
+esp_err_t i2c_bus_get_handle(i2c_port_t port, i2c_master_bus_handle_t *handle)
+{
+    CHECK_ARG(handle);
+
+    i2c_bus_t *bus = bus_get(port);
+    if (!bus)
+        return ESP_ERR_INVALID_STATE;
+    *handle = bus->handle;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_add_device(i2c_port_t port, uint16_t address, uint32_t scl_speed_hz,
+                             i2c_bus_prio_t prio, i2c_bus_dev_handle_t *dev)
+{
+    CHECK_ARG(dev && prio < I2C_BUS_PRIO_MAX);
+
+    i2c_bus_t *bus = bus_get(port);
+    if (!bus)
+        return ESP_ERR_INVALID_STATE;
+
+    i2c_bus_dev_handle_t d = calloc(1, sizeof(*d));
+    if (!d)
+        return ESP_ERR_NO_MEM;
+
+    i2c_device_config_t config = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = address,
+        .scl_speed_hz = scl_speed_hz,
+    };
+    esp_err_t res = i2c_master_bus_add_device(bus->handle, &config, &d->handle);
+    if (res != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Could not add device 0x%02x on port %d: %s", address, port, esp_err_to_name(res));
+        free(d);
+        return res;
+    }
+    d->bus = bus;
+    d->prio = prio;
+    d->address = address;
+
+    *dev = d;
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_remove_device(i2c_bus_dev_handle_t dev)
+{
+    CHECK_ARG(dev);
+
+    esp_err_t res = i2c_master_bus_rm_device(dev->handle);
+    if (res == ESP_OK)
+        free(dev);
+
+    return res;
+}
+
+esp_err_t i2c_bus_lock(i2c_bus_dev_handle_t dev, int timeout_ms)
+{
+    CHECK_ARG(dev);
+
+    return bus_acquire(dev->bus, dev->prio, timeout_ms);
+}
+
+esp_err_t i2c_bus_unlock(i2c_bus_dev_handle_t dev)
+{
+    CHECK_ARG(dev);
+
+    bus_release(dev->bus);
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_transmit(i2c_bus_dev_handle_t dev, const uint8_t *data, size_t len, int timeout_ms)
+{
+    CHECK_ARG(dev && data);
+
+    esp_err_t res = bus_acquire(dev->bus, dev->prio, timeout_ms);
+    if (res != ESP_OK)
+        return res;
+    res = i2c_master_transmit(dev->handle, data, len, timeout_ms);
+    bus_release(dev->bus);
+
+    return bus_account(dev->bus, res, len);
+}
+
+esp_err_t i2c_bus_receive(i2c_bus_dev_handle_t dev, uint8_t *data, size_t len, int timeout_ms)
+{
+    CHECK_ARG(dev && data);
+
+    esp_err_t res = bus_acquire(dev->bus, dev->prio, timeout_ms);
+    if (res != ESP_OK)
+        return res;
+    res = i2c_master_receive(dev->handle, data, len, timeout_ms);
+    bus_release(dev->bus);
+
+    return bus_account(dev->bus, res, len);
+}
+
+esp_err_t i2c_bus_transmit_receive(i2c_bus_dev_handle_t dev, const uint8_t *write, size_t write_len,
+                                   uint8_t *read, size_t read_len, int timeout_ms)
+{
+    CHECK_ARG(dev && write && read);
+
+    esp_err_t res = bus_acquire(dev->bus, dev->prio, timeout_ms);
+    if (res != ESP_OK)
+        return res;
+    res = i2c_master_transmit_receive(dev->handle, write, write_len, read, read_len, timeout_ms);
+    bus_release(dev->bus);
+
+    return bus_account(dev->bus, res, write_len + read_len);
+}
+
+esp_err_t i2c_bus_get_stats(i2c_port_t port, i2c_bus_stats_t *stats, bool reset)
+{
+    CHECK_ARG(stats);
+
+    i2c_bus_t *bus = bus_get(port);
+    if (!bus)
+        return ESP_ERR_INVALID_STATE;
+
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(bus->state, portMAX_DELAY);
+    *stats = bus->stats;
+    stats->window_us = now - bus->window_start;
+    // Count the current holder up to now
+    if (bus->owner)
+        stats->busy_us += now - bus->acquired;
+    if (reset)
+    {
+        memset(&bus->stats, 0, sizeof(bus->stats));
+        bus->window_start = now;
+        if (bus->owner)
+            bus->acquired = now;
+    }
+    xSemaphoreGive(bus->state);
+
+    stats->utilization = stats->window_us ? stats->busy_us * 100 / stats->window_us : 0;
+    return ESP_OK;
+}
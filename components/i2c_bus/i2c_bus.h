@@ -0,0 +1,182 @@
+/**
+ * @file i2c_bus.h
+ * @defgroup i2c_bus i2c_bus
+ * @{
+ *
+ * Shared I2C master bus manager
+ *
+ * Owns one `i2c_master_bus_handle_t` per port and hands out device handles
+ * to every driver on that bus (display, sensors...). Transactions are
+ * arbitrated by device priority: when the bus is released it goes to the
+ * highest priority waiter, so a sensor read waits for at most one display
+ * transfer instead of a whole frame flush. Drivers that need several
+ * transfers in a row can hold the bus with i2c_bus_lock().
+ *
+ * Time spent holding the bus is accounted to report utilization.
+ *
+ * MIT Licensed
+ */
+#ifndef __I2C_BUS_H__
+#define __I2C_BUS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <driver/gpio.h>
+#include <driver/i2c_master.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Transaction priority of a device
+ */
+typedef enum
+{
+    I2C_BUS_PRIO_LOW = 0,   //!< Bulk transfers, e.g. display flushes
+    I2C_BUS_PRIO_NORMAL,    //!< Default
+    I2C_BUS_PRIO_HIGH,      //!< Latency sensitive, e.g. sensor reads
+    I2C_BUS_PRIO_MAX
+} i2c_bus_prio_t;
+
+/**
+ * Device handle
+ */
+typedef struct i2c_bus_dev_s *i2c_bus_dev_handle_t;
+
+/**
+ * Bus statistics since the last reset
+ */
+typedef struct
+{
+    uint64_t window_us;                         //!< Time since the statistics were reset
+    uint64_t busy_us;                           //!< Time the bus was held
+    uint32_t transactions[I2C_BUS_PRIO_MAX];    //!< Bus acquisitions by priority
+    uint32_t max_wait_us[I2C_BUS_PRIO_MAX];     //!< Longest wait for the bus by priority
+    uint32_t bytes;                             //!< Bytes written and read
+    uint32_t errors;                            //!< Failed transfers
+    uint32_t timeouts;                          //!< Bus not obtained in time
+    uint8_t utilization;                        //!< busy_us / window_us, percent
+} i2c_bus_stats_t;
+
+/**
+ * @brief Create the bus of a port, or check an existing one
+ *
+ * Several drivers can call this with the same pins; only the first call
+ * creates the bus.
+ *
+ * @param port I2C port
+ * @param sda SDA GPIO
+ * @param scl SCL GPIO
+ * @return `ESP_OK` on success, `ESP_ERR_INVALID_STATE` if the port is
+ *         already in use with other pins
+ */
+esp_err_t i2c_bus_init(i2c_port_t port, gpio_num_t sda, gpio_num_t scl);
+
+/**
+ * @brief Get the driver handle of a bus created with i2c_bus_init()
+ *
+ * Transfers made directly on it bypass arbitration and accounting.
+ *
+ * @param port I2C port
+ * @param[out] bus Bus handle
+ * @return `ESP_OK` on success, `ESP_ERR_INVALID_STATE` if not initialized
+ */
+esp_err_t i2c_bus_get_handle(i2c_port_t port, i2c_master_bus_handle_t *bus);
+
+/**
+ * @brief Add a device to a bus
+ *
+ * @param port I2C port, initialized with i2c_bus_init()
+ * @param address 7-bit device address
+ * @param scl_speed_hz Clock for this device
+ * @param prio Transaction priority
+ * @param[out] dev Device handle
+ * @return `ESP_OK` on success
+ */
+esp_err_t i2c_bus_add_device(i2c_port_t port, uint16_t address, uint32_t scl_speed_hz,
+                             i2c_bus_prio_t prio, i2c_bus_dev_handle_t *dev);
+
+/**
+ * @brief Remove a device from its bus
+ *
+ * @param dev Device handle
+ * @return `ESP_OK` on success
+ */
+esp_err_t i2c_bus_remove_device(i2c_bus_dev_handle_t dev);
+
+/**
+ * @brief Acquire the bus for several transfers in a row
+ *
+ * Transfers of the same task on the same bus while it is locked do not
+ * acquire it again.
+ *
+ * @param dev Device handle
+ * @param timeout_ms Maximum wait, -1 to wait forever
+ * @return `ESP_OK` on success, `ESP_ERR_TIMEOUT` if the bus stayed busy
+ */
+esp_err_t i2c_bus_lock(i2c_bus_dev_handle_t dev, int timeout_ms);
+
+/**
+ * @brief Release the bus acquired with i2c_bus_lock()
+ *
+ * @param dev Device handle
+ * @return `ESP_OK` on success
+ */
+esp_err_t i2c_bus_unlock(i2c_bus_dev_handle_t dev);
+
+/**
+ * @brief Write to a device
+ *
+ * @param dev Device handle
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @param timeout_ms Maximum wait for the bus plus the transfer, -1 to wait forever
+ * @return `ESP_OK` on success
+ */
+esp_err_t i2c_bus_transmit(i2c_bus_dev_handle_t dev, const uint8_t *data, size_t len, int timeout_ms);
+
+/**
+ * @brief Read from a device
+ *
+ * @param dev Device handle
+ * @param[out] data Buffer
+ * @param len Number of bytes
+ * @param timeout_ms Maximum wait for the bus plus the transfer, -1 to wait forever
+ * @return `ESP_OK` on success
+ */
+esp_err_t i2c_bus_receive(i2c_bus_dev_handle_t dev, uint8_t *data, size_t len, int timeout_ms);
+
+/**
+ * @brief Write then read with a repeated start
+ *
+ * @param dev Device handle
+ * @param write Bytes to write
+ * @param write_len Number of bytes to write
+ * @param[out] read Buffer
+ * @param read_len Number of bytes to read
+ * @param timeout_ms Maximum wait for the bus plus the transfer, -1 to wait forever
+ * @return `ESP_OK` on success
+ */
+esp_err_t i2c_bus_transmit_receive(i2c_bus_dev_handle_t dev, const uint8_t *write, size_t write_len,
+                                   uint8_t *read, size_t read_len, int timeout_ms);
+
+/**
+ * @brief Get bus statistics
+ *
+ * @param port I2C port
+ * @param[out] stats Statistics
+ * @param reset Start a new statistics window
+ * @return `ESP_OK` on success, `ESP_ERR_INVALID_STATE` if not initialized
+ */
+esp_err_t i2c_bus_get_stats(i2c_port_t port, i2c_bus_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif  // __I2C_BUS_H__
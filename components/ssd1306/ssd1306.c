@@ -10,6 +10,8 @@
 
 #define PACK8 __attribute__((aligned( __alignof__( uint8_t ) ), packed ))
 
+#define TAG "SSD1306"
+
 typedef union out_column_t {
 	uint32_t u32;
 	uint8_t  u8[4];
@@ -17,20 +19,27 @@ typedef union out_column_t {
 
 void ssd1306_init(SSD1306_t * dev, int width, int height)
 {
+#if CONFIG_SSD1306_STATIC_GEOMETRY
+	if (width != SSD1306_WIDTH || height != SSD1306_HEIGHT) {
+		ESP_LOGW(TAG, "Panel %dx%d requested, built for %dx%d", width, height, SSD1306_WIDTH, SSD1306_HEIGHT);
+		width = SSD1306_WIDTH;
+		height = SSD1306_HEIGHT;
+	}
+#endif
 	if (dev->_address == SPI_ADDRESS) {
 		spi_init(dev, width, height);
 	} else {
 		i2c_init(dev, width, height);
 	}
 	// Initialize internal buffer
-	for (int i=0;i<dev->_pages;i++) {
-		memset(dev->_page[i]._segs, 0, 128);
+	for (int i=0;i<SSD1306_DEV_PAGES(dev);i++) {
+		memset(dev->_page[i]._segs, 0, SSD1306_WIDTH);
 	}
 }
 
 int ssd1306_get_width(SSD1306_t * dev)
 {
-	return dev->_width;
+	return SSD1306_DEV_WIDTH(dev);
 }
 
 int ssd1306_get_height(SSD1306_t * dev)
@@ -40,18 +49,18 @@ int ssd1306_get_height(SSD1306_t * dev)
 
 int ssd1306_get_pages(SSD1306_t * dev)
 {
-	return dev->_pages;
+	return SSD1306_DEV_PAGES(dev);
 }
 
 void ssd1306_show_buffer(SSD1306_t * dev)
 {
 	if (dev->_address == SPI_ADDRESS) {
-		for (int page=0; page<dev->_pages;page++) {
-			spi_display_image(dev, page, 0, dev->_page[page]._segs, dev->_width);
+		for (int page=0; page<SSD1306_DEV_PAGES(dev);page++) {
+			spi_display_image(dev, page, 0, dev->_page[page]._segs, SSD1306_DEV_WIDTH(dev));
 		}
 	} else {
-		for (int page=0; page<dev->_pages;page++) {
-			i2c_display_image(dev, page, 0, dev->_page[page]._segs, dev->_width);
+		for (int page=0; page<SSD1306_DEV_PAGES(dev);page++) {
+			i2c_display_image(dev, page, 0, dev->_page[page]._segs, SSD1306_DEV_WIDTH(dev));
 		}
 	}
 }
@@ -59,29 +68,29 @@ void ssd1306_show_buffer(SSD1306_t * dev)
 void ssd1306_set_buffer(SSD1306_t * dev, const uint8_t * buffer)
 {
 	int index = 0;
-	for (int page=0; page<dev->_pages;page++) {
-		memcpy(&dev->_page[page]._segs, &buffer[index], 128);
-		index = index + 128;
+	for (int page=0; page<SSD1306_DEV_PAGES(dev);page++) {
+		memcpy(&dev->_page[page]._segs, &buffer[index], SSD1306_WIDTH);
+		index = index + SSD1306_WIDTH;
 	}
 }
 
 void ssd1306_get_buffer(SSD1306_t * dev, uint8_t * buffer)
 {
 	int index = 0;
-	for (int page=0; page<dev->_pages;page++) {
-		memcpy(&buffer[index], &dev->_page[page]._segs, 128);
-		index = index + 128;
+	for (int page=0; page<SSD1306_DEV_PAGES(dev);page++) {
+		memcpy(&buffer[index], &dev->_page[page]._segs, SSD1306_WIDTH);
+		index = index + SSD1306_WIDTH;
 	}
 }
 
 void ssd1306_set_page(SSD1306_t * dev, int page, const uint8_t * buffer)
 {
-	memcpy(&dev->_page[page]._segs, buffer, 128);
+	memcpy(&dev->_page[page]._segs, buffer, SSD1306_WIDTH);
 }
 
 void ssd1306_get_page(SSD1306_t * dev, int page, uint8_t * buffer)
 {
-	memcpy(buffer, &dev->_page[page]._segs, 128);
+	memcpy(buffer, &dev->_page[page]._segs, SSD1306_WIDTH);
 }
 
 void ssd1306_display_image(SSD1306_t * dev, int page, int seg, const uint8_t * images, int width)
@@ -97,7 +106,7 @@ void ssd1306_display_image(SSD1306_t * dev, int page, int seg, const uint8_t * i
 
 void ssd1306_display_text(SSD1306_t * dev, int page, const char * text, int text_len, bool invert)
 {
-	if (page >= dev->_pages) return;
+	if (page >= SSD1306_DEV_PAGES(dev)) return;
 	int _text_len = text_len;
 	if (_text_len > 16) _text_len = 16;
 
@@ -114,9 +123,9 @@ void ssd1306_display_text(SSD1306_t * dev, int page, const char * text, int text
 
 void ssd1306_display_text_box1(SSD1306_t * dev, int page, int seg, const char * text, int box_width, int text_len, bool invert, int delay)
 {
-	if (page >= dev->_pages) return;
+	if (page >= SSD1306_DEV_PAGES(dev)) return;
 	int text_box_pixel = box_width * 8;
-	if (seg + text_box_pixel > dev->_width) return;
+	if (seg + text_box_pixel > SSD1306_DEV_WIDTH(dev)) return;
 
 	int _seg = seg;
 	uint8_t image[8];
@@ -148,9 +157,9 @@ void ssd1306_display_text_box1(SSD1306_t * dev, int page, int seg, const char *
 
 void ssd1306_display_text_box2(SSD1306_t * dev, int page, int seg, const char * text, int box_width, int text_len, bool invert, int delay)
 {
-	if (page >= dev->_pages) return;
+	if (page >= SSD1306_DEV_PAGES(dev)) return;
 	int text_box_pixel = box_width * 8;
-	if (seg + text_box_pixel > dev->_width) return;
+	if (seg + text_box_pixel > SSD1306_DEV_WIDTH(dev)) return;
 
 	int _seg = seg;
 	uint8_t image[8];
@@ -203,7 +212,8 @@ void ssd1306_display_text_box2(SSD1306_t * dev, int page, int seg, const char *
 void 
 ssd1306_display_text_x3(SSD1306_t * dev, int page, const char * text, int text_len, bool invert)
 {
-	if (page >= dev->_pages) return;
+	// The characters are 3 pages high and all of them must fit
+	if (page + 2 >= SSD1306_DEV_PAGES(dev)) return;
 	int _text_len = text_len;
 	if (_text_len > 5) _text_len = 5;
 
@@ -257,7 +267,7 @@ void ssd1306_clear_screen(SSD1306_t * dev, bool invert)
 {
 	char space[16];
 	memset(space, 0x00, sizeof(space));
-	for (int page = 0; page < dev->_pages; page++) {
+	for (int page = 0; page < SSD1306_DEV_PAGES(dev); page++) {
 		ssd1306_display_text(dev, page, space, sizeof(space), invert);
 	}
 }
@@ -280,10 +290,10 @@ void ssd1306_contrast(SSD1306_t * dev, int contrast)
 
 void ssd1306_software_scroll(SSD1306_t * dev, int start, int end)
 {
-	ESP_LOGD(__FUNCTION__, "software_scroll start=%d end=%d _pages=%d", start, end, dev->_pages);
+	ESP_LOGD(__FUNCTION__, "software_scroll start=%d end=%d _pages=%d", start, end, SSD1306_DEV_PAGES(dev));
 	if (start < 0 || end < 0) {
 		dev->_scEnable = false;
-	} else if (start >= dev->_pages || end >= dev->_pages) {
+	} else if (start >= SSD1306_DEV_PAGES(dev) || end >= SSD1306_DEV_PAGES(dev)) {
 		dev->_scEnable = false;
 	} else {
 		dev->_scEnable = true;
@@ -311,7 +321,7 @@ void ssd1306_scroll_text(SSD1306_t * dev, const char * text, int text_len, bool
 	while(1) {
 		int dstIndex = srcIndex + dev->_scDirection;
 		ESP_LOGD(__FUNCTION__, "srcIndex=%d dstIndex=%d", srcIndex,dstIndex);
-		for(int seg = 0; seg < dev->_width; seg++) {
+		for(int seg = 0; seg < SSD1306_DEV_WIDTH(dev); seg++) {
 			dev->_page[dstIndex]._segs[seg] = dev->_page[srcIndex]._segs[seg];
 		}
 		(*func)(dev, dstIndex, 0, dev->_page[dstIndex]._segs, sizeof(dev->_page[dstIndex]._segs));
@@ -358,12 +368,12 @@ void ssd1306_wrap_arround(SSD1306_t * dev, ssd1306_scroll_type_t scroll, int sta
 	if (scroll == SCROLL_RIGHT) {
 		int _start = start; // 0 to 7
 		int _end = end; // 0 to 7
-		if (_end >= dev->_pages) _end = dev->_pages - 1;
+		if (_end >= SSD1306_DEV_PAGES(dev)) _end = SSD1306_DEV_PAGES(dev) - 1;
 		uint8_t wk;
-		//for (int page=0;page<dev->_pages;page++) {
+		//for (int page=0;page<SSD1306_DEV_PAGES(dev);page++) {
 		for (int page=_start;page<=_end;page++) {
-			wk = dev->_page[page]._segs[127];
-			for (int seg=127;seg>0;seg--) {
+			wk = dev->_page[page]._segs[SSD1306_WIDTH-1];
+			for (int seg=SSD1306_WIDTH-1;seg>0;seg--) {
 				dev->_page[page]._segs[seg] = dev->_page[page]._segs[seg-1];
 			}
 			dev->_page[page]._segs[0] = wk;
@@ -372,32 +382,32 @@ void ssd1306_wrap_arround(SSD1306_t * dev, ssd1306_scroll_type_t scroll, int sta
 	} else if (scroll == SCROLL_LEFT) {
 		int _start = start; // 0 to 7
 		int _end = end; // 0 to 7
-		if (_end >= dev->_pages) _end = dev->_pages - 1;
+		if (_end >= SSD1306_DEV_PAGES(dev)) _end = SSD1306_DEV_PAGES(dev) - 1;
 		uint8_t wk;
-		//for (int page=0;page<dev->_pages;page++) {
+		//for (int page=0;page<SSD1306_DEV_PAGES(dev);page++) {
 		for (int page=_start;page<=_end;page++) {
 			wk = dev->_page[page]._segs[0];
-			for (int seg=0;seg<127;seg++) {
+			for (int seg=0;seg<SSD1306_WIDTH-1;seg++) {
 				dev->_page[page]._segs[seg] = dev->_page[page]._segs[seg+1];
 			}
-			dev->_page[page]._segs[127] = wk;
+			dev->_page[page]._segs[SSD1306_WIDTH-1] = wk;
 		}
 
 	} else if (scroll == SCROLL_UP) {
 		int _start = start; // 0 to {width-1}
 		int _end = end; // 0 to {width-1}
-		if (_end >= dev->_width) _end = dev->_width - 1;
+		if (_end >= SSD1306_DEV_WIDTH(dev)) _end = SSD1306_DEV_WIDTH(dev) - 1;
 		uint8_t wk0;
 		uint8_t wk1;
 		uint8_t wk2;
-		uint8_t save[128];
+		uint8_t save[SSD1306_WIDTH];
 		// Save pages 0
-		for (int seg=0;seg<128;seg++) {
+		for (int seg=0;seg<SSD1306_WIDTH;seg++) {
 			save[seg] = dev->_page[0]._segs[seg];
 		}
 		// Page0 to Page6
-		for (int page=0;page<dev->_pages-1;page++) {
-			//for (int seg=0;seg<128;seg++) {
+		for (int page=0;page<SSD1306_DEV_PAGES(dev)-1;page++) {
+			//for (int seg=0;seg<SSD1306_WIDTH;seg++) {
 			for (int seg=_start;seg<=_end;seg++) {
 				wk0 = dev->_page[page]._segs[seg];
 				wk1 = dev->_page[page+1]._segs[seg];
@@ -418,8 +428,8 @@ void ssd1306_wrap_arround(SSD1306_t * dev, ssd1306_scroll_type_t scroll, int sta
 			}
 		}
 		// Page7
-		int pages = dev->_pages-1;
-		//for (int seg=0;seg<128;seg++) {
+		int pages = SSD1306_DEV_PAGES(dev)-1;
+		//for (int seg=0;seg<SSD1306_WIDTH;seg++) {
 		for (int seg=_start;seg<=_end;seg++) {
 			wk0 = dev->_page[pages]._segs[seg];
 			wk1 = save[seg];
@@ -436,19 +446,19 @@ void ssd1306_wrap_arround(SSD1306_t * dev, ssd1306_scroll_type_t scroll, int sta
 	} else if (scroll == SCROLL_DOWN) {
 		int _start = start; // 0 to {width-1}
 		int _end = end; // 0 to {width-1}
-		if (_end >= dev->_width) _end = dev->_width - 1;
+		if (_end >= SSD1306_DEV_WIDTH(dev)) _end = SSD1306_DEV_WIDTH(dev) - 1;
 		uint8_t wk0;
 		uint8_t wk1;
 		uint8_t wk2;
-		uint8_t save[128];
+		uint8_t save[SSD1306_WIDTH];
 		// Save pages 7
-		int pages = dev->_pages-1;
-		for (int seg=0;seg<128;seg++) {
+		int pages = SSD1306_DEV_PAGES(dev)-1;
+		for (int seg=0;seg<SSD1306_WIDTH;seg++) {
 			save[seg] = dev->_page[pages]._segs[seg];
 		}
 		// Page7 to Page1
 		for (int page=pages;page>0;page--) {
-			//for (int seg=0;seg<128;seg++) {
+			//for (int seg=0;seg<SSD1306_WIDTH;seg++) {
 			for (int seg=_start;seg<=_end;seg++) {
 				wk0 = dev->_page[page]._segs[seg];
 				wk1 = dev->_page[page-1]._segs[seg];
@@ -469,7 +479,7 @@ void ssd1306_wrap_arround(SSD1306_t * dev, ssd1306_scroll_type_t scroll, int sta
 			}
 		}
 		// Page0
-		//for (int seg=0;seg<128;seg++) {
+		//for (int seg=0;seg<SSD1306_WIDTH;seg++) {
 		for (int seg=_start;seg<=_end;seg++) {
 			wk0 = dev->_page[0]._segs[seg];
 			wk1 = save[seg];
@@ -484,46 +494,46 @@ void ssd1306_wrap_arround(SSD1306_t * dev, ssd1306_scroll_type_t scroll, int sta
 		}
 
 	} else if (scroll == PAGE_SCROLL_DOWN) {
-		uint8_t save[128];
+		uint8_t save[SSD1306_WIDTH];
 		// Save pages 7
-		for (int seg=0;seg<128;seg++) {
-			save[seg] = dev->_page[dev->_pages-1]._segs[seg];
+		for (int seg=0;seg<SSD1306_WIDTH;seg++) {
+			save[seg] = dev->_page[SSD1306_DEV_PAGES(dev)-1]._segs[seg];
 		}
 		// Page7 to Page1
-		for (int page=dev->_pages-1;page>0;page--) {
-			for (int seg=0;seg<128;seg++) {
+		for (int page=SSD1306_DEV_PAGES(dev)-1;page>0;page--) {
+			for (int seg=0;seg<SSD1306_WIDTH;seg++) {
 				dev->_page[page]._segs[seg] = dev->_page[page-1]._segs[seg];
 			}
 		}
 		// Store  pages 0
-		for (int seg=0;seg<128;seg++) {
+		for (int seg=0;seg<SSD1306_WIDTH;seg++) {
 			dev->_page[0]._segs[seg] = save[seg];
 		}
 
 	} else if (scroll == PAGE_SCROLL_UP) {
-		uint8_t save[128];
+		uint8_t save[SSD1306_WIDTH];
 		// Save pages 0
-		for (int seg=0;seg<128;seg++) {
+		for (int seg=0;seg<SSD1306_WIDTH;seg++) {
 			save[seg] = dev->_page[0]._segs[seg];
 		}
 		// Page0 to Page6
-		for (int page=0;page<dev->_pages-1;page++) {
-			for (int seg=0;seg<128;seg++) {
+		for (int page=0;page<SSD1306_DEV_PAGES(dev)-1;page++) {
+			for (int seg=0;seg<SSD1306_WIDTH;seg++) {
 				dev->_page[page]._segs[seg] = dev->_page[page+1]._segs[seg];
 			}
 		}
 		// Store  pages 7
-		for (int seg=0;seg<128;seg++) {
-			dev->_page[dev->_pages-1]._segs[seg] = save[seg];
+		for (int seg=0;seg<SSD1306_WIDTH;seg++) {
+			dev->_page[SSD1306_DEV_PAGES(dev)-1]._segs[seg] = save[seg];
 		}
 	}
 
 	if (delay >= 0) {
-		for (int page=0;page<dev->_pages;page++) {
+		for (int page=0;page<SSD1306_DEV_PAGES(dev);page++) {
 			if (dev->_address == SPI_ADDRESS) {
-				spi_display_image(dev, page, 0, dev->_page[page]._segs, 128);
+				spi_display_image(dev, page, 0, dev->_page[page]._segs, SSD1306_WIDTH);
 			} else {
-				i2c_display_image(dev, page, 0, dev->_page[page]._segs, 128);
+				i2c_display_image(dev, page, 0, dev->_page[page]._segs, SSD1306_WIDTH);
 			}
 			if (delay) vTaskDelay(delay);
 		}
@@ -560,11 +570,11 @@ void _ssd1306_bitmaps(SSD1306_t * dev, int xpos, int ypos, const uint8_t * bitma
 				if (dev->_flip) wk2 = ssd1306_rotate_byte(wk2);
 
 				ESP_LOGD(__FUNCTION__, "index=%d offset=%d wk1=0x%x page=%d _seg=%d, wk2=%02x", index, offset, wk1, page, _seg, wk2);
-				if (_seg >= 128) {
+				if (_seg >= SSD1306_WIDTH) {
 					ESP_LOGW(__FUNCTION__, "segment is out of range");
 					break;
 				}
-				if (page >= dev->_pages) {
+				if (page >= SSD1306_DEV_PAGES(dev)) {
 					ESP_LOGW(__FUNCTION__, "page is out of range");
 					break;
 				}
@@ -597,7 +607,12 @@ void _ssd1306_bitmaps(SSD1306_t * dev, int xpos, int ypos, const uint8_t * bitma
 void ssd1306_bitmaps(SSD1306_t * dev, int xpos, int ypos, const uint8_t * bitmap, int width, int height, bool invert)
 {
 	_ssd1306_bitmaps(dev, xpos, ypos, bitmap, width, height, invert);
-	
+	ssd1306_show_area(dev, xpos, ypos, width, height);
+}
+
+// Send the pages covering the given area from the internal buffer
+void ssd1306_show_area(SSD1306_t * dev, int xpos, int ypos, int width, int height)
+{
 	// Calculate the range of pages and segments to update
 	int start_page = ypos / 8;
 	int end_page = (ypos + height - 1) / 8;
@@ -607,7 +622,7 @@ void ssd1306_bitmaps(SSD1306_t * dev, int xpos, int ypos, const uint8_t * bitmap
 	// Update only the modified pages and segments
 	for (int page = start_page; page <= end_page; page++) {
 		int seg_start = (page == start_page) ? start_seg : 0;
-		int seg_end = (page == end_page) ? end_seg : 127;
+		int seg_end = (page == end_page) ? end_seg : SSD1306_WIDTH-1;
 		int seg_width = seg_end - seg_start + 1;
 		ssd1306_display_image(dev, page, seg_start, &dev->_page[page]._segs[seg_start], seg_width);
 	}
@@ -804,7 +819,7 @@ void ssd1306_fadeout(SSD1306_t * dev)
 	}
 
 	uint8_t image[1];
-	for(int page=0; page<dev->_pages; page++) {
+	for(int page=0; page<SSD1306_DEV_PAGES(dev); page++) {
 		image[0] = 0xFF;
 		for(int line=0; line<8; line++) {
 			if (dev->_flip) {
@@ -812,7 +827,7 @@ void ssd1306_fadeout(SSD1306_t * dev)
 			} else {
 				image[0] = image[0] << 1;
 			}
-			for(int seg=0; seg<128; seg++) {
+			for(int seg=0; seg<SSD1306_WIDTH; seg++) {
 				(*func)(dev, page, seg, image, 1);
 				dev->_page[page]._segs[seg] = image[0];
 			}
@@ -854,7 +869,7 @@ void ssd1306_display_rotate_text(SSD1306_t * dev, int seg, const char * text, in
 	int _text_len = text_len;
 	if (_text_len > 8) _text_len = 8;
 	uint8_t image[8];
-	int _page = dev->_pages-1;
+	int _page = SSD1306_DEV_PAGES(dev)-1;
 	for (uint8_t i = 0; i < _text_len; i++) {
 		memcpy(image, font8x8_basic_tr[(uint8_t)text[i]], 8);
 		ssd1306_rotate_image(image, dev->_flip);
@@ -113,10 +113,30 @@ typedef enum {
 	SCROLL_STOP = 7
 } ssd1306_scroll_type_t;
 
+// Panel geometry from the Kconfig panel choice
+#define SSD1306_WIDTH 128
+#if CONFIG_SSD1306_128x32
+#define SSD1306_HEIGHT 32
+#else
+#define SSD1306_HEIGHT 64
+#endif
+#define SSD1306_PAGES (SSD1306_HEIGHT / 8)
+
+// With CONFIG_SSD1306_STATIC_GEOMETRY the page buffer is sized for the selected
+// panel only and loop bounds are compile-time constants, so the compiler can
+// unroll the framebuffer kernels. Otherwise any panel can be used at runtime.
+#if CONFIG_SSD1306_STATIC_GEOMETRY
+#define SSD1306_MAX_PAGES SSD1306_PAGES
+#define SSD1306_DEV_PAGES(dev) SSD1306_PAGES
+#define SSD1306_DEV_WIDTH(dev) SSD1306_WIDTH
+#else
+#define SSD1306_MAX_PAGES 8
+#define SSD1306_DEV_PAGES(dev) ((dev)->_pages)
+#define SSD1306_DEV_WIDTH(dev) ((dev)->_width)
+#endif
+
 typedef struct {
-	bool _valid; // Not using it anymore
-	int _segLen; // Not using it anymore
-	uint8_t _segs[128];
+	uint8_t _segs[SSD1306_WIDTH];
 } PAGE_t;
 
 typedef struct {
@@ -129,16 +149,19 @@ typedef struct {
 	int _scStart;
 	int _scEnd;
 	int _scDirection;
-	PAGE_t _page[8];
+	PAGE_t _page[SSD1306_MAX_PAGES];
 	bool _flip;
 	i2c_port_t _i2c_num;
 	spi_device_handle_t _spi_device_handle;
 #if (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0))
 	i2c_master_bus_handle_t _i2c_bus_handle;
-	i2c_master_dev_handle_t _i2c_dev_handle;
+	struct i2c_bus_dev_s *_i2c_bus_dev;
 #endif
 } SSD1306_t;
 
+// Reads up to len bytes of a compressed bitmap; returns the number of bytes read, 0 at the end
+typedef int (*ssd1306_rle_read_t)(void * ctx, uint8_t * buf, int len);
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -168,6 +191,10 @@ void ssd1306_hardware_scroll(SSD1306_t * dev, ssd1306_scroll_type_t scroll);
 void ssd1306_wrap_arround(SSD1306_t * dev, ssd1306_scroll_type_t scroll, int start, int end, int8_t delay);
 void _ssd1306_bitmaps(SSD1306_t * dev, int xpos, int ypos, const uint8_t * bitmap, int width, int height, bool invert);
 void ssd1306_bitmaps(SSD1306_t * dev, int xpos, int ypos, const uint8_t * bitmap, int width, int height, bool invert);
+void ssd1306_show_area(SSD1306_t * dev, int xpos, int ypos, int width, int height);
+esp_err_t _ssd1306_bitmaps_rle_stream(SSD1306_t * dev, int xpos, int ypos, ssd1306_rle_read_t read, void * ctx, bool invert, int * width, int * height);
+esp_err_t ssd1306_bitmaps_rle(SSD1306_t * dev, int xpos, int ypos, const uint8_t * data, size_t len, bool invert);
+esp_err_t ssd1306_bitmaps_rle_file(SSD1306_t * dev, int xpos, int ypos, const char * path, bool invert);
 void _ssd1306_pixel(SSD1306_t * dev, int xpos, int ypos, bool invert);
 void _ssd1306_line(SSD1306_t * dev, int x1, int y1, int x2, int y2,  bool invert);
 void _ssd1306_circle(SSD1306_t * dev, int x0, int y0, int r, unsigned int opt, bool invert);
@@ -184,6 +211,9 @@ void ssd1306_dump(SSD1306_t dev);
 void ssd1306_dump_page(SSD1306_t * dev, int page, int seg);
 
 void i2c_master_init(SSD1306_t * dev, int16_t sda, int16_t scl, int16_t reset);
+// With the new I2C driver the bus of i2c_num must already exist in i2c_bus
+// (i2c_bus_init(), or i2c_master_init() of another display). A bus created
+// directly with i2c_new_master_bus() is no longer picked up: this aborts.
 void i2c_device_add(SSD1306_t * dev, i2c_port_t i2c_num, int16_t reset, uint16_t i2c_address);
 void i2c_init(SSD1306_t * dev, int width, int height);
 void i2c_display_image(SSD1306_t * dev, int page, int seg, const uint8_t * images, int width);
@@ -6,6 +6,7 @@
 #include "driver/i2c_master.h"
 #include "esp_log.h"
 
+#include "i2c_bus.h"
 #include "ssd1306.h"
 
 #define TAG "SSD1306"
@@ -19,29 +20,16 @@
 #endif
 
 #define I2C_MASTER_FREQ_HZ 400000 // I2C clock of SSD1306 can run at 400 kHz max.
-#define I2C_TICKS_TO_WAIT 100	  // Maximum ticks to wait before issuing a timeout.
+#define I2C_TICKS_TO_WAIT 100	  // Maximum ms to wait for the bus and the transfer.
 
+// The bus belongs to i2c_bus: the display is one more client, with low
+// priority so that sensor transfers on the same bus are served between pages.
 void i2c_master_init(SSD1306_t * dev, int16_t sda, int16_t scl, int16_t reset)
 {
 	ESP_LOGI(TAG, "New i2c driver is used");
-	i2c_master_bus_config_t i2c_mst_config = {
-		.clk_source = I2C_CLK_SRC_DEFAULT,
-		.glitch_ignore_cnt = 7,
-		.i2c_port = I2C_NUM,
-		.scl_io_num = scl,
-		.sda_io_num = sda,
-		.flags.enable_internal_pullup = true,
-	};
-	i2c_master_bus_handle_t i2c_bus_handle;
-	ESP_ERROR_CHECK(i2c_new_master_bus(&i2c_mst_config, &i2c_bus_handle));
-
-	i2c_device_config_t dev_cfg = {
-		.dev_addr_length = I2C_ADDR_BIT_LEN_7,
-		.device_address = I2C_ADDRESS,
-		.scl_speed_hz = I2C_MASTER_FREQ_HZ,
-	};
-	i2c_master_dev_handle_t i2c_dev_handle;
-	ESP_ERROR_CHECK(i2c_master_bus_add_device(i2c_bus_handle, &dev_cfg, &i2c_dev_handle));
+	ESP_ERROR_CHECK(i2c_bus_init(I2C_NUM, sda, scl));
+	ESP_ERROR_CHECK(i2c_bus_get_handle(I2C_NUM, &dev->_i2c_bus_handle));
+	ESP_ERROR_CHECK(i2c_bus_add_device(I2C_NUM, I2C_ADDRESS, I2C_MASTER_FREQ_HZ, I2C_BUS_PRIO_LOW, &dev->_i2c_bus_dev));
 
 	if (reset >= 0) {
 		//gpio_pad_select_gpio(reset);
@@ -55,34 +43,20 @@ void i2c_master_init(SSD1306_t * dev, int16_t sda, int16_t scl, int16_t reset)
 	dev->_address = I2C_ADDRESS;
 	dev->_flip = false;
 	dev->_i2c_num = I2C_NUM;
-	dev->_i2c_bus_handle = i2c_bus_handle;
-	dev->_i2c_dev_handle = i2c_dev_handle;
 }
 
 void i2c_device_add(SSD1306_t * dev, i2c_port_t i2c_num, int16_t reset, uint16_t i2c_address)
 {
 	ESP_LOGI(TAG, "New i2c driver is used");
 	ESP_LOGW(TAG, "Will not install i2c master driver");
-#if 0
-	i2c_master_bus_config_t i2c_mst_config = {
-		.clk_source = I2C_CLK_SRC_DEFAULT,
-		.glitch_ignore_cnt = 7,
-		.i2c_port = I2C_NUM,
-		.scl_io_num = scl,
-		.sda_io_num = sda,
-		.flags.enable_internal_pullup = true,
-	};
-	i2c_master_bus_handle_t i2c_bus_handle;
-	ESP_ERROR_CHECK(i2c_new_master_bus(&i2c_mst_config, &i2c_bus_handle));
-#endif
-
-	i2c_device_config_t dev_cfg = {
-		.dev_addr_length = I2C_ADDR_BIT_LEN_7,
-		.device_address = i2c_address,
-		.scl_speed_hz = I2C_MASTER_FREQ_HZ,
-	};
-	i2c_master_dev_handle_t i2c_dev_handle;
-	ESP_ERROR_CHECK(i2c_master_bus_add_device(dev->_i2c_bus_handle, &dev_cfg, &i2c_dev_handle));
+	// The bus must have been created with i2c_bus_init(); one created
+	// directly with i2c_new_master_bus() is not arbitrated and cannot be used
+	esp_err_t ret = i2c_bus_get_handle(i2c_num, &dev->_i2c_bus_handle);
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "No i2c_bus on port %d, call i2c_bus_init() first", i2c_num);
+	}
+	ESP_ERROR_CHECK(ret);
+	ESP_ERROR_CHECK(i2c_bus_add_device(i2c_num, i2c_address, I2C_MASTER_FREQ_HZ, I2C_BUS_PRIO_LOW, &dev->_i2c_bus_dev));
 
 	if (reset >= 0) {
 		//gpio_pad_select_gpio(reset);
@@ -96,7 +70,6 @@ void i2c_device_add(SSD1306_t * dev, i2c_port_t i2c_num, int16_t reset, uint16_t
 	dev->_address = i2c_address;
 	dev->_flip = false;
 	dev->_i2c_num = i2c_num;
-	dev->_i2c_dev_handle = i2c_dev_handle;
 }
 
 void i2c_init(SSD1306_t * dev, int width, int height) {
@@ -147,7 +120,7 @@ void i2c_init(SSD1306_t * dev, int width, int height) {
 	out_buf[out_index++] = OLED_CMD_DISPLAY_ON;				// AF
 
 	esp_err_t res;
-	res = i2c_master_transmit(dev->_i2c_dev_handle, out_buf, out_index, I2C_TICKS_TO_WAIT);
+	res = i2c_bus_transmit(dev->_i2c_bus_dev, out_buf, out_index, I2C_TICKS_TO_WAIT);
 	if (res == ESP_OK) {
 		ESP_LOGI(TAG, "OLED configured successfully");
 	} else {
@@ -185,14 +158,14 @@ void i2c_display_image(SSD1306_t * dev, int page, int seg, const uint8_t * image
 	out_buf[out_index++] = 0xB0 | _page;
 
 	esp_err_t res;
-	res = i2c_master_transmit(dev->_i2c_dev_handle, out_buf, out_index, I2C_TICKS_TO_WAIT);
+	res = i2c_bus_transmit(dev->_i2c_bus_dev, out_buf, out_index, I2C_TICKS_TO_WAIT);
 	if (res != ESP_OK)
 		ESP_LOGE(TAG, "Could not write to device [0x%02x at %d]: %d (%s)", dev->_address, dev->_i2c_num, res, esp_err_to_name(res));
 
 	out_buf[0] = OLED_CONTROL_BYTE_DATA_STREAM;
 	memcpy(&out_buf[1], images, width);
 
-	res = i2c_master_transmit(dev->_i2c_dev_handle, out_buf, width + 1, I2C_TICKS_TO_WAIT);
+	res = i2c_bus_transmit(dev->_i2c_bus_dev, out_buf, width + 1, I2C_TICKS_TO_WAIT);
 	if (res != ESP_OK)
 		ESP_LOGE(TAG, "Could not write to device [0x%02x at %d]: %d (%s)", dev->_address, dev->_i2c_num, res, esp_err_to_name(res));
 	free(out_buf);
@@ -209,7 +182,7 @@ void i2c_contrast(SSD1306_t * dev, int contrast) {
 	out_buf[out_index++] = OLED_CMD_SET_CONTRAST; // 81
 	out_buf[out_index++] = _contrast;
 
-	esp_err_t res = i2c_master_transmit(dev->_i2c_dev_handle, out_buf, 3, I2C_TICKS_TO_WAIT);
+	esp_err_t res = i2c_bus_transmit(dev->_i2c_bus_dev, out_buf, 3, I2C_TICKS_TO_WAIT);
 	if (res != ESP_OK)
 		ESP_LOGE(TAG, "Could not write to device [0x%02x at %d]: %d (%s)", dev->_address, dev->_i2c_num, res, esp_err_to_name(res));
 }
@@ -284,7 +257,7 @@ void i2c_hardware_scroll(SSD1306_t * dev, ssd1306_scroll_type_t scroll) {
 		out_buf[out_index++] = OLED_CMD_DEACTIVE_SCROLL; // 2E
 	}
 
-	esp_err_t res = i2c_master_transmit(dev->_i2c_dev_handle, out_buf, out_index, I2C_TICKS_TO_WAIT);
+	esp_err_t res = i2c_bus_transmit(dev->_i2c_bus_dev, out_buf, out_index, I2C_TICKS_TO_WAIT);
 	if (res != ESP_OK)
 		ESP_LOGE(TAG, "Could not write to device [0x%02x at %d]: %d (%s)", dev->_address, dev->_i2c_num, res, esp_err_to_name(res));
 }
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "ssd1306.h"
+
+/*
+ Compressed 1bpp bitmap (see tools/bmp2rle.py)
+
+ Header (4 bytes):
+   'R' '1' width height
+ Payload:
+   Row-major bitmap, MSB is the leftmost pixel, width/8 bytes per row,
+   packed with PackBits:
+     n = 0..127    : copy the next n+1 bytes
+     n = 129..255  : repeat the next byte 257-n times
+     n = 128       : no-op
+   Runs may span rows.
+*/
+
+#define RLE_READ_CHUNK 32
+
+typedef struct {
+	ssd1306_rle_read_t read;
+	void * ctx;
+	uint8_t buf[RLE_READ_CHUNK];
+	int len;
+	int pos;
+	int literal;	// literal bytes left in the current packet
+	int repeat;		// repetitions left in the current packet
+	uint8_t value;	// repeated byte
+} rle_stream_t;
+
+static bool rle_next_byte(rle_stream_t * s, uint8_t * out)
+{
+	if (s->pos == s->len) {
+		s->len = s->read(s->ctx, s->buf, sizeof(s->buf));
+		s->pos = 0;
+		if (s->len <= 0) {
+			s->len = 0;
+			return false;
+		}
+	}
+	*out = s->buf[s->pos++];
+	return true;
+}
+
+static bool rle_decode_row(rle_stream_t * s, uint8_t * row, int row_bytes)
+{
+	int index = 0;
+	while (index < row_bytes) {
+		if (s->repeat) {
+			int n = s->repeat;
+			if (n > row_bytes - index) n = row_bytes - index;
+			memset(&row[index], s->value, n);
+			index += n;
+			s->repeat -= n;
+		} else if (s->literal) {
+			if (!rle_next_byte(s, &row[index])) return false;
+			index++;
+			s->literal--;
+		} else {
+			uint8_t n;
+			if (!rle_next_byte(s, &n)) return false;
+			if (n < 128) {
+				s->literal = n + 1;
+			} else if (n > 128) {
+				if (!rle_next_byte(s, &s->value)) return false;
+				s->repeat = 257 - n;
+			}
+		}
+	}
+	return true;
+}
+
+esp_err_t _ssd1306_bitmaps_rle_stream(SSD1306_t * dev, int xpos, int ypos, ssd1306_rle_read_t read, void * ctx, bool invert, int * width, int * height)
+{
+	rle_stream_t s = { .read = read, .ctx = ctx };
+	uint8_t header[4];
+	for (int i = 0; i < sizeof(header); i++) {
+		if (!rle_next_byte(&s, &header[i])) {
+			ESP_LOGE(__FUNCTION__, "truncated header");
+			return ESP_ERR_INVALID_SIZE;
+		}
+	}
+	if (header[0] != 'R' || header[1] != '1') {
+		ESP_LOGE(__FUNCTION__, "bad magic");
+		return ESP_ERR_INVALID_ARG;
+	}
+	int _width = header[2];
+	int _height = header[3];
+	if (_width == 0 || (_width % 8) != 0 || _width > SSD1306_WIDTH) {
+		ESP_LOGE(__FUNCTION__, "width must be a multiple of 8 up to panel width");
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	// Decode one row at a time straight into the page buffer
+	uint8_t row[SSD1306_WIDTH / 8];
+	for (int y = 0; y < _height; y++) {
+		if (!rle_decode_row(&s, row, _width / 8)) {
+			ESP_LOGE(__FUNCTION__, "truncated data at row %d", y);
+			return ESP_ERR_INVALID_SIZE;
+		}
+		_ssd1306_bitmaps(dev, xpos, ypos + y, row, _width, 1, invert);
+	}
+	if (width) *width = _width;
+	if (height) *height = _height;
+	return ESP_OK;
+}
+
+typedef struct {
+	const uint8_t * data;
+	size_t len;
+	size_t pos;
+} rle_mem_t;
+
+static int rle_mem_read(void * ctx, uint8_t * buf, int len)
+{
+	rle_mem_t * m = ctx;
+	size_t n = m->len - m->pos;
+	if (n > len) n = len;
+	memcpy(buf, &m->data[m->pos], n);
+	m->pos += n;
+	return n;
+}
+
+esp_err_t ssd1306_bitmaps_rle(SSD1306_t * dev, int xpos, int ypos, const uint8_t * data, size_t len, bool invert)
+{
+	rle_mem_t m = { .data = data, .len = len };
+	int width, height;
+	esp_err_t ret = _ssd1306_bitmaps_rle_stream(dev, xpos, ypos, rle_mem_read, &m, invert, &width, &height);
+	if (ret == ESP_OK) ssd1306_show_area(dev, xpos, ypos, width, height);
+	return ret;
+}
+
+static int rle_file_read(void * ctx, uint8_t * buf, int len)
+{
+	return fread(buf, 1, len, (FILE *)ctx);
+}
+
+// Load the image lazily, RLE_READ_CHUNK bytes at a time, e.g. from "/spiffs/logo.rle"
+esp_err_t ssd1306_bitmaps_rle_file(SSD1306_t * dev, int xpos, int ypos, const char * path, bool invert)
+{
+	FILE * f = fopen(path, "rb");
+	if (f == NULL) {
+		ESP_LOGE(__FUNCTION__, "Failed to open %s", path);
+		return ESP_ERR_NOT_FOUND;
+	}
+	int width, height;
+	esp_err_t ret = _ssd1306_bitmaps_rle_stream(dev, xpos, ypos, rle_file_read, f, invert, &width, &height);
+	fclose(f);
+	if (ret == ESP_OK) ssd1306_show_area(dev, xpos, ypos, width, height);
+	return ret;
+}
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+Archivo: bmp2rle.py
+Descripción: Convierte imágenes PBM (P1/P4) al formato de bitmap comprimido
+             que decodifican ssd1306_bitmaps_rle() y ssd1306_bitmaps_rle_file().
+
+Uso:
+    bmp2rle.py logo.pbm -o storage/logo.rle        # fichero para SPIFFS
+    bmp2rle.py logo.pbm -c logo_rle -o logo_rle.h  # array C para flash
+
+Para convertir desde PNG u otros formatos:
+    convert logo.png -monochrome logo.pbm
+
+Formato: cabecera 'R' '1' ancho alto, seguida del bitmap fila a fila (MSB a la
+izquierda, ancho/8 bytes por fila) comprimido con PackBits.
+"""
+
+import argparse
+import sys
+
+
+def read_pbm(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    tokens = []
+    pos = 0
+    # Cabecera: magic, ancho, alto (con comentarios '#')
+    while len(tokens) < 3:
+        while data[pos:pos + 1].isspace():
+            pos += 1
+        if data[pos:pos + 1] == b'#':
+            while data[pos:pos + 1] not in (b'\n', b''):
+                pos += 1
+            continue
+        start = pos
+        while not data[pos:pos + 1].isspace():
+            pos += 1
+        tokens.append(data[start:pos])
+    magic, width, height = tokens[0], int(tokens[1]), int(tokens[2])
+    row_bytes = (width + 7) // 8
+
+    if magic == b'P4':
+        pos += 1  # un único espacio tras la cabecera
+        raw = data[pos:pos + row_bytes * height]
+        rows = [raw[y * row_bytes:(y + 1) * row_bytes] for y in range(height)]
+    elif magic == b'P1':
+        bits = [c for c in data[pos:].decode('ascii') if c in '01']
+        rows = []
+        for y in range(height):
+            row = bytearray(row_bytes)
+            for x in range(width):
+                if bits[y * width + x] == '1':
+                    row[x // 8] |= 0x80 >> (x % 8)
+            rows.append(bytes(row))
+    else:
+        raise ValueError('%s: solo se admiten PBM P1/P4' % path)
+    return width, height, rows
+
+
+def packbits(data):
+    out = bytearray()
+    i = 0
+    n = len(data)
+    while i < n:
+        run = 1
+        while i + run < n and run < 128 and data[i + run] == data[i]:
+            run += 1
+        if run >= 2:
+            out.append(257 - run)
+            out.append(data[i])
+            i += run
+            continue
+        start = i
+        i += 1
+        while i < n and i - start < 128:
+            if i + 1 < n and data[i] == data[i + 1]:
+                break
+            i += 1
+        out.append(i - start - 1)
+        out.extend(data[start:i])
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('input', help='imagen PBM de entrada')
+    parser.add_argument('-o', '--output', required=True, help='fichero de salida')
+    parser.add_argument('-c', '--c-array', metavar='NAME',
+                        help='generar una cabecera C con un array NAME')
+    parser.add_argument('--invert', action='store_true',
+                        help='invertir los píxeles (PBM: 1 = negro)')
+    args = parser.parse_args()
+
+    width, height, rows = read_pbm(args.input)
+    if width % 8 or width > 128 or height > 255:
+        sys.exit('el ancho debe ser múltiplo de 8 (máx. 128) y el alto <= 255')
+
+    bitmap = b''.join(rows)
+    if args.invert:
+        bitmap = bytes(b ^ 0xFF for b in bitmap)
+    blob = bytes([ord('R'), ord('1'), width, height]) + packbits(bitmap)
+
+    if args.c_array:
+        lines = ['// Generado por bmp2rle.py desde %s (%dx%d, %d -> %d bytes)'
+                 % (args.input, width, height, len(bitmap), len(blob)),
+                 '#include <stdint.h>', '',
+                 'static const uint8_t %s[%d] = {' % (args.c_array, len(blob))]
+        for i in range(0, len(blob), 12):
+            lines.append('\t' + ', '.join('0x%02x' % b for b in blob[i:i + 12]) + ',')
+        lines.append('};')
+        with open(args.output, 'w') as f:
+            f.write('\n'.join(lines) + '\n')
+    else:
+        with open(args.output, 'wb') as f:
+            f.write(blob)
+
+    print('%s: %dx%d, %d -> %d bytes' % (args.output, width, height, len(bitmap), len(blob)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,6 @@
+// Host stand-in for the ESP-IDF header
+#pragma once
+#include "esp_err.h"
+
+typedef int i2c_port_t;
+typedef struct i2c_master_bus_t * i2c_master_bus_handle_t;
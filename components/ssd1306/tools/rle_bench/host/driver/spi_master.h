@@ -0,0 +1,5 @@
+// Host stand-in for the ESP-IDF header
+#pragma once
+#include "esp_err.h"
+
+typedef struct spi_device_t * spi_device_handle_t;
@@ -0,0 +1,9 @@
+// Host stand-in for the ESP-IDF header: errors go to stderr, the rest is dropped
+#pragma once
+#include <stdio.h>
+#include "esp_err.h"
+
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) do {} while (0)
+#define ESP_LOGD(tag, fmt, ...) do {} while (0)
@@ -0,0 +1,5 @@
+// Host stand-in for the FreeRTOS header
+#pragma once
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
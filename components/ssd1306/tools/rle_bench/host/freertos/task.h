@@ -0,0 +1,5 @@
+// Host stand-in for the FreeRTOS header
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+void vTaskDelay(TickType_t ticks);
@@ -0,0 +1,146 @@
+/*
+ Host bench for the compressed bitmap decoder (ssd1306_rle.c)
+
+ Draws logo.pbm with ssd1306_bitmaps() and, compressed by bmp2rle.py, with
+ ssd1306_bitmaps_rle() and ssd1306_bitmaps_rle_file(), checks that the page
+ buffers are identical and that truncated or malformed input is rejected,
+ then times both paths per frame. The panel transport is stubbed out, so
+ the times are decode + render into the page buffer only.
+
+ Usage (from this directory):
+   make run
+   make run CFLAGS="-O2 -m32"   # closer to a 32-bit target
+
+ Exits non-zero if any check fails.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "ssd1306.h"
+
+#include "logo_rle.h"
+
+#define FRAMES 20000
+
+// Panel transport stubs: count what would be sent
+static long flushed;
+
+void spi_init(SSD1306_t * dev, int width, int height) {}
+void i2c_init(SSD1306_t * dev, int width, int height) {}
+void spi_display_image(SSD1306_t * dev, int page, int seg, const uint8_t * images, int width) { flushed += width; }
+void i2c_display_image(SSD1306_t * dev, int page, int seg, const uint8_t * images, int width) { flushed += width; }
+void spi_contrast(SSD1306_t * dev, int contrast) {}
+void i2c_contrast(SSD1306_t * dev, int contrast) {}
+void spi_hardware_scroll(SSD1306_t * dev, ssd1306_scroll_type_t scroll) {}
+void i2c_hardware_scroll(SSD1306_t * dev, ssd1306_scroll_type_t scroll) {}
+void vTaskDelay(TickType_t ticks) {}
+
+static int failures;
+
+static void check(bool ok, const char * what)
+{
+	printf("%-40s %s\n", what, ok ? "ok" : "FAIL");
+	if (!ok) failures++;
+}
+
+// Reads a P4 (binary) PBM; returns the bitmap size in bytes, 0 on error
+static size_t read_pbm(const char * path, uint8_t * bitmap, size_t size, int * width, int * height)
+{
+	FILE * f = fopen(path, "rb");
+	if (f == NULL) return 0;
+	size_t len = 0;
+	if (fscanf(f, "P4 %d %d", width, height) == 2 && fgetc(f) != EOF) {
+		len = (size_t)(*width / 8) * *height;
+		if (len > size || fread(bitmap, 1, len, f) != len) len = 0;
+	}
+	fclose(f);
+	return len;
+}
+
+static void panel_init(SSD1306_t * dev)
+{
+	memset(dev, 0, sizeof(*dev));
+	dev->_address = SPI_ADDRESS;
+	dev->_width = SSD1306_WIDTH;
+	dev->_height = SSD1306_HEIGHT;
+	dev->_pages = SSD1306_PAGES;
+}
+
+static double now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int main(void)
+{
+	static SSD1306_t raw, rle;
+	uint8_t bitmap[SSD1306_WIDTH / 8 * SSD1306_HEIGHT];
+	int width, height;
+
+	// Keep the decoder errors next to the check that triggers them
+	setvbuf(stdout, NULL, _IOLBF, 0);
+
+	size_t raw_len = read_pbm("logo.pbm", bitmap, sizeof(bitmap), &width, &height);
+	if (raw_len == 0) {
+		fprintf(stderr, "logo.pbm: not a %dx%d P4 PBM\n", SSD1306_WIDTH, SSD1306_HEIGHT);
+		return 2;
+	}
+	printf("logo.pbm %dx%d: %zu -> %zu bytes\n\n", width, height, raw_len, sizeof(logo_rle));
+
+	panel_init(&raw);
+	panel_init(&rle);
+	ssd1306_bitmaps(&raw, 0, 0, bitmap, width, height, false);
+
+	check(ssd1306_bitmaps_rle(&rle, 0, 0, logo_rle, sizeof(logo_rle), false) == ESP_OK &&
+		memcmp(raw._page, rle._page, sizeof(raw._page)) == 0, "rle matches raw");
+
+	panel_init(&rle);
+	check(ssd1306_bitmaps_rle_file(&rle, 0, 0, "logo.rle", false) == ESP_OK &&
+		memcmp(raw._page, rle._page, sizeof(raw._page)) == 0, "rle file matches raw");
+
+	panel_init(&raw);
+	panel_init(&rle);
+	ssd1306_bitmaps(&raw, 0, 0, bitmap, width, height, true);
+	check(ssd1306_bitmaps_rle(&rle, 0, 0, logo_rle, sizeof(logo_rle), true) == ESP_OK &&
+		memcmp(raw._page, rle._page, sizeof(raw._page)) == 0, "inverted rle matches raw");
+
+	check(ssd1306_bitmaps_rle(&rle, 0, 0, logo_rle, 3, false) == ESP_ERR_INVALID_SIZE, "truncated header rejected");
+	check(ssd1306_bitmaps_rle(&rle, 0, 0, logo_rle, sizeof(logo_rle) - 1, false) == ESP_ERR_INVALID_SIZE, "truncated data rejected");
+
+	uint8_t bad[sizeof(logo_rle)];
+	memcpy(bad, logo_rle, sizeof(bad));
+	bad[0] = 'P';
+	check(ssd1306_bitmaps_rle(&rle, 0, 0, bad, sizeof(bad), false) == ESP_ERR_INVALID_ARG, "bad magic rejected");
+	memcpy(bad, logo_rle, sizeof(bad));
+	bad[2] = 12;
+	check(ssd1306_bitmaps_rle(&rle, 0, 0, bad, sizeof(bad), false) == ESP_ERR_INVALID_ARG, "bad width rejected");
+
+	if (failures) {
+		printf("\n%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	double t = now_us();
+	for (int i = 0; i < FRAMES; i++) {
+		ssd1306_bitmaps(&raw, 0, 0, bitmap, width, height, false);
+	}
+	double raw_us = (now_us() - t) / FRAMES;
+
+	t = now_us();
+	for (int i = 0; i < FRAMES; i++) {
+		ssd1306_bitmaps_rle(&rle, 0, 0, logo_rle, sizeof(logo_rle), false);
+	}
+	double rle_us = (now_us() - t) / FRAMES;
+
+	printf("\nraw %.2f us/frame, rle %.2f us/frame (%d frames, %ld bytes flushed)\n",
+		raw_us, rle_us, FRAMES, flushed);
+	return 0;
+}
@@ -0,0 +1,92 @@
+/* Archivo: cbor_writer.c
+ * Descripción: Escritura de CBOR sin memoria dinámica. Ver cbor_writer.h.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "cbor_writer.h"
+
+#include <string.h>
+
+#define MAJOR_UINT 0
+#define MAJOR_NEGINT 1
+#define MAJOR_TEXT 3
+#define MAJOR_ARRAY 4
+#define MAJOR_MAP 5
+
+static void append(cbor_writer_t *c, const void *data, size_t n) {
+  if (n > c->size - c->len) {
+    n = c->size - c->len;
+    c->overflow = true;
+  }
+  memcpy(c->buf + c->len, data, n);
+  c->len += n;
+}
+
+// Cabecera de un elemento: tipo mayor en los 3 bits altos y el argumento
+// dentro del byte (< 24) o en 1, 2 o 4 bytes big endian tras él
+static void head(cbor_writer_t *c, uint8_t major, uint32_t value) {
+  uint8_t b[5];
+  size_t n;
+
+  major <<= 5;
+  if (value < 24) {
+    b[0] = major | value;
+    n = 1;
+  } else if (value <= UINT8_MAX) {
+    b[0] = major | 24;
+    b[1] = value;
+    n = 2;
+  } else if (value <= UINT16_MAX) {
+    b[0] = major | 25;
+    b[1] = value >> 8;
+    b[2] = value;
+    n = 3;
+  } else {
+    b[0] = major | 26;
+    b[1] = value >> 24;
+    b[2] = value >> 16;
+    b[3] = value >> 8;
+    b[4] = value;
+    n = 5;
+  }
+  append(c, b, n);
+}
+
+void cbor_init(cbor_writer_t *c, uint8_t *buf, size_t size) {
+  c->buf = buf;
+  c->size = size;
+  c->len = 0;
+  c->overflow = false;
+}
+
+void cbor_map(cbor_writer_t *c, uint32_t pairs) {
+  head(c, MAJOR_MAP, pairs);
+}
+
+void cbor_array(cbor_writer_t *c, uint32_t items) {
+  head(c, MAJOR_ARRAY, items);
+}
+
+void cbor_uint(cbor_writer_t *c, uint32_t value) {
+  head(c, MAJOR_UINT, value);
+}
+
+void cbor_int(cbor_writer_t *c, int32_t value) {
+  // Los negativos se guardan como -1 - n
+  if (value < 0) {
+    head(c, MAJOR_NEGINT, -1 - value);
+  } else {
+    head(c, MAJOR_UINT, value);
+  }
+}
+
+void cbor_text(cbor_writer_t *c, const char *s) {
+  size_t n = strlen(s);
+
+  head(c, MAJOR_TEXT, n);
+  append(c, s, n);
+}
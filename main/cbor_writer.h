@@ -0,0 +1,57 @@
+/* Archivo: cbor_writer.h
+ * Descripción: Escritura de CBOR (RFC 8949) sobre un buffer fijo, sin
+ *              memoria dinámica. Solo lo que usan las lecturas: mapas y
+ *              listas de longitud conocida, enteros y texto.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_CBOR_WRITER_H_
+#define MAIN_CBOR_WRITER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Documento CBOR en construcción
+ *
+ * Lo que no cabe se descarta y marca overflow.
+ */
+typedef struct {
+  uint8_t *buf;
+  size_t size;
+  size_t len;
+  bool overflow;
+} cbor_writer_t;
+
+/**
+ * @brief Empieza un documento vacío en buf
+ */
+void cbor_init(cbor_writer_t *c, uint8_t *buf, size_t size);
+
+/**
+ * @brief Abre un mapa; le siguen pairs parejas clave, valor
+ */
+void cbor_map(cbor_writer_t *c, uint32_t pairs);
+
+/**
+ * @brief Abre una lista; le siguen items valores
+ */
+void cbor_array(cbor_writer_t *c, uint32_t items);
+
+/**
+ * @brief Añade un entero en la codificación más corta (1 a 5 bytes)
+ */
+void cbor_uint(cbor_writer_t *c, uint32_t value);
+void cbor_int(cbor_writer_t *c, int32_t value);
+
+/**
+ * @brief Añade una cadena de texto UTF-8
+ */
+void cbor_text(cbor_writer_t *c, const char *s);
+
+#endif /* MAIN_CBOR_WRITER_H_ */
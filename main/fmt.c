@@ -0,0 +1,97 @@
+/* Archivo: fmt.c
+ * Descripción: Construcción de textos con enteros y décimas sin printf.
+ *              Ver fmt.h.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "fmt.h"
+
+#include <string.h>
+
+// "00" a "99": una división entre 100 da dos dígitos
+static const char s_pairs[201] = "00010203040506070809"
+                                 "10111213141516171819"
+                                 "20212223242526272829"
+                                 "30313233343536373839"
+                                 "40414243444546474849"
+                                 "50515253545556575859"
+                                 "60616263646566676869"
+                                 "70717273747576777879"
+                                 "80818283848586878889"
+                                 "90919293949596979899";
+
+static void append(fmt_t *f, const char *s, size_t n) {
+  size_t room = f->size - 1 - f->len;
+
+  if (n > room) {
+    n = room;
+    f->overflow = true;
+  }
+  memcpy(f->buf + f->len, s, n);
+  f->len += n;
+  f->buf[f->len] = '\0';
+}
+
+void fmt_init(fmt_t *f, char *buf, size_t size) {
+  f->buf = buf;
+  f->size = size;
+  f->len = 0;
+  f->overflow = false;
+  buf[0] = '\0';
+}
+
+void fmt_str(fmt_t *f, const char *s) {
+  append(f, s, strlen(s));
+}
+
+void fmt_strn(fmt_t *f, const char *s, size_t n) {
+  append(f, s, n);
+}
+
+void fmt_uint(fmt_t *f, uint32_t value) {
+  char digits[10];
+  char *p = digits + sizeof(digits);
+
+  // De atrás hacia delante, de dos en dos
+  while (value >= 100) {
+    uint32_t pair = (value % 100) * 2;
+    value /= 100;
+    *--p = s_pairs[pair + 1];
+    *--p = s_pairs[pair];
+  }
+  if (value >= 10) {
+    *--p = s_pairs[value * 2 + 1];
+    *--p = s_pairs[value * 2];
+  } else {
+    *--p = '0' + value;
+  }
+  append(f, p, digits + sizeof(digits) - p);
+}
+
+void fmt_int(fmt_t *f, int32_t value) {
+  if (value < 0) {
+    append(f, "-", 1);
+    fmt_uint(f, -(uint32_t)value);
+  } else {
+    fmt_uint(f, value);
+  }
+}
+
+void fmt_deci(fmt_t *f, int32_t deci) {
+  uint32_t magnitude = deci < 0 ? -(uint32_t)deci : (uint32_t)deci;
+  char frac[2] = {'.', '0' + magnitude % 10};
+
+  if (deci < 0) {
+    append(f, "-", 1);
+  }
+  fmt_uint(f, magnitude / 10);
+  append(f, frac, sizeof(frac));
+}
+
+void fmt_deci_round(fmt_t *f, int32_t deci) {
+  fmt_int(f, deci < 0 ? -((-deci + 5) / 10) : (deci + 5) / 10);
+}
@@ -0,0 +1,83 @@
+/* Archivo: fmt.h
+ * Descripción: Formateo de lecturas sin coma flotante ni printf. Las
+ *              lecturas van de punta a punta en décimas enteras (int16, la
+ *              unidad del driver del DHT) y el ESP32-C3 no tiene FPU: cada
+ *              "/ 10.0" y cada "%.1f" son aritmética flotante emulada y la
+ *              conversión de newlib, miles de ciclos por lectura. Aquí los
+ *              textos se construyen por partes sobre un buffer fijo con una
+ *              conversión de enteros por pares de dígitos.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_FMT_H_
+#define MAIN_FMT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @brief Décimas como "%s%d.%d" para los logs y los textos que no están en
+ * el camino de cada lectura: printf solo recibe enteros
+ *
+ * Uso: ESP_LOGI(TAG, "Temp: " DECI_FMT " C", DECI_ARGS(temperature));
+ */
+#define DECI_FMT "%s%d.%d"
+#define DECI_ARGS(deci)                                                        \
+  ((deci) < 0 ? "-" : ""), abs(deci) / 10, abs(deci) % 10
+
+/**
+ * @brief Texto en construcción sobre un buffer del llamante
+ *
+ * Siempre termina en '\0'; lo que no cabe se descarta y marca overflow.
+ */
+typedef struct {
+  char *buf;
+  size_t size;
+  size_t len; // Sin contar el terminador
+  bool overflow;
+} fmt_t;
+
+/**
+ * @brief Empieza un texto vacío en buf
+ *
+ * @param size Tamaño de buf, al menos 1
+ */
+void fmt_init(fmt_t *f, char *buf, size_t size);
+
+/**
+ * @brief Añade una cadena
+ */
+void fmt_str(fmt_t *f, const char *s);
+
+/**
+ * @brief Añade los n primeros bytes de s
+ */
+void fmt_strn(fmt_t *f, const char *s, size_t n);
+
+/**
+ * @brief Añade un entero sin signo
+ */
+void fmt_uint(fmt_t *f, uint32_t value);
+
+/**
+ * @brief Añade un entero con signo
+ */
+void fmt_int(fmt_t *f, int32_t value);
+
+/**
+ * @brief Añade décimas con un decimal ("-0.5", "23.4")
+ */
+void fmt_deci(fmt_t *f, int32_t deci);
+
+/**
+ * @brief Añade décimas redondeadas a entero, las mitades lejos del cero
+ */
+void fmt_deci_round(fmt_t *f, int32_t deci);
+
+#endif /* MAIN_FMT_H_ */
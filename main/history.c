@@ -0,0 +1,258 @@
+/* Archivo: history.c
+ * Descripción: Historial de lecturas en RAM con varias resoluciones. Cada
+ *              resolución es un anillo de tamaño fijo indexado por un
+ *              contador absoluto de puntos escritos; el agregado en curso de
+ *              cada resolución se acumula con sumas y se cierra al cambiar
+ *              de intervalo, y al cerrarse un minuto se suma a la hora en
+ *              curso. Ver history.h.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "history.h"
+
+#include <stddef.h>
+
+#include "freertos/FreeRTOS.h"
+
+// Muestra en bruto: 8 bytes frente a los 20 de un agregado
+typedef struct {
+  uint32_t time;
+  int16_t temperature;
+  int16_t humidity;
+} raw_sample_t;
+
+// Agregado abierto: sumas exactas hasta que se cierra el intervalo
+typedef struct {
+  uint32_t start;
+  uint32_t count;
+  int16_t temp_min;
+  int16_t temp_max;
+  int16_t hum_min;
+  int16_t hum_max;
+  int32_t temp_sum;
+  int32_t hum_sum;
+} accumulator_t;
+
+static raw_sample_t s_raw[CONFIG_HISTORY_RAW_SAMPLES];
+static history_point_t s_minute[CONFIG_HISTORY_MINUTE_POINTS];
+static history_point_t s_hour[CONFIG_HISTORY_HOUR_POINTS];
+
+static const uint32_t s_capacity[HISTORY_TIERS] = {
+    CONFIG_HISTORY_RAW_SAMPLES,
+    CONFIG_HISTORY_MINUTE_POINTS,
+    CONFIG_HISTORY_HOUR_POINTS,
+};
+static const uint32_t s_span[HISTORY_TIERS] = {0, 60, 3600};
+
+// Puntos escritos desde el arranque por resolución; el más antiguo que
+// queda es max(0, head - capacidad)
+static uint32_t s_head[HISTORY_TIERS];
+// Agregados abiertos de HISTORY_MINUTE y HISTORY_HOUR
+static accumulator_t s_open[HISTORY_TIERS];
+static uint32_t s_last_time = 0;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static inline uint32_t oldest(history_tier_t tier) {
+  return s_head[tier] > s_capacity[tier] ? s_head[tier] - s_capacity[tier] : 0;
+}
+
+// Debe llamarse con s_lock tomado
+static void read_point(history_tier_t tier, uint32_t index,
+                       history_point_t *out) {
+  uint32_t slot = index % s_capacity[tier];
+
+  if (tier == HISTORY_RAW) {
+    const raw_sample_t *r = &s_raw[slot];
+    *out = (history_point_t){
+        .time = r->time,
+        .count = 1,
+        .temp_min = r->temperature,
+        .temp_max = r->temperature,
+        .temp_mean = r->temperature,
+        .hum_min = r->humidity,
+        .hum_max = r->humidity,
+        .hum_mean = r->humidity,
+    };
+  } else {
+    *out = (tier == HISTORY_MINUTE ? s_minute : s_hour)[slot];
+  }
+}
+
+static inline uint32_t point_time(history_tier_t tier, uint32_t index) {
+  uint32_t slot = index % s_capacity[tier];
+
+  switch (tier) {
+  case HISTORY_RAW:
+    return s_raw[slot].time;
+  case HISTORY_MINUTE:
+    return s_minute[slot].time;
+  default:
+    return s_hour[slot].time;
+  }
+}
+
+static void acc_merge(accumulator_t *acc, const accumulator_t *src) {
+  if (acc->count == 0) {
+    uint32_t start = acc->start;
+    *acc = *src;
+    acc->start = start;
+    return;
+  }
+  if (src->temp_min < acc->temp_min) acc->temp_min = src->temp_min;
+  if (src->temp_max > acc->temp_max) acc->temp_max = src->temp_max;
+  if (src->hum_min < acc->hum_min) acc->hum_min = src->hum_min;
+  if (src->hum_max > acc->hum_max) acc->hum_max = src->hum_max;
+  acc->temp_sum += src->temp_sum;
+  acc->hum_sum += src->hum_sum;
+  acc->count += src->count;
+}
+
+static inline int16_t mean(int32_t sum, uint32_t count) {
+  // Redondeo al más cercano también con sumas negativas
+  return sum >= 0 ? (sum + (int32_t)count / 2) / (int32_t)count
+                  : (sum - (int32_t)count / 2) / (int32_t)count;
+}
+
+static void acc_to_point(const accumulator_t *acc, history_point_t *out) {
+  *out = (history_point_t){
+      .time = acc->start,
+      .count = acc->count > UINT16_MAX ? UINT16_MAX : acc->count,
+      .temp_min = acc->temp_min,
+      .temp_max = acc->temp_max,
+      .temp_mean = mean(acc->temp_sum, acc->count),
+      .hum_min = acc->hum_min,
+      .hum_max = acc->hum_max,
+      .hum_mean = mean(acc->hum_sum, acc->count),
+  };
+}
+
+// Cierra el agregado abierto de tier y lo guarda en su anillo
+static void acc_close(history_tier_t tier) {
+  history_point_t *ring = tier == HISTORY_MINUTE ? s_minute : s_hour;
+
+  acc_to_point(&s_open[tier], &ring[s_head[tier] % s_capacity[tier]]);
+  s_head[tier]++;
+}
+
+void history_add(uint32_t time, int16_t temperature, int16_t humidity) {
+  accumulator_t sample = {
+      .count = 1,
+      .temp_min = temperature,
+      .temp_max = temperature,
+      .hum_min = humidity,
+      .hum_max = humidity,
+      .temp_sum = temperature,
+      .hum_sum = humidity,
+  };
+  accumulator_t *minute = &s_open[HISTORY_MINUTE];
+  accumulator_t *hour = &s_open[HISTORY_HOUR];
+
+  taskENTER_CRITICAL(&s_lock);
+  if (time < s_last_time) {
+    taskEXIT_CRITICAL(&s_lock);
+    return;
+  }
+  s_last_time = time;
+
+  s_raw[s_head[HISTORY_RAW] % s_capacity[HISTORY_RAW]] =
+      (raw_sample_t){time, temperature, humidity};
+  s_head[HISTORY_RAW]++;
+
+  uint32_t minute_start = time - time % s_span[HISTORY_MINUTE];
+  if (minute->count > 0 && minute->start != minute_start) {
+    // El minuto cerrado pasa a la hora en curso, que se cierra a su vez si
+    // el minuto es de otra hora
+    uint32_t hour_start = minute->start - minute->start % s_span[HISTORY_HOUR];
+    if (hour->count > 0 && hour->start != hour_start) {
+      acc_close(HISTORY_HOUR);
+      hour->count = 0;
+    }
+    hour->start = hour_start;
+    acc_merge(hour, minute);
+    acc_close(HISTORY_MINUTE);
+    minute->count = 0;
+  }
+  minute->start = minute_start;
+  acc_merge(minute, &sample);
+  taskEXIT_CRITICAL(&s_lock);
+}
+
+void history_iter_init(history_iter_t *it, history_tier_t tier, uint32_t from,
+                       uint32_t to) {
+  it->tier = tier;
+  it->from = from;
+  it->to = to;
+  it->open_done = tier == HISTORY_RAW;
+
+  // Primer punto con time >= from; los tiempos son crecientes en el anillo
+  taskENTER_CRITICAL(&s_lock);
+  uint32_t lo = oldest(tier);
+  uint32_t hi = s_head[tier];
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (point_time(tier, mid) < from) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  taskEXIT_CRITICAL(&s_lock);
+  it->next = lo;
+}
+
+bool history_iter_next(history_iter_t *it, history_point_t *out) {
+  history_tier_t tier = it->tier;
+  bool found = false;
+
+  taskENTER_CRITICAL(&s_lock);
+  if (it->next < oldest(tier)) {
+    it->next = oldest(tier);
+  }
+  if (it->next < s_head[tier]) {
+    read_point(tier, it->next, out);
+    it->next++;
+    found = true;
+  } else if (!it->open_done) {
+    // Agregado en curso; el de la hora incluye el minuto abierto
+    it->open_done = true;
+    accumulator_t acc = s_open[tier];
+    const accumulator_t *minute = &s_open[HISTORY_MINUTE];
+    if (tier == HISTORY_HOUR && minute->count > 0) {
+      uint32_t start = minute->start - minute->start % s_span[HISTORY_HOUR];
+      if (acc.count == 0 || acc.start == start) {
+        acc.start = start;
+        acc_merge(&acc, minute);
+      }
+    }
+    if (acc.count > 0 && acc.start >= it->from) {
+      acc_to_point(&acc, out);
+      found = true;
+    }
+  }
+  taskEXIT_CRITICAL(&s_lock);
+
+  if (found && out->time > it->to) {
+    it->next = UINT32_MAX;
+    it->open_done = true;
+    return false;
+  }
+  return found;
+}
+
+uint32_t history_tier_info(history_tier_t tier, uint32_t *capacity,
+                           uint32_t *used) {
+  if (capacity != NULL) {
+    *capacity = s_capacity[tier];
+  }
+  if (used != NULL) {
+    taskENTER_CRITICAL(&s_lock);
+    *used = s_head[tier] - oldest(tier);
+    taskEXIT_CRITICAL(&s_lock);
+  }
+  return s_span[tier];
+}
@@ -0,0 +1,103 @@
+/* Archivo: history.h
+ * Descripción: Historial de lecturas en RAM con varias resoluciones:
+ *              muestras en bruto (por defecto la última hora), agregados de
+ *              1 minuto (un día) y de 1 hora (un mes). Cada agregado guarda
+ *              mínimo, máximo, media y número de muestras. Los agregados se
+ *              calculan al vuelo con trabajo O(1) por muestra y la memoria
+ *              es fija, configurable en menuconfig.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_HISTORY_H_
+#define MAIN_HISTORY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Resolución del historial
+ */
+typedef enum {
+  HISTORY_RAW = 0, // Cada lectura válida
+  HISTORY_MINUTE,  // Agregados de 1 minuto
+  HISTORY_HOUR,    // Agregados de 1 hora
+  HISTORY_TIERS
+} history_tier_t;
+
+/**
+ * @brief Punto del historial
+ *
+ * Temperaturas en décimas de °C y humedades en décimas de %. En las
+ * muestras en bruto count es 1 y mínimo, máximo y media coinciden.
+ */
+typedef struct {
+  uint32_t time; // Segundos (time()); inicio del intervalo en los agregados
+  uint16_t count;
+  int16_t temp_min;
+  int16_t temp_max;
+  int16_t temp_mean;
+  int16_t hum_min;
+  int16_t hum_max;
+  int16_t hum_mean;
+} history_point_t;
+
+/**
+ * @brief Recorrido de un intervalo de tiempo de una resolución
+ *
+ * Se puede usar desde cualquier tarea mientras se siguen añadiendo
+ * muestras: cada paso copia un punto bajo el cerrojo. Si el escritor
+ * sobrescribe puntos aún no leídos, el recorrido salta al más antiguo que
+ * quede.
+ */
+typedef struct {
+  history_tier_t tier;
+  uint32_t from;
+  uint32_t to;
+  uint32_t next;      // Índice absoluto del siguiente punto
+  bool open_done;     // Ya se devolvió el agregado en curso
+} history_iter_t;
+
+/**
+ * @brief Añade una lectura válida
+ *
+ * Solo puede llamarla una tarea. Los tiempos deben ser crecientes; una
+ * muestra anterior a la última se ignora.
+ *
+ * @param time Segundos (time())
+ * @param temperature Décimas de °C
+ * @param humidity Décimas de %
+ */
+void history_add(uint32_t time, int16_t temperature, int16_t humidity);
+
+/**
+ * @brief Empieza un recorrido por los puntos con time en [from, to]
+ *
+ * La búsqueda del primer punto es O(log n). Los agregados incluyen al final
+ * el intervalo aún abierto.
+ */
+void history_iter_init(history_iter_t *it, history_tier_t tier, uint32_t from,
+                       uint32_t to);
+
+/**
+ * @brief Siguiente punto del recorrido, en orden de tiempo
+ *
+ * @return true si out tiene un punto, false al terminar
+ */
+bool history_iter_next(history_iter_t *it, history_point_t *out);
+
+/**
+ * @brief Capacidad y ocupación de una resolución
+ *
+ * @param tier Resolución
+ * @param[out] capacity Puntos que caben (puede ser NULL)
+ * @param[out] used Puntos guardados, sin el agregado abierto (puede ser NULL)
+ * @return uint32_t Segundos que abarca cada punto (0 en bruto)
+ */
+uint32_t history_tier_info(history_tier_t tier, uint32_t *capacity,
+                           uint32_t *used);
+
+#endif /* MAIN_HISTORY_H_ */
@@ -0,0 +1,592 @@
+/* Archivo: history_flash.c
+ * Descripción: Registro persistente de lecturas en flash. Formato de cada
+ *              segmento (un sector):
+ *
+ *                cabecera (32 bytes) | lote | lote | ... | borrado (0xFF)
+ *
+ *              La cabecera se escribe al abrir el segmento con su número de
+ *              secuencia y el tiempo de la primera lectura; su cierre (último
+ *              tiempo, número de lecturas y CRC) se programa sobre los bytes
+ *              aún borrados al pasar al segmento siguiente. Cada lote es una
+ *              cabecera de 4 bytes (lecturas, marca de confirmación y CRC16)
+ *              seguida de lecturas de 8 bytes. Ver history_flash.h.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "history_flash.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_crc.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "HISTORY_FLASH";
+
+#define SEGMENT_SIZE 4096         // Un sector: la unidad de borrado
+#define PAGE_SIZE 256             // Un lote lleno cabe en una página
+#define SEGMENT_MAGIC 0x4c544844u // "DHTL"
+#define SEGMENT_VERSION 1
+#define BATCH_COMMITTED 0x00
+#define ERASED32 0xFFFFFFFFu
+
+typedef struct {
+  uint32_t time;
+  int16_t temperature;
+  int16_t humidity;
+} record_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t seq; // Crece en cada segmento abierto, nunca es 0
+  uint32_t first_time;
+  uint8_t version;
+  uint8_t record_size;
+  uint16_t reserved;
+  uint32_t header_crc; // De los campos anteriores
+  // Cierre: se programa al pasar al segmento siguiente
+  uint32_t last_time;
+  uint32_t count;
+  uint32_t seal_crc; // De seq, last_time y count
+} segment_header_t;
+
+typedef struct {
+  uint8_t count;
+  uint8_t commit; // 0xFF mientras se escribe, BATCH_COMMITTED al terminar
+  uint16_t crc;   // esp_crc16_le de las lecturas
+} batch_header_t;
+
+#define BATCH_MAX ((PAGE_SIZE - sizeof(batch_header_t)) / sizeof(record_t))
+#define SEAL_OFFSET offsetof(segment_header_t, last_time)
+
+_Static_assert(sizeof(segment_header_t) == 32, "cabecera de 32 bytes");
+_Static_assert(sizeof(record_t) == 8, "lecturas de 8 bytes");
+
+// Entrada del índice en RAM
+typedef struct {
+  uint32_t seq;
+  uint32_t first_time;
+  uint32_t last_time;
+  uint16_t sector;
+  uint16_t count;
+} segment_info_t;
+
+static const esp_partition_t *s_part = NULL;
+static uint32_t s_sectors;
+// Anillo de segmentos con datos ordenado por seq (y por tiempo); el último
+// es el segmento en el que se escribe
+static segment_info_t *s_index;
+static uint32_t s_start;
+static uint32_t s_used;
+static bool s_open; // El último segmento admite más lotes
+static uint32_t s_write_offset;
+static uint32_t s_next_seq = 1;
+static uint32_t s_records;
+static uint32_t s_erases;
+
+static record_t s_pending[BATCH_MAX];
+static uint32_t s_pending_count;
+
+// Protege todo lo anterior; las operaciones de flash pueden bloquear
+static SemaphoreHandle_t s_mutex;
+
+static inline segment_info_t *entry(uint32_t pos) {
+  return &s_index[(s_start + pos) % s_sectors];
+}
+
+static inline uint32_t sector_addr(uint32_t sector) {
+  return sector * SEGMENT_SIZE;
+}
+
+static uint32_t header_crc(const segment_header_t *h) {
+  return esp_crc32_le(0, (const uint8_t *)h,
+                      offsetof(segment_header_t, header_crc));
+}
+
+static uint32_t seal_crc(uint32_t seq, uint32_t last_time, uint32_t count) {
+  uint32_t words[3] = {seq, last_time, count};
+  return esp_crc32_le(0, (const uint8_t *)words, sizeof(words));
+}
+
+static bool header_valid(const segment_header_t *h) {
+  return h->magic == SEGMENT_MAGIC && h->version == SEGMENT_VERSION &&
+         h->record_size == sizeof(record_t) && h->seq != 0 &&
+         h->header_crc == header_crc(h);
+}
+
+static bool seal_valid(const segment_header_t *h) {
+  return h->count <= SEGMENT_SIZE / sizeof(record_t) &&
+         h->seal_crc == seal_crc(h->seq, h->last_time, h->count);
+}
+
+static bool seal_erased(const segment_header_t *h) {
+  return h->last_time == ERASED32 && h->count == ERASED32 &&
+         h->seal_crc == ERASED32;
+}
+
+static bool batch_valid(const batch_header_t *b, uint32_t offset) {
+  return b->commit == BATCH_COMMITTED && b->count > 0 &&
+         b->count <= BATCH_MAX &&
+         offset + sizeof(*b) + b->count * sizeof(record_t) <= SEGMENT_SIZE;
+}
+
+/**
+ * @brief Recorre los lotes de un segmento sin cerrar comprobando su CRC
+ *
+ * Rellena count y last_time de seg.
+ *
+ * @param[out] end Posición tras el último lote válido
+ * @return true si el segmento acaba en flash borrada o lleno, false si hay
+ *         un lote incompleto o corrupto
+ */
+static bool scan_segment(segment_info_t *seg, uint32_t *end) {
+  record_t records[BATCH_MAX];
+  uint32_t base = sector_addr(seg->sector);
+  uint32_t offset = sizeof(segment_header_t);
+  bool clean = true;
+
+  seg->count = 0;
+  seg->last_time = seg->first_time;
+  while (offset + sizeof(batch_header_t) + sizeof(record_t) <= SEGMENT_SIZE) {
+    batch_header_t b;
+    uint32_t raw;
+
+    if (esp_partition_read(s_part, base + offset, &b, sizeof(b)) != ESP_OK) {
+      clean = false;
+      break;
+    }
+    memcpy(&raw, &b, sizeof(raw));
+    if (raw == ERASED32) {
+      break;
+    }
+    if (!batch_valid(&b, offset) ||
+        esp_partition_read(s_part, base + offset + sizeof(b), records,
+                           b.count * sizeof(record_t)) != ESP_OK ||
+        esp_crc16_le(0, (const uint8_t *)records,
+                     b.count * sizeof(record_t)) != b.crc) {
+      clean = false;
+      break;
+    }
+    seg->count += b.count;
+    seg->last_time = records[b.count - 1].time;
+    offset += sizeof(b) + b.count * sizeof(record_t);
+  }
+  *end = offset;
+  return clean;
+}
+
+static int compare_seq(const void *a, const void *b) {
+  uint32_t sa = ((const segment_info_t *)a)->seq;
+  uint32_t sb = ((const segment_info_t *)b)->seq;
+  return sa < sb ? -1 : sa > sb;
+}
+
+// Las funciones siguientes deben llamarse con s_mutex tomado
+
+// Quita del índice el segmento que ocupa sector antes de borrarlo
+static void index_drop(uint32_t sector) {
+  for (uint32_t pos = 0; pos < s_used; pos++) {
+    if (entry(pos)->sector != sector) {
+      continue;
+    }
+    s_records -= entry(pos)->count;
+    if (pos == 0) {
+      // El caso normal: el sector siguiente al abierto es el más antiguo
+      s_start = (s_start + 1) % s_sectors;
+    } else {
+      for (; pos + 1 < s_used; pos++) {
+        *entry(pos) = *entry(pos + 1);
+      }
+    }
+    s_used--;
+    return;
+  }
+}
+
+static esp_err_t seal_segment(void) {
+  segment_info_t *seg = entry(s_used - 1);
+  uint32_t seal[3] = {seg->last_time, seg->count,
+                      seal_crc(seg->seq, seg->last_time, seg->count)};
+
+  s_open = false;
+  return esp_partition_write(s_part, sector_addr(seg->sector) + SEAL_OFFSET,
+                             seal, sizeof(seal));
+}
+
+static esp_err_t open_segment(uint32_t first_time) {
+  uint32_t sector = s_used > 0 ? (entry(s_used - 1)->sector + 1) % s_sectors : 0;
+  segment_header_t h;
+
+  index_drop(sector);
+  esp_err_t ret =
+      esp_partition_erase_range(s_part, sector_addr(sector), SEGMENT_SIZE);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+  s_erases++;
+
+  memset(&h, 0xff, sizeof(h));
+  h.magic = SEGMENT_MAGIC;
+  h.seq = s_next_seq;
+  h.first_time = first_time;
+  h.version = SEGMENT_VERSION;
+  h.record_size = sizeof(record_t);
+  h.header_crc = header_crc(&h);
+  ret = esp_partition_write(s_part, sector_addr(sector), &h, SEAL_OFFSET);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+
+  *entry(s_used) = (segment_info_t){.seq = s_next_seq,
+                                    .first_time = first_time,
+                                    .last_time = first_time,
+                                    .sector = sector};
+  s_used++;
+  s_next_seq++;
+  s_open = true;
+  s_write_offset = sizeof(segment_header_t);
+  return ESP_OK;
+}
+
+static esp_err_t write_batch(const record_t *records, uint32_t count) {
+  segment_info_t *seg = entry(s_used - 1);
+  uint32_t addr = sector_addr(seg->sector) + s_write_offset;
+  uint32_t size = count * sizeof(record_t);
+  batch_header_t b = {
+      .count = count,
+      .commit = 0xff,
+      .crc = esp_crc16_le(0, (const uint8_t *)records, size),
+  };
+  uint8_t commit = BATCH_COMMITTED;
+
+  // La marca de confirmación se escribe la última: un lote sin ella se
+  // descarta al arrancar
+  esp_err_t ret = esp_partition_write(s_part, addr, &b, sizeof(b));
+  if (ret == ESP_OK) {
+    ret = esp_partition_write(s_part, addr + sizeof(b), records, size);
+  }
+  if (ret == ESP_OK) {
+    ret = esp_partition_write(s_part, addr + offsetof(batch_header_t, commit),
+                              &commit, sizeof(commit));
+  }
+  if (ret != ESP_OK) {
+    // No se vuelve a escribir detrás de un lote a medias
+    seal_segment();
+    return ret;
+  }
+
+  s_write_offset += sizeof(b) + size;
+  seg->count += count;
+  seg->last_time = records[count - 1].time;
+  s_records += count;
+  return ESP_OK;
+}
+
+static esp_err_t flush_locked(void) {
+  uint32_t done = 0;
+  esp_err_t ret = ESP_OK;
+
+  while (done < s_pending_count) {
+    uint32_t room = s_open ? SEGMENT_SIZE - s_write_offset : 0;
+
+    if (room < sizeof(batch_header_t) + sizeof(record_t)) {
+      if (s_open && (ret = seal_segment()) != ESP_OK) {
+        break;
+      }
+      if ((ret = open_segment(s_pending[done].time)) != ESP_OK) {
+        break;
+      }
+      continue;
+    }
+    uint32_t count = (room - sizeof(batch_header_t)) / sizeof(record_t);
+    if (count > s_pending_count - done) {
+      count = s_pending_count - done;
+    }
+    if ((ret = write_batch(&s_pending[done], count)) != ESP_OK) {
+      break;
+    }
+    done += count;
+  }
+
+  // Lo que no se pudo escribir queda para el siguiente intento
+  memmove(s_pending, &s_pending[done],
+          (s_pending_count - done) * sizeof(record_t));
+  s_pending_count -= done;
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "Error escribiendo en flash: %s", esp_err_to_name(ret));
+  }
+  return ret;
+}
+
+// Posición del primer segmento con seq >= el dado (s_used si no hay)
+static uint32_t find_seq(uint32_t seq) {
+  uint32_t lo = 0;
+  uint32_t hi = s_used;
+
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (entry(mid)->seq < seq) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+esp_err_t history_flash_init(void) {
+  int64_t start = esp_timer_get_time();
+
+  s_part = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA,
+      (esp_partition_subtype_t)HISTORY_FLASH_PARTITION_SUBTYPE, "history");
+  if (s_part == NULL) {
+    ESP_LOGE(TAG, "No hay partición history");
+    return ESP_ERR_NOT_FOUND;
+  }
+  s_sectors = s_part->size / SEGMENT_SIZE;
+  s_index = calloc(s_sectors, sizeof(segment_info_t));
+  s_mutex = xSemaphoreCreateMutex();
+  if (s_index == NULL || s_mutex == NULL) {
+    free(s_index);
+    s_part = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+
+  // Solo las cabeceras; los lotes se leen en los segmentos sin cerrar
+  for (uint32_t sector = 0; sector < s_sectors; sector++) {
+    segment_header_t h;
+    if (esp_partition_read(s_part, sector_addr(sector), &h, sizeof(h)) !=
+            ESP_OK ||
+        !header_valid(&h)) {
+      continue;
+    }
+    segment_info_t *seg = &s_index[s_used++];
+    *seg = (segment_info_t){.seq = h.seq,
+                            .first_time = h.first_time,
+                            .sector = sector};
+    if (seal_valid(&h)) {
+      seg->last_time = h.last_time;
+      seg->count = h.count;
+    } else {
+      uint32_t end;
+      scan_segment(seg, &end);
+    }
+  }
+  qsort(s_index, s_used, sizeof(segment_info_t), compare_seq);
+  s_start = 0;
+  for (uint32_t pos = 0; pos < s_used; pos++) {
+    s_records += entry(pos)->count;
+  }
+
+  if (s_used > 0) {
+    // Se sigue escribiendo en el último segmento si no se llegó a cerrar y
+    // todos sus lotes están completos
+    segment_info_t *head = entry(s_used - 1);
+    segment_header_t h;
+    uint32_t end;
+
+    s_next_seq = head->seq + 1;
+    if (esp_partition_read(s_part, sector_addr(head->sector), &h,
+                           sizeof(h)) == ESP_OK &&
+        seal_erased(&h)) {
+      if (scan_segment(head, &end)) {
+        s_open = true;
+        s_write_offset = end;
+      } else {
+        ESP_LOGW(TAG, "Lote incompleto en el segmento %lu, se cierra",
+                 (unsigned long)head->seq);
+        seal_segment();
+      }
+    }
+  }
+
+  ESP_LOGI(TAG, "%lu de %lu segmentos, %lu lecturas (%lu ms)",
+           (unsigned long)s_used, (unsigned long)s_sectors,
+           (unsigned long)s_records,
+           (unsigned long)((esp_timer_get_time() - start) / 1000));
+  return ESP_OK;
+}
+
+esp_err_t history_flash_append(uint32_t time, int16_t temperature,
+                               int16_t humidity) {
+  esp_err_t ret = ESP_OK;
+
+  if (s_part == NULL || time < HISTORY_FLASH_MIN_TIME) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  xSemaphoreTake(s_mutex, portMAX_DELAY);
+  uint32_t last = s_pending_count > 0 ? s_pending[s_pending_count - 1].time
+                  : s_used > 0        ? entry(s_used - 1)->last_time
+                                      : 0;
+  if (time < last) {
+    xSemaphoreGive(s_mutex);
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (s_pending_count == BATCH_MAX) {
+    // La flash lleva fallando un lote entero: se pierde la más antigua
+    memmove(s_pending, &s_pending[1], (BATCH_MAX - 1) * sizeof(record_t));
+    s_pending_count--;
+  }
+  s_pending[s_pending_count++] = (record_t){time, temperature, humidity};
+  if (s_pending_count == BATCH_MAX ||
+      time - s_pending[0].time >= CONFIG_HISTORY_FLASH_FLUSH_S) {
+    ret = flush_locked();
+  }
+  xSemaphoreGive(s_mutex);
+  return ret;
+}
+
+esp_err_t history_flash_flush(void) {
+  if (s_part == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  xSemaphoreTake(s_mutex, portMAX_DELAY);
+  esp_err_t ret = flush_locked();
+  xSemaphoreGive(s_mutex);
+  return ret;
+}
+
+void history_flash_iter_init(history_flash_iter_t *it, uint32_t from,
+                             uint32_t to) {
+  it->from = from;
+  it->to = to;
+  it->seq = 0;
+  it->offset = sizeof(segment_header_t);
+  it->left = 0;
+  if (s_part == NULL) {
+    return;
+  }
+
+  // Primer segmento cuya última lectura es >= from
+  xSemaphoreTake(s_mutex, portMAX_DELAY);
+  uint32_t lo = 0;
+  uint32_t hi = s_used;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (entry(mid)->last_time < from) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < s_used && entry(lo)->first_time <= to) {
+    it->seq = entry(lo)->seq;
+  }
+  xSemaphoreGive(s_mutex);
+}
+
+bool history_flash_iter_next(history_flash_iter_t *it, history_point_t *out) {
+  record_t rec;
+  bool found = false;
+
+  if (it->seq == 0) {
+    return false;
+  }
+
+  xSemaphoreTake(s_mutex, portMAX_DELAY);
+  while (it->seq != 0) {
+    uint32_t pos = find_seq(it->seq);
+    if (pos == s_used) {
+      it->seq = 0;
+      break;
+    }
+    segment_info_t *seg = entry(pos);
+    if (seg->seq != it->seq) {
+      // El segmento se borró para reutilizarlo: sigue el más antiguo
+      it->seq = seg->seq;
+      it->offset = sizeof(segment_header_t);
+      it->left = 0;
+    }
+    uint32_t base = sector_addr(seg->sector);
+
+    if (it->left == 0) {
+      batch_header_t b;
+      bool at_head = pos == s_used - 1 && s_open;
+
+      if ((at_head && it->offset >= s_write_offset) ||
+          it->offset + sizeof(b) + sizeof(rec) > SEGMENT_SIZE ||
+          esp_partition_read(s_part, base + it->offset, &b, sizeof(b)) !=
+              ESP_OK ||
+          !batch_valid(&b, it->offset)) {
+        // Fin del segmento
+        it->seq = pos + 1 < s_used ? entry(pos + 1)->seq : 0;
+        it->offset = sizeof(segment_header_t);
+        continue;
+      }
+      it->left = b.count;
+      it->offset += sizeof(b);
+    }
+
+    if (esp_partition_read(s_part, base + it->offset, &rec, sizeof(rec)) !=
+        ESP_OK) {
+      it->seq = 0;
+      break;
+    }
+    it->offset += sizeof(rec);
+    it->left--;
+    if (rec.time < it->from) {
+      continue;
+    }
+    if (rec.time > it->to) {
+      it->seq = 0;
+      break;
+    }
+    found = true;
+    break;
+  }
+  xSemaphoreGive(s_mutex);
+
+  if (found) {
+    *out = (history_point_t){
+        .time = rec.time,
+        .count = 1,
+        .temp_min = rec.temperature,
+        .temp_max = rec.temperature,
+        .temp_mean = rec.temperature,
+        .hum_min = rec.humidity,
+        .hum_max = rec.humidity,
+        .hum_mean = rec.humidity,
+    };
+  }
+  return found;
+}
+
+void history_flash_get_info(history_flash_info_t *info) {
+  memset(info, 0, sizeof(*info));
+  if (s_part == NULL) {
+    return;
+  }
+
+  xSemaphoreTake(s_mutex, portMAX_DELAY);
+  info->segments = s_sectors;
+  info->used = s_used;
+  info->records = s_records;
+  info->pending = s_pending_count;
+  // Un segmento sin lecturas (su primer lote no llegó a confirmarse) no
+  // cuenta para los extremos
+  for (uint32_t pos = 0; pos < s_used; pos++) {
+    if (entry(pos)->count > 0) {
+      info->oldest = entry(pos)->first_time;
+      break;
+    }
+  }
+  for (uint32_t pos = s_used; pos > 0; pos--) {
+    if (entry(pos - 1)->count > 0) {
+      info->newest = entry(pos - 1)->last_time;
+      break;
+    }
+  }
+  info->erases = s_erases;
+  xSemaphoreGive(s_mutex);
+}
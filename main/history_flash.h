@@ -0,0 +1,124 @@
+/* Archivo: history_flash.h
+ * Descripción: Registro persistente de lecturas en la partición "history"
+ *              de la flash. Es un log circular de solo anexado: la partición
+ *              se divide en segmentos del tamaño de un sector (4 KB) y cada
+ *              segmento lleva una cabecera con su número de secuencia, el
+ *              rango de tiempos y CRC. Las lecturas se acumulan en RAM y se
+ *              escriben por lotes de hasta una página (256 bytes), cada lote
+ *              con su CRC y una marca de confirmación que se escribe la
+ *              última, así un corte de alimentación a mitad de escritura
+ *              solo pierde el lote incompleto. Al llenarse la partición se
+ *              borra el segmento más antiguo, con lo que todos los sectores
+ *              se gastan por igual.
+ *
+ *              Al arrancar solo se leen las cabeceras de los segmentos y los
+ *              lotes del segmento abierto; con ellas se construye en RAM un
+ *              índice ordenado de segmentos que permite encontrar el inicio
+ *              de un intervalo de tiempo con una búsqueda binaria.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_HISTORY_FLASH_H_
+#define MAIN_HISTORY_FLASH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "history.h"
+
+// Subtipo de la partición "history" en partitions.csv
+#define HISTORY_FLASH_PARTITION_SUBTYPE 0x40
+
+// Tiempos anteriores (reloj sin sincronizar por SNTP) no se guardan
+#define HISTORY_FLASH_MIN_TIME 1700000000u
+
+/**
+ * @brief Recorrido de un intervalo de tiempo del registro en flash
+ *
+ * Solo devuelve lecturas ya escritas en la flash (ver
+ * history_flash_flush()). Si el segmento en curso se borra para reutilizarlo
+ * mientras se recorre, el recorrido salta al más antiguo que quede.
+ */
+typedef struct {
+  uint32_t from;
+  uint32_t to;
+  uint32_t seq;    // Segmento en curso, 0 al terminar
+  uint32_t offset; // Siguiente lectura dentro del segmento
+  uint8_t left;    // Registros que quedan del lote en curso
+} history_flash_iter_t;
+
+/**
+ * @brief Estado del registro
+ */
+typedef struct {
+  uint32_t segments; // Segmentos de la partición
+  uint32_t used;     // Segmentos con datos
+  uint32_t records;  // Lecturas en la flash
+  uint32_t pending;  // Lecturas en RAM aún sin escribir
+  uint32_t oldest;   // time() de la lectura más antigua, 0 si no hay
+  uint32_t newest;   // time() de la última lectura escrita, 0 si no hay
+  uint32_t erases;   // Sectores borrados desde el arranque
+} history_flash_info_t;
+
+/**
+ * @brief Busca la partición y recupera el estado del registro
+ *
+ * Si el segmento abierto quedó con un lote incompleto se cierra y las
+ * siguientes lecturas empiezan un segmento nuevo.
+ *
+ * @return esp_err_t ESP_OK, ESP_ERR_NOT_FOUND si no hay partición
+ *         "history", ESP_ERR_NO_MEM si no cabe el índice
+ */
+esp_err_t history_flash_init(void);
+
+/**
+ * @brief Añade una lectura válida
+ *
+ * Se guarda en RAM y se escribe el lote cuando se llena o cuando la lectura
+ * más antigua del lote supera CONFIG_HISTORY_FLASH_FLUSH_S. Puede bloquear
+ * lo que tarde un borrado de sector; conviene llamarla desde una tarea que
+ * no sea la de lectura del sensor.
+ *
+ * @param time Segundos (time())
+ * @param temperature Décimas de °C
+ * @param humidity Décimas de %
+ * @return esp_err_t ESP_OK, ESP_ERR_INVALID_STATE si el reloj no está en
+ *         hora o el tiempo es anterior a la última lectura, o el error de
+ *         la flash
+ */
+esp_err_t history_flash_append(uint32_t time, int16_t temperature,
+                               int16_t humidity);
+
+/**
+ * @brief Escribe ya las lecturas pendientes en RAM
+ */
+esp_err_t history_flash_flush(void);
+
+/**
+ * @brief Empieza un recorrido por las lecturas con time en [from, to]
+ *
+ * El segmento inicial se busca en el índice en O(log n).
+ */
+void history_flash_iter_init(history_flash_iter_t *it, uint32_t from,
+                             uint32_t to);
+
+/**
+ * @brief Siguiente lectura del recorrido, en orden de tiempo
+ *
+ * Cada lectura se devuelve como un punto con count 1.
+ *
+ * @return true si out tiene una lectura, false al terminar
+ */
+bool history_flash_iter_next(history_flash_iter_t *it, history_point_t *out);
+
+/**
+ * @brief Copia el estado del registro
+ */
+void history_flash_get_info(history_flash_info_t *info);
+
+#endif /* MAIN_HISTORY_FLASH_H_ */
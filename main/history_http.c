@@ -0,0 +1,463 @@
+/* Archivo: history_http.c
+ * Descripción: Handler de /api/history. Recorre la fuente elegida punto a
+ *              punto, agrupa por step sobre la marcha y va llenando un
+ *              buffer de pila que se envía como un trozo cada vez que no
+ *              cabe otra fila. Ver history_http.h.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "history_http.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_log.h"
+#include "fmt.h"
+#include "history.h"
+#include "history_flash.h"
+
+static const char *TAG = "HISTORY_HTTP";
+
+#define HISTORY_HTTP_BUF 512
+#define ROW_MAX 96 // Fila más larga: 7 campos en JSON
+
+typedef enum {
+  FIELD_TEMP = 0,
+  FIELD_HUM,
+  FIELD_TEMP_MIN,
+  FIELD_TEMP_MAX,
+  FIELD_HUM_MIN,
+  FIELD_HUM_MAX,
+  FIELD_COUNT,
+  FIELD_MAX
+} field_t;
+
+static const char *const s_field_names[FIELD_MAX] = {
+    "temp", "hum", "temp_min", "temp_max", "hum_min", "hum_max", "count",
+};
+
+typedef enum { FORMAT_JSON, FORMAT_CSV, FORMAT_BIN } format_t;
+
+typedef struct {
+  uint32_t from;
+  uint32_t to;
+  uint32_t step;
+  format_t format;
+  uint8_t nfields;
+  uint8_t fields[FIELD_MAX];
+} query_t;
+
+/**
+ * @brief Fuente de puntos en orden de tiempo
+ *
+ * Una resolución del historial en RAM o, para las lecturas sueltas, el
+ * registro en flash seguido de las lecturas en RAM aún más recientes (las
+ * que no se han escrito todavía).
+ */
+typedef struct {
+  history_iter_t ram;
+  history_flash_iter_t flash;
+  bool in_flash;
+  uint32_t to;
+  uint32_t last_time;
+} source_t;
+
+// Intervalo agregado en curso
+typedef struct {
+  uint32_t start;
+  uint32_t count;
+  int16_t temp_min;
+  int16_t temp_max;
+  int16_t hum_min;
+  int16_t hum_max;
+  int32_t temp_sum;
+  int32_t hum_sum;
+} bucket_t;
+
+// Respuesta en curso: el buffer se envía al llenarse
+typedef struct {
+  httpd_req_t *req;
+  const query_t *query;
+  char buf[HISTORY_HTTP_BUF];
+  size_t len;
+  uint32_t rows;
+} out_t;
+
+static uint32_t tier_oldest(history_tier_t tier) {
+  history_iter_t it;
+  history_point_t p;
+
+  history_iter_init(&it, tier, 0, UINT32_MAX);
+  return history_iter_next(&it, &p) ? p.time : UINT32_MAX;
+}
+
+/**
+ * @brief Elige de dónde salen los puntos
+ *
+ * Con step múltiplo de la hora o del minuto sirve la resolución más gruesa
+ * del historial en RAM que llegue hasta from; si ninguna llega, la fuente
+ * que más atrás llegue.
+ */
+static history_tier_t pick_tier(uint32_t from, uint32_t step) {
+  static const history_tier_t coarse_first[] = {HISTORY_HOUR, HISTORY_MINUTE};
+  history_flash_info_t info;
+  history_tier_t best = HISTORY_RAW;
+
+  if (step == 0) {
+    return HISTORY_RAW;
+  }
+  history_flash_get_info(&info);
+  uint32_t best_oldest = info.records > 0 ? info.oldest : UINT32_MAX;
+  uint32_t raw_oldest = tier_oldest(HISTORY_RAW);
+  if (raw_oldest < best_oldest) {
+    best_oldest = raw_oldest;
+  }
+
+  for (int i = 0; i < sizeof(coarse_first) / sizeof(coarse_first[0]); i++) {
+    history_tier_t tier = coarse_first[i];
+    if (step % history_tier_info(tier, NULL, NULL) != 0) {
+      continue;
+    }
+    uint32_t oldest = tier_oldest(tier);
+    if (oldest <= from) {
+      return tier;
+    }
+    if (oldest < best_oldest) {
+      best = tier;
+      best_oldest = oldest;
+    }
+  }
+  return best;
+}
+
+static void source_init(source_t *src, history_tier_t tier, uint32_t from,
+                        uint32_t to) {
+  src->to = to;
+  src->last_time = 0;
+  src->in_flash = tier == HISTORY_RAW;
+  if (src->in_flash) {
+    history_flash_iter_init(&src->flash, from, to);
+  } else {
+    history_iter_init(&src->ram, tier, from, to);
+  }
+}
+
+static bool source_next(source_t *src, history_point_t *p) {
+  if (src->in_flash) {
+    if (history_flash_iter_next(&src->flash, p)) {
+      src->last_time = p->time;
+      return true;
+    }
+    // Sigue en RAM tras la última lectura que había en la flash
+    src->in_flash = false;
+    history_iter_init(&src->ram, HISTORY_RAW,
+                      src->last_time ? src->last_time + 1 : src->flash.from,
+                      src->to);
+  }
+  return history_iter_next(&src->ram, p);
+}
+
+static void bucket_add(bucket_t *b, const history_point_t *p) {
+  if (b->count == 0) {
+    b->temp_min = p->temp_min;
+    b->temp_max = p->temp_max;
+    b->hum_min = p->hum_min;
+    b->hum_max = p->hum_max;
+    b->temp_sum = 0;
+    b->hum_sum = 0;
+  }
+  if (p->temp_min < b->temp_min) b->temp_min = p->temp_min;
+  if (p->temp_max > b->temp_max) b->temp_max = p->temp_max;
+  if (p->hum_min < b->hum_min) b->hum_min = p->hum_min;
+  if (p->hum_max > b->hum_max) b->hum_max = p->hum_max;
+  // Media ponderada por el número de lecturas de cada punto
+  b->temp_sum += (int32_t)p->temp_mean * p->count;
+  b->hum_sum += (int32_t)p->hum_mean * p->count;
+  b->count += p->count;
+}
+
+static inline int16_t mean(int32_t sum, uint32_t count) {
+  return sum >= 0 ? (sum + (int32_t)count / 2) / (int32_t)count
+                  : (sum - (int32_t)count / 2) / (int32_t)count;
+}
+
+static void bucket_to_point(const bucket_t *b, history_point_t *out) {
+  *out = (history_point_t){
+      .time = b->start,
+      .count = b->count > UINT16_MAX ? UINT16_MAX : b->count,
+      .temp_min = b->temp_min,
+      .temp_max = b->temp_max,
+      .temp_mean = mean(b->temp_sum, b->count),
+      .hum_min = b->hum_min,
+      .hum_max = b->hum_max,
+      .hum_mean = mean(b->hum_sum, b->count),
+  };
+}
+
+static int32_t field_value(const history_point_t *p, field_t field) {
+  switch (field) {
+  case FIELD_TEMP:
+    return p->temp_mean;
+  case FIELD_HUM:
+    return p->hum_mean;
+  case FIELD_TEMP_MIN:
+    return p->temp_min;
+  case FIELD_TEMP_MAX:
+    return p->temp_max;
+  case FIELD_HUM_MIN:
+    return p->hum_min;
+  case FIELD_HUM_MAX:
+    return p->hum_max;
+  default:
+    return p->count;
+  }
+}
+
+static esp_err_t out_flush(out_t *out) {
+  if (out->len == 0) {
+    return ESP_OK;
+  }
+  esp_err_t ret = httpd_resp_send_chunk(out->req, out->buf, out->len);
+  out->len = 0;
+  return ret;
+}
+
+static esp_err_t out_write(out_t *out, const void *data, size_t len) {
+  if (out->len + len > sizeof(out->buf) && out_flush(out) != ESP_OK) {
+    return ESP_FAIL;
+  }
+  memcpy(out->buf + out->len, data, len);
+  out->len += len;
+  return ESP_OK;
+}
+
+static esp_err_t out_row(out_t *out, const history_point_t *p) {
+  const query_t *q = out->query;
+
+  if (out->len + ROW_MAX > sizeof(out->buf) && out_flush(out) != ESP_OK) {
+    return ESP_FAIL;
+  }
+  char *row = out->buf + out->len;
+  size_t size = sizeof(out->buf) - out->len;
+  int len = 0;
+
+  if (q->format == FORMAT_BIN) {
+    uint8_t *b = (uint8_t *)row;
+    b[len++] = p->time;
+    b[len++] = p->time >> 8;
+    b[len++] = p->time >> 16;
+    b[len++] = p->time >> 24;
+    for (int i = 0; i < q->nfields; i++) {
+      int32_t v = field_value(p, q->fields[i]);
+      b[len++] = v;
+      b[len++] = v >> 8;
+    }
+  } else {
+    bool json = q->format == FORMAT_JSON;
+    fmt_t f;
+    fmt_init(&f, row, size);
+    if (json) {
+      fmt_str(&f, out->rows ? ",[" : "[");
+    }
+    fmt_uint(&f, p->time);
+    for (int i = 0; i < q->nfields; i++) {
+      int32_t v = field_value(p, q->fields[i]);
+      fmt_str(&f, ",");
+      if (q->fields[i] == FIELD_COUNT) {
+        fmt_int(&f, v);
+      } else {
+        fmt_deci(&f, v);
+      }
+    }
+    fmt_str(&f, json ? "]" : "\n");
+    len = f.len;
+  }
+  out->len += len;
+  out->rows++;
+  return ESP_OK;
+}
+
+static esp_err_t out_begin(out_t *out) {
+  const query_t *q = out->query;
+  char head[160];
+  int len = 0;
+
+  switch (q->format) {
+  case FORMAT_BIN: {
+    uint8_t bin[8] = {1, q->nfields, 0, 0, q->step, q->step >> 8,
+                      q->step >> 16, q->step >> 24};
+    return out_write(out, bin, sizeof(bin));
+  }
+  case FORMAT_CSV:
+    len = snprintf(head, sizeof(head), "time");
+    for (int i = 0; i < q->nfields; i++) {
+      len += snprintf(head + len, sizeof(head) - len, ",%s",
+                      s_field_names[q->fields[i]]);
+    }
+    len += snprintf(head + len, sizeof(head) - len, "\n");
+    break;
+  default:
+    len = snprintf(head, sizeof(head),
+                   "{\"from\": %lu, \"to\": %lu, \"step\": %lu, "
+                   "\"fields\": [\"time\"",
+                   (unsigned long)q->from, (unsigned long)q->to,
+                   (unsigned long)q->step);
+    for (int i = 0; i < q->nfields; i++) {
+      len += snprintf(head + len, sizeof(head) - len, ", \"%s\"",
+                      s_field_names[q->fields[i]]);
+    }
+    len += snprintf(head + len, sizeof(head) - len, "], \"data\": [");
+    break;
+  }
+  return out_write(out, head, len);
+}
+
+static esp_err_t parse_fields(const char *list, query_t *q) {
+  q->nfields = 0;
+  while (*list) {
+    size_t n = strcspn(list, ",");
+    int field = 0;
+    while (field < FIELD_MAX && (strlen(s_field_names[field]) != n ||
+                                 strncmp(list, s_field_names[field], n))) {
+      field++;
+    }
+    if (field == FIELD_MAX || q->nfields == FIELD_MAX) {
+      return ESP_ERR_INVALID_ARG;
+    }
+    q->fields[q->nfields++] = field;
+    list += n;
+    if (*list == ',') {
+      list++;
+    }
+  }
+  return q->nfields > 0 ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+static bool parse_u32(const char *query, const char *key, uint32_t *value) {
+  char buf[16];
+  char *end;
+
+  if (httpd_query_key_value(query, key, buf, sizeof(buf)) != ESP_OK) {
+    return true; // Se queda el valor por defecto
+  }
+  unsigned long v = strtoul(buf, &end, 10);
+  if (end == buf || *end != '\0' || v > UINT32_MAX) {
+    return false;
+  }
+  *value = v;
+  return true;
+}
+
+static esp_err_t parse_query(httpd_req_t *req, query_t *q) {
+  char query[128] = "";
+  char buf[72];
+
+  q->to = time(NULL);
+  q->from = q->to > 3600 ? q->to - 3600 : 0;
+  q->step = 0;
+  q->format = FORMAT_JSON;
+  q->nfields = 2;
+  q->fields[0] = FIELD_TEMP;
+  q->fields[1] = FIELD_HUM;
+
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
+    return ESP_OK;
+  }
+  if (!parse_u32(query, "from", &q->from) || !parse_u32(query, "to", &q->to) ||
+      !parse_u32(query, "step", &q->step) || q->from > q->to) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (httpd_query_key_value(query, "fields", buf, sizeof(buf)) == ESP_OK &&
+      parse_fields(buf, q) != ESP_OK) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (httpd_query_key_value(query, "format", buf, sizeof(buf)) == ESP_OK) {
+    if (strcmp(buf, "csv") == 0) {
+      q->format = FORMAT_CSV;
+    } else if (strcmp(buf, "bin") == 0) {
+      q->format = FORMAT_BIN;
+    } else if (strcmp(buf, "json") != 0) {
+      return ESP_ERR_INVALID_ARG;
+    }
+  }
+  return ESP_OK;
+}
+
+/**
+ * @brief Devuelve el historial de un intervalo por trozos
+ */
+static esp_err_t history_handler(httpd_req_t *req) {
+  static const char *const types[] = {"application/json", "text/csv",
+                                      "application/octet-stream"};
+  query_t q;
+  out_t out = {.req = req, .query = &q};
+  source_t src;
+  bucket_t bucket = {.count = 0};
+  history_point_t p;
+
+  if (parse_query(req, &q) != ESP_OK) {
+    return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                               "from, to, step, fields o format no válidos");
+  }
+  httpd_resp_set_type(req, types[q.format]);
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+  source_init(&src, pick_tier(q.from, q.step), q.from, q.to);
+  if (out_begin(&out) != ESP_OK) {
+    return ESP_FAIL;
+  }
+  while (source_next(&src, &p)) {
+    if (q.step == 0) {
+      if (out_row(&out, &p) != ESP_OK) {
+        return ESP_FAIL;
+      }
+      continue;
+    }
+    uint32_t start = p.time - p.time % q.step;
+    if (bucket.count > 0 && bucket.start != start) {
+      history_point_t agg;
+      bucket_to_point(&bucket, &agg);
+      if (out_row(&out, &agg) != ESP_OK) {
+        return ESP_FAIL;
+      }
+      bucket.count = 0;
+    }
+    bucket.start = start;
+    bucket_add(&bucket, &p);
+  }
+  if (bucket.count > 0) {
+    bucket_to_point(&bucket, &p);
+    if (out_row(&out, &p) != ESP_OK) {
+      return ESP_FAIL;
+    }
+  }
+  if (q.format == FORMAT_JSON && out_write(&out, "]}", 2) != ESP_OK) {
+    return ESP_FAIL;
+  }
+  if (out_flush(&out) != ESP_OK) {
+    return ESP_FAIL;
+  }
+  ESP_LOGI(TAG, "%lu puntos de %lu a %lu (step %lu)", (unsigned long)out.rows,
+           (unsigned long)q.from, (unsigned long)q.to, (unsigned long)q.step);
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+esp_err_t history_http_register(httpd_handle_t server) {
+  httpd_uri_t uri = {.uri = "/api/history",
+                     .method = HTTP_GET,
+                     .handler = history_handler,
+                     .user_ctx = NULL};
+  esp_err_t ret = httpd_register_uri_handler(server, &uri);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo registrar /api/history: %s",
+             esp_err_to_name(ret));
+  }
+  return ret;
+}
@@ -0,0 +1,45 @@
+/* Archivo: history_http.h
+ * Descripción: Consulta del historial por HTTP:
+ *
+ *                GET /api/history?from=&to=&step=&fields=&format=
+ *
+ *              from y to son segundos (time()); por defecto la última hora.
+ *              step agrupa en intervalos de step segundos alineados con la
+ *              época (mínimo, máximo y media de cada uno); 0, el valor por
+ *              defecto, devuelve cada lectura. fields es una lista separada
+ *              por comas de temp, hum, temp_min, temp_max, hum_min, hum_max
+ *              y count (por defecto "temp,hum"); el tiempo va siempre
+ *              primero. format es json (por defecto), csv o bin.
+ *
+ *              Los puntos salen del historial en RAM o del registro en
+ *              flash según la resolución pedida y lo que cubra cada uno, y
+ *              se envían por trozos desde un buffer de pila: el resultado
+ *              nunca está entero en memoria.
+ *
+ *              Formato bin (little endian): cabecera de 8 bytes (versión 1
+ *              en uint8, número de campos en uint8, 2 bytes a 0 y step en
+ *              uint32) y una fila por punto con time en uint32 y cada campo
+ *              en int16 (count en uint16), en el orden pedido. Temperaturas
+ *              en décimas de °C y humedades en décimas de %.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_HISTORY_HTTP_H_
+#define MAIN_HISTORY_HTTP_H_
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/**
+ * @brief Registra GET /api/history
+ *
+ * @param server Servidor HTTP ya iniciado
+ * @return esp_err_t Resultado del registro del handler
+ */
+esp_err_t history_http_register(httpd_handle_t server);
+
+#endif /* MAIN_HISTORY_HTTP_H_ */
@@ -0,0 +1,120 @@
+/* Archivo: json_writer.c
+ * Descripción: Escritura de JSON sin memoria dinámica. Ver json_writer.h.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "json_writer.h"
+
+// Separador antes de un valor o una clave
+static void separate(json_writer_t *j) {
+  uint32_t bit = 1u << (j->depth & 31);
+
+  if (j->after_key) {
+    j->after_key = false;
+    return;
+  }
+  if (j->nonempty & bit) {
+    fmt_str(&j->out, ", ");
+  }
+  j->nonempty |= bit;
+}
+
+static void push(json_writer_t *j, const char *bracket) {
+  separate(j);
+  fmt_str(&j->out, bracket);
+  j->depth++;
+  j->nonempty &= ~(1u << (j->depth & 31));
+}
+
+static void pop(json_writer_t *j, const char *bracket) {
+  j->depth--;
+  fmt_str(&j->out, bracket);
+}
+
+static void quoted(json_writer_t *j, const char *s) {
+  static const char hex[] = "0123456789abcdef";
+  const char *run = s;
+
+  fmt_str(&j->out, "\"");
+  for (; *s; s++) {
+    unsigned char c = *s;
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    // Copia de golpe lo que no hay que escapar
+    fmt_strn(&j->out, run, s - run);
+    run = s + 1;
+    switch (c) {
+      case '"': fmt_str(&j->out, "\\\""); break;
+      case '\\': fmt_str(&j->out, "\\\\"); break;
+      case '\n': fmt_str(&j->out, "\\n"); break;
+      case '\r': fmt_str(&j->out, "\\r"); break;
+      case '\t': fmt_str(&j->out, "\\t"); break;
+      default: {
+        char u[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+        fmt_strn(&j->out, u, sizeof(u));
+      }
+    }
+  }
+  fmt_strn(&j->out, run, s - run);
+  fmt_str(&j->out, "\"");
+}
+
+void json_init(json_writer_t *j, char *buf, size_t size) {
+  fmt_init(&j->out, buf, size);
+  j->nonempty = 0;
+  j->depth = 0;
+  j->after_key = false;
+}
+
+void json_object_begin(json_writer_t *j) {
+  push(j, "{");
+}
+
+void json_object_end(json_writer_t *j) {
+  pop(j, "}");
+}
+
+void json_array_begin(json_writer_t *j) {
+  push(j, "[");
+}
+
+void json_array_end(json_writer_t *j) {
+  pop(j, "]");
+}
+
+void json_key(json_writer_t *j, const char *key) {
+  separate(j);
+  quoted(j, key);
+  fmt_str(&j->out, ": ");
+  j->after_key = true;
+}
+
+void json_string(json_writer_t *j, const char *s) {
+  separate(j);
+  quoted(j, s);
+}
+
+void json_int(json_writer_t *j, int32_t value) {
+  separate(j);
+  fmt_int(&j->out, value);
+}
+
+void json_uint(json_writer_t *j, uint32_t value) {
+  separate(j);
+  fmt_uint(&j->out, value);
+}
+
+void json_bool(json_writer_t *j, bool value) {
+  separate(j);
+  fmt_str(&j->out, value ? "true" : "false");
+}
+
+void json_deci(json_writer_t *j, int32_t deci) {
+  separate(j);
+  fmt_deci(&j->out, deci);
+}
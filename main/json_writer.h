@@ -0,0 +1,64 @@
+/* Archivo: json_writer.h
+ * Descripción: Escritura de JSON en streaming sobre un buffer fijo, sin
+ *              memoria dinámica: cada llamada añade su trozo directamente
+ *              (con comas y escapes) en lugar de construir el árbol de
+ *              objetos de cJSON y después imprimirlo. Mismo espaciado que
+ *              el resto de respuestas (", " y ": ").
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_JSON_WRITER_H_
+#define MAIN_JSON_WRITER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fmt.h"
+
+/**
+ * @brief Documento JSON en construcción
+ *
+ * out.len es la longitud escrita; out.overflow indica que no cupo entero.
+ * Hasta 32 niveles de anidamiento.
+ */
+typedef struct {
+  fmt_t out;
+  uint32_t nonempty; // Bit por nivel: ya tiene algún elemento
+  uint8_t depth;
+  bool after_key; // El siguiente valor va tras "clave": sin coma
+} json_writer_t;
+
+/**
+ * @brief Empieza un documento vacío en buf
+ */
+void json_init(json_writer_t *j, char *buf, size_t size);
+
+void json_object_begin(json_writer_t *j);
+void json_object_end(json_writer_t *j);
+void json_array_begin(json_writer_t *j);
+void json_array_end(json_writer_t *j);
+
+/**
+ * @brief Añade una clave al objeto abierto; el siguiente valor es el suyo
+ */
+void json_key(json_writer_t *j, const char *key);
+
+/**
+ * @brief Añade una cadena escapada (UTF-8 tal cual)
+ */
+void json_string(json_writer_t *j, const char *s);
+
+void json_int(json_writer_t *j, int32_t value);
+void json_uint(json_writer_t *j, uint32_t value);
+void json_bool(json_writer_t *j, bool value);
+
+/**
+ * @brief Añade décimas como número con un decimal (234 -> 23.4)
+ */
+void json_deci(json_writer_t *j, int32_t deci);
+
+#endif /* MAIN_JSON_WRITER_H_ */
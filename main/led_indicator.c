@@ -0,0 +1,81 @@
+/* Archivo: led_indicator.c
+ * Descripción: LED indicador movido por un esp_timer. Ver led_indicator.h.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "led_indicator.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const uint16_t s_alarm[] = {500, 500};
+static const uint16_t s_sensor_error[] = {100, 100, 100, 700};
+static const uint16_t s_on[] = {0};
+
+const led_pattern_t LED_PATTERN_OFF = {NULL, 0};
+const led_pattern_t LED_PATTERN_ON = {s_on, 1};
+const led_pattern_t LED_PATTERN_ALARM = {s_alarm, 2};
+const led_pattern_t LED_PATTERN_SENSOR_ERROR = {s_sensor_error, 4};
+
+static const char *TAG = "LED";
+
+static gpio_num_t s_gpio = GPIO_NUM_NC;
+static esp_timer_handle_t s_timer = NULL;
+static const led_pattern_t *s_pattern = &LED_PATTERN_OFF;
+static uint8_t s_step = 0;
+// Protege el patrón y el paso (tarea que llama a set y tarea de esp_timer)
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Aplica el paso actual y programa el siguiente; con s_lock tomado
+static void apply_step(void) {
+  gpio_set_level(s_gpio, s_pattern->count > 0 && s_step % 2 == 0);
+  if (s_pattern->count > 1) {
+    esp_timer_start_once(s_timer, s_pattern->steps[s_step] * 1000ULL);
+  }
+}
+
+static void timer_cb(void *arg) {
+  taskENTER_CRITICAL(&s_lock);
+  // Un disparo ya en curso cuando set() dejó un patrón fijo no hace nada
+  if (s_pattern->count > 1) {
+    s_step = (s_step + 1) % s_pattern->count;
+    apply_step();
+  }
+  taskEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t led_indicator_init(gpio_num_t gpio) {
+  const esp_timer_create_args_t args = {.callback = timer_cb, .name = "led"};
+  esp_err_t ret = esp_timer_create(&args, &s_timer);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo crear el temporizador: %s",
+             esp_err_to_name(ret));
+    return ret;
+  }
+
+  s_gpio = gpio;
+  gpio_reset_pin(gpio);
+  gpio_set_direction(gpio, GPIO_MODE_OUTPUT);
+  gpio_set_level(gpio, 0); // Inicia con el LED apagado
+  return ESP_OK;
+}
+
+void led_indicator_set(const led_pattern_t *pattern) {
+  if (s_timer == NULL) {
+    return;
+  }
+  taskENTER_CRITICAL(&s_lock);
+  if (pattern != s_pattern) {
+    // Sin efecto si no estaba programado
+    esp_timer_stop(s_timer);
+    s_pattern = pattern;
+    s_step = 0;
+    apply_step();
+  }
+  taskEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,54 @@
+/* Archivo: led_indicator.h
+ * Descripción: LED indicador movido por un esp_timer. Un patrón es una
+ *              secuencia de duraciones que alternan encendido y apagado y
+ *              se repite; cada cambio de nivel lo hace el callback del
+ *              temporizador, sin tarea propia y sin reservar memoria al
+ *              cambiar de patrón.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_LED_INDICATOR_H_
+#define MAIN_LED_INDICATOR_H_
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+/**
+ * @brief Patrón de parpadeo
+ *
+ * steps[0] ms encendido, steps[1] ms apagado, steps[2] encendido... y
+ * vuelta a empezar; count debe ser par. Con count 0 el LED queda apagado y
+ * con count 1 encendido fijo.
+ */
+typedef struct {
+  const uint16_t *steps;
+  uint8_t count;
+} led_pattern_t;
+
+extern const led_pattern_t LED_PATTERN_OFF;
+extern const led_pattern_t LED_PATTERN_ON;
+// Temperatura sobre el umbral, relé activado: 500 ms encendido y apagado
+extern const led_pattern_t LED_PATTERN_ALARM;
+// Error de lectura del sensor: dos destellos cortos por segundo
+extern const led_pattern_t LED_PATTERN_SENSOR_ERROR;
+
+/**
+ * @brief Configura el GPIO del LED y crea el temporizador, apagado
+ */
+esp_err_t led_indicator_init(gpio_num_t gpio);
+
+/**
+ * @brief Cambia de patrón
+ *
+ * Sin efecto si ya es el actual, así se puede llamar en cada lectura sin
+ * reiniciar la secuencia. pattern debe seguir existiendo mientras se use.
+ */
+void led_indicator_set(const led_pattern_t *pattern);
+
+#endif /* MAIN_LED_INDICATOR_H_ */
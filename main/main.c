@@ -25,24 +25,46 @@
  * Estructura del código:
  *  - Inicialización: NVS, SPIFFS, WiFi, servidor HTTP, MQTT, Telegram
  *  - Handlers HTTP: Página principal, CSS, JavaScript, WebSocket
- *  - Tarea DHT11: Lectura periódica del sensor y actualización de displays
- *  - WebSocket: Envío de datos en tiempo real a clientes conectados
+ *  - Servicio de sensor: Lectura del DHT11 con caché y reintentos
+ *    (sensor_service.c)
+ *  - Instantánea: lectura, Min/Max y relé publicados para el resto de
+ *    tareas sin bloqueos (sensor_snapshot.c)
+ *  - Estadísticas móviles: Min/Max, media, desviación y EWMA de la última
+ *    hora y del último día (rolling_stats.c)
+ *  - Formateo: lecturas en décimas enteras y textos sin coma flotante ni
+ *    printf (fmt.c); medida opcional de ciclos (sample_bench.c)
+ *  - Historial: lecturas y agregados por minuto y hora en RAM (history.c)
+ *    y registro persistente en la partición history (history_flash.c);
+ *    consulta por intervalos en /api/history (history_http.c)
+ *  - Tarea DHT11: Control del relé y reparto de cada lectura a los destinos
+ *  - Lectura codificada una sola vez y compartida por referencias entre
+ *    destinos y /api/latest (payload.c, json_writer.c)
+ *  - Destinos: OLED, MQTT, WebSocket, flash y alertas de Telegram, cada uno
+ *    con su cola y su tarea (sink.c); estadísticas en /api/sinks
+ *  - WebSocket: Envío de datos en tiempo real a clientes conectados con
+ *    el formato, los campos y el ritmo que pide cada uno (ws_clients.c)
  *  - MQTT: Publicación de datos a broker MQTT
  *  - Telegram: Envío de alertas y manejo de comandos
  *  - Control de relé: Activa/desactiva salida e indicador LED según temperatura
+ *  - LED indicador: patrones de parpadeo por estado movidos por un esp_timer
+ *    (led_indicator.c)
+ *  - Métricas del sistema: pila libre y CPU por tarea y estado del heap en
+ *    /api/system y MQTT_TOPIC "/system" (sys_metrics.c)
+ *  - Prometheus: lectura, contadores y métricas del sistema en /metrics
+ *    en formato de texto, sin memoria dinámica (metrics_http.c)
  *
  * Funciones principales:
- *  - dht11_task: Tarea para lectura periódica de sensores
+ *  - dht11_task: Tarea que procesa cada lectura del servicio de sensor
+ *  - start_sinks: Registro de los destinos de las lecturas
  *  - telegram_bot_task: Tarea para manejar actualizaciones de Telegram
  *  - mqtt_event_handler: Manejo de eventos MQTT
  *  - event_handler: Manejo de eventos WiFi e IP
  *  - mount_spiffs: Montaje del sistema de archivos SPIFFS
  *  - read_wifi_config: Lectura de credenciales WiFi
  *  - wifi_init_sta: Inicialización de conexión WiFi
+ *  - start_sntp: Sincronización de la hora para el historial
  *  - start_webserver: Configuración e inicio del servidor web
- *  - send_ws_message: Envío de mensajes a clientes WebSocket
  *  - init_relay: Inicialización de pines de control (relé y LED)
- *  - blink_led_task: Tarea para parpadeo de LED indicador
  *  - display_centered_text: Utilidad para mostrar texto centrado en OLED
  *
  * Nota: Este proyecto usa Licencia MIT. Se recomienda (no obliga) mantener
@@ -57,9 +79,26 @@
 #include <string.h>
 
 #include "dht.h"
+#include "fmt.h"
+#include "history.h"
+#include "history_flash.h"
+#include "history_http.h"
+#include "json_writer.h"
+#include "led_indicator.h"
+#include "metrics_http.h"
+#include "payload.h"
+#include "rolling_stats.h"
+#include "sample_bench.h"
+#include "screen_mirror.h"
+#include "sensor_service.h"
+#include "sensor_snapshot.h"
+#include "sink.h"
 #include "ssd1306.h"
+#include "sys_metrics.h"
+#include "ws_clients.h"
 
 #include "esp_event.h"
+#include "esp_netif_sntp.h"
 #include "esp_http_server.h"
 #include "esp_spiffs.h"
 #include "esp_wifi.h"
@@ -72,6 +111,8 @@
 #include "cJSON.h"
 #include "esp_tls.h"
 #include "esp_timer.h"
+#include <time.h>
+#include <unistd.h>
 
 // Variable global para almacenar la dirección IP
 char ip_address[16] = "Conectando...";
@@ -101,14 +142,6 @@ static int s_retry_num = 0;
 static httpd_handle_t server = NULL;
 // static int hd_fd = -1; // WebSocket file descriptor
 
-// Variables para seguimiento de Min/Max
-static float min_temp = 100.0;
-static float max_temp = -100.0;
-static float min_hum = 100.0;
-static float max_hum = 0.0;
-static float current_temp = 0.0;
-static float current_hum = 0.0;
-
 // Estructura para credenciales WiFi
 typedef struct {
   char ssid[32];
@@ -118,6 +151,7 @@ typedef struct {
 app_wifi_config_t wifi_creds;
 
 #define DHT_GPIO 4 // Pin del sensor DHT11
+#define SENSOR_PERIOD_MS CONFIG_SENSOR_PERIOD_MS // Periodo de lectura
 #define tag "SSD1306"
 static const char *TAG = "DHT11_ALERTA";
 
@@ -173,6 +207,19 @@ static void mqtt_app_start(void) {
   esp_mqtt_client_start(mqtt_client);
 }
 
+/**
+ * @brief Publica cada muestra de las métricas del sistema en
+ * MQTT_TOPIC "/system"
+ *
+ * Con QoS 0: sin conexión la muestra se pierde, la siguiente la sustituye.
+ */
+static void publish_system_metrics(const char *json, size_t len, void *ctx) {
+  if (esp_mqtt_client_publish(mqtt_client, MQTT_TOPIC "/system", json, len, 0,
+                              0) < 0) {
+    ESP_LOGD(TAG, "Métricas del sistema no publicadas");
+  }
+}
+
 static void event_handler(void *arg, esp_event_base_t event_base,
                           int32_t event_id, void *event_data) {
   if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
@@ -197,6 +244,21 @@ static void event_handler(void *arg, esp_event_base_t event_base,
   }
 }
 
+/**
+ * @brief Arranca la sincronización de la hora por SNTP
+ *
+ * El historial guarda time(); el registro en flash no acepta lecturas hasta
+ * la primera sincronización.
+ */
+static void start_sntp(void) {
+  esp_sntp_config_t config =
+      ESP_NETIF_SNTP_DEFAULT_CONFIG(CONFIG_HISTORY_FLASH_SNTP_SERVER);
+  esp_err_t ret = esp_netif_sntp_init(&config);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo iniciar SNTP: %s", esp_err_to_name(ret));
+  }
+}
+
 /**
  * @brief Monta el sistema de archivos SPIFFS
  *
@@ -379,7 +441,12 @@ static esp_err_t ws_handler(httpd_req_t *req) {
   // El handler se llama después del handshake para manejar frames WebSocket
 
   httpd_ws_frame_t ws_pkt = {0};
-  uint8_t *buf = NULL;
+  uint8_t buf[WS_COMMAND_MAX];
+
+  // Cliente nuevo: suscripción de la URL (?format=&fields=&interval_ms=)
+  if (req->method == HTTP_GET) {
+    ws_clients_open(req);
+  }
 
   // Obtener la longitud del frame
   esp_err_t ret = httpd_ws_recv_frame(req, &ws_pkt, 0);
@@ -394,24 +461,25 @@ static esp_err_t ws_handler(httpd_req_t *req) {
     return ret;
   }
 
-  // Si hay datos, leerlos
+  // Si hay datos, leerlos: los frames de texto son comandos de suscripción
   if (ws_pkt.len) {
-    buf = calloc(1, ws_pkt.len + 1);
-    if (buf == NULL) {
-      ESP_LOGE(TAG, "Failed to calloc memory for buf");
-      return ESP_ERR_NO_MEM;
+    if (ws_pkt.len > sizeof(buf)) {
+      // Al devolver error el servidor cierra la conexión
+      ESP_LOGW(TAG, "Frame de %u bytes descartado", (unsigned)ws_pkt.len);
+      return ESP_ERR_INVALID_SIZE;
     }
 
     ws_pkt.payload = buf;
     ret = httpd_ws_recv_frame(req, &ws_pkt, ws_pkt.len);
     if (ret != ESP_OK) {
       ESP_LOGE(TAG, "httpd_ws_recv_frame failed: %s", esp_err_to_name(ret));
-      free(buf);
       return ret;
     }
 
-    ESP_LOGI(TAG, "Mensaje recibido: %.*s", ws_pkt.len, ws_pkt.payload);
-    free(buf);
+    ESP_LOGD(TAG, "Mensaje recibido: %.*s", (int)ws_pkt.len, ws_pkt.payload);
+    if (ws_pkt.type == HTTPD_WS_TYPE_TEXT) {
+      return ws_clients_command(req, (const char *)buf, ws_pkt.len);
+    }
   } else {
     // Frame vacío (ping/pong o handshake completado)
     if (req->method == HTTP_GET) {
@@ -479,14 +547,45 @@ static esp_err_t js_handler(httpd_req_t *req) {
   return ESP_OK;
 }
 
+/**
+ * @brief Callback de cierre de sesión del servidor HTTP
+ *
+ * Informa a los módulos que siguen clientes WebSocket por descriptor antes de
+ * cerrar el socket, para que un descriptor reutilizado no herede su estado.
+ *
+ * @param hd Manejador del servidor (no utilizado)
+ * @param sockfd Descriptor del socket que se cierra
+ */
+static void http_close_fn(httpd_handle_t hd, int sockfd) {
+  screen_mirror_on_close(sockfd);
+  ws_clients_on_close(sockfd);
+  close(sockfd);
+}
+
 /**
  * @brief Inicia el servidor HTTP con soporte WebSocket
  *
  * Inicializa y configura el servidor HTTP con los siguientes endpoints:
  * - GET / : Sirve la página HTML principal
  * - GET /style.css : Sirve la hoja de estilos CSS
- * - GET /script.js : Sirve el archivo JavaScript
+ * - GET /main.js : Sirve el archivo JavaScript
  * - GET /ws : Endpoint WebSocket para actualizaciones en tiempo real
+ *   (/ws?format=cbor para recibirlas en CBOR)
+ *
+ * Los demás los registra cada módulo desde app_main una vez arrancado:
+ * - GET /screen, /screen/ws : Imagen PBM de la pantalla OLED y WebSocket
+ *   con sus cambios (screen_mirror_register)
+ * - GET /api/sensor, /api/sensor/diag, /api/sensor/timing : Última lectura
+ *   en caché, diagnósticos de lectura y regularidad del muestreo
+ *   (sensor_service_register)
+ * - GET /api/sinks : Estadísticas de los destinos (sink_register_http)
+ * - GET /api/history : Historial de lecturas (history_http_register)
+ * - GET /api/latest : Documento JSON de la última lectura
+ *   (payload_register_http)
+ * - GET /api/system : Pila, CPU y heap (sys_metrics_register_http)
+ * - GET /metrics : Métricas para Prometheus (metrics_http_register)
+ *
+ * En total 14 de los 16 max_uri_handlers.
  *
  * @return httpd_handle_t Manejador del servidor HTTP iniciado
  *
@@ -501,6 +600,10 @@ static httpd_handle_t start_webserver(void) {
   config.ctrl_port = 32768;
   config.lru_purge_enable =
       true; // Importante para limpiar conexiones inactivas
+  config.close_fn = http_close_fn;
+  // Los módulos registran sus propios endpoints además de los de aquí: 14
+  // en total, ver arriba
+  config.max_uri_handlers = 16;
 
   ESP_LOGI(TAG, "Iniciando servidor web en el puerto: %d", config.server_port);
   if (httpd_start(&server, &config) == ESP_OK) {
@@ -542,84 +645,18 @@ static httpd_handle_t start_webserver(void) {
   return NULL;
 }
 
-/**
- * @brief Envía un mensaje a todos los clientes WebSocket conectados
- *
- * @param msg Cadena terminada en nulo que contiene el mensaje a enviar
- *
- * @note El mensaje se enviará a todos los clientes WebSocket actualmente
- * conectados
- *
- * @related_header
- * - esp_http_server.h
- */
-void send_ws_message(char *msg) {
-  if (!server) {
-    ESP_LOGW(TAG,
-             "Servidor no inicializado, no se puede enviar mensaje WebSocket");
-    return;
-  }
-
-  size_t fds = 10;
-  int client_fds[10];
-
-  esp_err_t ret = httpd_get_client_list(server, &fds, client_fds);
-  if (ret != ESP_OK) {
-    ESP_LOGW(TAG, "No se pudieron obtener clientes: %s", esp_err_to_name(ret));
-    return;
-  }
-
-  if (fds == 0) {
-    ESP_LOGD(TAG, "No hay clientes conectados");
-    return;
-  }
-
-  httpd_ws_frame_t ws_pkt = {.payload = (uint8_t *)msg,
-                             .len = strlen(msg),
-                             .type = HTTPD_WS_TYPE_TEXT};
-
-  for (int i = 0; i < fds; i++) {
-    ret = httpd_ws_send_frame_async(server, client_fds[i], &ws_pkt);
-    if (ret != ESP_OK) {
-      ESP_LOGW(TAG, "Error enviando a cliente %d: %s", client_fds[i],
-               esp_err_to_name(ret));
-    } else {
-      ESP_LOGD(TAG, "Mensaje enviado a cliente %d: %s", client_fds[i], msg);
-    }
-  }
-}
-
 // Definiciones para el control del relé
 #define RELAY_GPIO 1        // Pin GPIO para el relé
-#define TEMP_THRESHOLD 30.0 // Umbral de temperatura en grados Celsius
+#define TEMP_THRESHOLD 300  // Umbral de temperatura en décimas de °C
 #define LED_GPIO 21         // Pin GPIO para el LED indicador
 
-static TaskHandle_t blink_task_handle = NULL;
-
-/**
- * @brief Tarea para parpadear el LED indicador
- * 
- * Esta tarea se activa cuando el relé está encendido para proporcionar
- * una indicación visual intermitente.
- * 
- * @param pvParameters Parámetros de la tarea (no utilizado)
- */
-void blink_led_task(void *pvParameters) {
-  while (1) {
-    gpio_set_level(LED_GPIO, 1);
-    vTaskDelay(500 / portTICK_PERIOD_MS);
-    gpio_set_level(LED_GPIO, 0);
-    vTaskDelay(500 / portTICK_PERIOD_MS);
-  }
-}
-
 // Variable global para la estructura del display
 SSD1306_t oled_dev;
 
 /**
  * @brief Inicializa los pines de control (Relé y LED)
  * 
- * Configura el GPIO del relé como entrada/salida y el GPIO del LED como salida.
+ * Configura el GPIO del relé como entrada/salida y el LED indicador.
  * Inicializa ambos en estado bajo (apagado).
  */
 static void init_relay(void) {
@@ -627,9 +664,7 @@ static void init_relay(void) {
   gpio_set_direction(RELAY_GPIO, GPIO_MODE_INPUT_OUTPUT);
   gpio_set_level(RELAY_GPIO, 0); // Inicia con el relé apagado
   
-  gpio_reset_pin(LED_GPIO);
-  gpio_set_direction(LED_GPIO, GPIO_MODE_OUTPUT);
-  gpio_set_level(LED_GPIO, 0); // Inicia con el LED apagado
+  led_indicator_init(LED_GPIO);
 
   ESP_LOGI(TAG, "Relé inicializado en GPIO %d, LED en GPIO %d", RELAY_GPIO, LED_GPIO);
 }
@@ -669,8 +704,9 @@ void display_centered_text(const char *text, int line, bool clear_line) {
  * al chat ID configurado.
  * 
  * @param message Mensaje de texto a enviar
+ * @return esp_err_t ESP_OK si la API aceptó la petición
  */
-void send_telegram_message(const char *message) {
+esp_err_t send_telegram_message(const char *message) {
     char url[512];
     
     snprintf(url, sizeof(url), "%s%s/sendMessage", TELEGRAM_API_URL, TELEGRAM_TOKEN);
@@ -686,17 +722,27 @@ void send_telegram_message(const char *message) {
     esp_http_client_handle_t client = esp_http_client_init(&config);
     if (!client) {
         ESP_LOGE(TAG, "Failed to init HTTP client");
-        return;
+        return ESP_FAIL;
     }
 
-    // Create JSON payload
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "chat_id", TELEGRAM_CHAT_ID);
-    cJSON_AddStringToObject(root, "text", message);
-    char *post_data = cJSON_PrintUnformatted(root);
+    // Cuerpo JSON escrito directamente en la pila, sin árbol de cJSON
+    char post_data[512];
+    json_writer_t body;
+    json_init(&body, post_data, sizeof(post_data));
+    json_object_begin(&body);
+    json_key(&body, "chat_id");
+    json_string(&body, TELEGRAM_CHAT_ID);
+    json_key(&body, "text");
+    json_string(&body, message);
+    json_object_end(&body);
+    if (body.out.overflow) {
+        ESP_LOGE(TAG, "Telegram message too long");
+        esp_http_client_cleanup(client);
+        return ESP_ERR_INVALID_SIZE;
+    }
 
     esp_http_client_set_header(client, "Content-Type", "application/json");
-    esp_http_client_set_post_field(client, post_data, strlen(post_data));
+    esp_http_client_set_post_field(client, post_data, body.out.len);
 
     esp_err_t err = esp_http_client_perform(client);
     if (err == ESP_OK) {
@@ -705,9 +751,8 @@ void send_telegram_message(const char *message) {
         ESP_LOGE(TAG, "Failed to send Telegram message: %s", esp_err_to_name(err));
     }
 
-    cJSON_Delete(root);
-    free(post_data);
     esp_http_client_cleanup(client);
+    return err;
 }
 
 /**
@@ -763,16 +808,36 @@ void handle_telegram_updates(void) {
                                     ESP_LOGI(TAG, "Received command: %s", text->valuestring);
                                     
                                     if (strncmp(text->valuestring, "/status", 7) == 0) {
-                                        char status_msg[128];
-                                        snprintf(status_msg, sizeof(status_msg), 
-                                                 "Status:\nTemp: %.1f°C\nHum: %.1f%%\nRelay: %s", 
-                                                 current_temp, current_hum, 
-                                                 gpio_get_level(RELAY_GPIO) ? "ON" : "OFF");
+                                        // Instantánea publicada: el comando nunca lee el sensor.
+                                        // Mínimo y máximo de la ventana larga, como en MQTT
+                                        sensor_snapshot_t snap;
+                                        rolling_stats_t stats;
+                                        char status_msg[200];
+                                        sensor_snapshot_read(&snap);
+                                        rolling_stats_get(ROLLING_LONG, &stats);
+                                        if (snap.seq > 0) {
+                                            snprintf(status_msg, sizeof(status_msg), 
+                                                     "Status:\nTemp: " DECI_FMT "°C (" DECI_FMT "/" DECI_FMT ")\n"
+                                                     "Hum: " DECI_FMT "%% (" DECI_FMT "/" DECI_FMT ")\n"
+                                                     "Min/Max: últimas %lu %s\nEdad: %llus\nRelay: %s", 
+                                                     DECI_ARGS(snap.temperature), DECI_ARGS(stats.temperature.min), DECI_ARGS(stats.temperature.max),
+                                                     DECI_ARGS(snap.humidity), DECI_ARGS(stats.humidity.min), DECI_ARGS(stats.humidity.max),
+                                                     (unsigned long)(stats.window_s >= 3600 ? stats.window_s / 3600 : stats.window_s / 60),
+                                                     stats.window_s >= 3600 ? "h" : "min",
+                                                     (unsigned long long)((esp_timer_get_time() - snap.timestamp) / 1000000),
+                                                     snap.relay ? "ON" : "OFF");
+                                        } else {
+                                            snprintf(status_msg, sizeof(status_msg), 
+                                                     "Status:\nSin lecturas del sensor\nRelay: %s", 
+                                                     gpio_get_level(RELAY_GPIO) ? "ON" : "OFF");
+                                        }
                                         send_telegram_message(status_msg);
                                     } else if (strncmp(text->valuestring, "/relay", 6) == 0) {
                                         char relay_msg[64];
+                                        sensor_snapshot_t snap;
+                                        sensor_snapshot_read(&snap);
                                         snprintf(relay_msg, sizeof(relay_msg), "Relay is %s", 
-                                                 gpio_get_level(RELAY_GPIO) ? "ON" : "OFF");
+                                                 snap.relay ? "ON" : "OFF");
                                         send_telegram_message(relay_msg);
                                     }
                                 }
@@ -806,22 +871,212 @@ void telegram_bot_task(void *pvParameters) {
 }
 
 /**
- * @brief Tarea para leer datos del sensor DHT11
+ * @brief Destino pantalla OLED: lectura actual o Min/Max y aviso de error
+ *
+ * Alterna cada 3 lecturas entre los valores actuales y los extremos de la
+ * ventana larga (24 h por defecto), y replica los cambios a los clientes
+ * del espejo de pantalla. Solo esta tarea dibuja en la pantalla una vez
+ * arrancados los destinos.
+ */
+static esp_err_t oled_sink_deliver(const sink_event_t *event, void *ctx) {
+  static int display_counter = 0;
+  const sensor_snapshot_t *snap = &event->snap;
+  const rolling_stats_t *stats = &event->stats;
+  char lineChar[20];
+  fmt_t line;
+
+  if (event->status == ESP_OK) {
+    display_counter++;
+    if (display_counter % 3 == 0) {
+      // Mostrar Min/Max
+      fmt_init(&line, lineChar, sizeof(lineChar));
+      fmt_str(&line, "Min:");
+      fmt_deci_round(&line, stats->temperature.min);
+      fmt_str(&line, " Max:");
+      fmt_deci_round(&line, stats->temperature.max);
+      ssd1306_display_text(&oled_dev, 5, lineChar, line.len, false);
+
+      fmt_init(&line, lineChar, sizeof(lineChar));
+      fmt_str(&line, "m:");
+      fmt_deci_round(&line, stats->humidity.min);
+      fmt_str(&line, " M:");
+      fmt_deci_round(&line, stats->humidity.max);
+      fmt_str(&line, " %");
+      ssd1306_display_text(&oled_dev, 6, lineChar, line.len, false);
+    } else {
+      // Mostrar Actual
+      fmt_init(&line, lineChar, sizeof(lineChar));
+      fmt_str(&line, "Temp.: ");
+      fmt_deci(&line, snap->temperature);
+      fmt_str(&line, " C");
+      ssd1306_display_text(&oled_dev, 5, lineChar, line.len, false);
+
+      fmt_init(&line, lineChar, sizeof(lineChar));
+      fmt_str(&line, "Hum.: ");
+      fmt_deci(&line, snap->humidity);
+      fmt_str(&line, " %");
+      ssd1306_display_text(&oled_dev, 6, lineChar, line.len, false);
+    }
+    display_centered_text("Datos enviados", 7, true);
+  } else {
+    ssd1306_display_text(&oled_dev, 5, "Error lectura", 13, false);
+    ssd1306_display_text(&oled_dev, 6, "Revisa conexiones", 17, false);
+  }
+
+  // Replicar los cambios de la pantalla a los clientes remotos
+  screen_mirror_poll();
+  return ESP_OK;
+}
+
+/**
+ * @brief Destino MQTT: publica la lectura en JSON en MQTT_TOPIC y/o en CBOR
+ * en MQTT_TOPIC "/bin", según CONFIG_MQTT_FORMAT
+ *
+ * El JSON es el documento de siempre (temperatura, humedad, min_temp,
+ * max_temp), ya codificado en el payload como los demás.
+ *
+ * Con QoS 1 el cliente guarda el mensaje en su outbox si no hay conexión.
+ */
+static esp_err_t mqtt_sink_deliver(const sink_event_t *event, void *ctx) {
+  size_t len;
+
+  if (event->payload == NULL) {
+    return event->status == ESP_OK ? ESP_ERR_NO_MEM : ESP_OK;
+  }
+#if !CONFIG_MQTT_FORMAT_CBOR
+  const char *json = payload_data(event->payload, PAYLOAD_JSON_MQTT, &len);
+  if (esp_mqtt_client_publish(mqtt_client, MQTT_TOPIC, json, len, 1, 0) < 0) {
+    return ESP_FAIL;
+  }
+  ESP_LOGD(TAG, "Datos publicados en MQTT: %s", json);
+#endif
+#if !CONFIG_MQTT_FORMAT_JSON
+  const char *cbor = payload_data(event->payload, PAYLOAD_CBOR, &len);
+  if (esp_mqtt_client_publish(mqtt_client, MQTT_TOPIC "/bin", cbor, len, 1,
+                              0) < 0) {
+    return ESP_FAIL;
+  }
+  ESP_LOGD(TAG, "Datos publicados en MQTT: %u bytes CBOR", (unsigned)len);
+#endif
+  return ESP_OK;
+}
+
+/**
+ * @brief Destino WebSocket: envía la lectura a cada cliente en su formato
+ */
+static esp_err_t ws_sink_deliver(const sink_event_t *event, void *ctx) {
+  if (event->payload == NULL) {
+    return event->status == ESP_OK ? ESP_ERR_NO_MEM : ESP_OK;
+  }
+  if (!server) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  return ws_clients_send(server, event->payload);
+}
+
+/**
+ * @brief Destino Telegram: alerta de temperatura alta con enfriamiento
+ *
+ * El POST HTTPS puede tardar segundos; en su propia tarea no retrasa la
+ * lectura ni a los demás destinos.
+ */
+static esp_err_t telegram_sink_deliver(const sink_event_t *event, void *ctx) {
+  const sensor_snapshot_t *snap = &event->snap;
+
+  if (event->status != ESP_OK || !snap->relay) {
+    return ESP_OK;
+  }
+  int64_t now = esp_timer_get_time() / 1000;
+  if (now - last_alert_time <= ALERT_COOLDOWN_MS) {
+    return ESP_OK;
+  }
+  char alert_msg[128];
+  fmt_t msg;
+  fmt_init(&msg, alert_msg, sizeof(alert_msg));
+  fmt_str(&msg, "⚠️ ALERTA: Temperatura Alta!\nValor: ");
+  fmt_deci(&msg, snap->temperature);
+  fmt_str(&msg, "°C\nUmbral: ");
+  fmt_deci(&msg, TEMP_THRESHOLD);
+  fmt_str(&msg, "°C");
+  esp_err_t ret = send_telegram_message(alert_msg);
+  if (ret == ESP_OK) {
+    last_alert_time = now;
+  }
+  return ret;
+}
+
+/**
+ * @brief Destino flash: guarda cada lectura válida en el registro persistente
+ *
+ * Un borrado de sector tarda decenas de ms; en su tarea no retrasa a los
+ * demás destinos. Sin hora de SNTP no se guarda nada.
+ */
+static esp_err_t flash_sink_deliver(const sink_event_t *event, void *ctx) {
+  const sensor_snapshot_t *snap = &event->snap;
+  time_t now = time(NULL);
+
+  if (event->status != ESP_OK || now < HISTORY_FLASH_MIN_TIME) {
+    return ESP_OK;
+  }
+  // Hora de la lectura, no la de la entrega
+  now -= (esp_timer_get_time() - snap->timestamp) / 1000000;
+  return history_flash_append((uint32_t)now, snap->temperature,
+                              snap->humidity);
+}
+
+/**
+ * @brief Registra los destinos de las lecturas
+ *
+ * Pantalla y Telegram solo necesitan el último estado (cola de 1); MQTT
+ * conserva unas cuantas lecturas para no perderlas en cortes breves y la
+ * flash no debe perder ninguna mientras se borra un sector.
+ */
+static void start_sinks(void) {
+  static const sink_config_t sinks[] = {
+      {.name = "oled", .deliver = oled_sink_deliver, .depth = 1,
+       .drop = SINK_DROP_OLDEST, .stack = 3072, .priority = 4,
+       .window = ROLLING_LONG},
+      {.name = "mqtt", .deliver = mqtt_sink_deliver, .depth = 8,
+       .drop = SINK_DROP_OLDEST, .stack = 3072, .priority = 4},
+      {.name = "ws", .deliver = ws_sink_deliver, .depth = 2,
+       .drop = SINK_DROP_OLDEST, .stack = 3072, .priority = 4},
+      {.name = "telegram", .deliver = telegram_sink_deliver, .depth = 1,
+       .drop = SINK_DROP_OLDEST, .stack = 8192, .priority = 3},
+  };
+  static const sink_config_t flash_sink = {
+      .name = "flash", .deliver = flash_sink_deliver, .depth = 16,
+      .drop = SINK_DROP_OLDEST, .stack = 3072, .priority = 2};
+
+  for (int i = 0; i < sizeof(sinks) / sizeof(sinks[0]); i++) {
+    esp_err_t ret = sink_register(&sinks[i]);
+    if (ret != ESP_OK) {
+      ESP_LOGE(TAG, "No se pudo arrancar el destino %s: %s", sinks[i].name,
+               esp_err_to_name(ret));
+    }
+  }
+
+  // El registro en flash solo si existe la partición history
+  if (history_flash_init() == ESP_OK && sink_register(&flash_sink) != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo arrancar el destino flash");
+  }
+}
+
+/**
+ * @brief Tarea que procesa cada resultado del sensor DHT11
  *
- * Lee periódicamente la temperatura y humedad del sensor DHT11,
- * actualiza la pantalla OLED y envía los datos a los clientes WebSocket
- * conectados.
+ * Prepara la pantalla, arranca los destinos y, por cada resultado del
+ * servicio de sensor, controla el relé, publica la instantánea y la
+ * reparte a los destinos (OLED, MQTT, WebSocket, Telegram) sin esperar a
+ * ninguno.
  *
  * @param pvParameters Parámetros de la tarea (no utilizado)
  *
  * @related_header
- * - dht.h
- * - ssd1306.h
- * - freertos/task.h
+ * - sensor_service.h
+ * - sensor_snapshot.h
+ * - sink.h
  */
 void dht11_task(void *pvParameters) {
-  char lineChar[20];
-
   // Configurar hardware
   ESP_LOGI(TAG, "Iniciando monitor DHT11 en GPIO %d", DHT_GPIO);
 
@@ -847,107 +1102,80 @@ void dht11_task(void *pvParameters) {
   // Línea separadora
   ssd1306_display_text(&oled_dev, 7, "----------------", 16, false);
 
-  int display_counter = 0;
+  // A partir de aquí solo el destino OLED dibuja en la pantalla
+  start_sinks();
 
-  while (1) {
-    int16_t temperature, humidity;
-    esp_err_t result = dht_read_data(DHT_TYPE_DHT11, (gpio_num_t)DHT_GPIO,
-                                     &humidity, &temperature);
+  uint32_t last_seq = 0;
+  int last_relay = 0;
 
+  while (1) {
+    // Esperar el siguiente resultado del servicio de sensor
+    sensor_sample_t sample;
+    esp_err_t result = sensor_service_wait(&sample, last_seq,
+                                           pdMS_TO_TICKS(3 * SENSOR_PERIOD_MS));
     if (result == ESP_OK) {
-      float temp_c = temperature / 10.0;
-      float hum_p = humidity / 10.0;
-      
-      current_temp = temp_c;
-      current_hum = hum_p;
+      last_seq = sample.seq;
+      result = sample.status;
+    }
 
-      // Actualizar Min/Max
-      if (temp_c < min_temp) min_temp = temp_c;
-      if (temp_c > max_temp) max_temp = temp_c;
-      if (hum_p < min_hum) min_hum = hum_p;
-      if (hum_p > max_hum) max_hum = hum_p;
+    if (result == ESP_OK) {
+      // Décimas enteras de punta a punta: el C3 no tiene FPU
+      int relay_state = (sample.temperature > TEMP_THRESHOLD) ? 1 : 0;
+
+      // Publicar lectura y relé para el resto de tareas; los Min/Max salen
+      // de rolling_stats
+      sensor_snapshot_publish(sample.temperature, sample.humidity, relay_state,
+                              sample.timestamp);
+      // Hora de la lectura, no la de esta tarea: las lecturas llegan a
+      // intervalos regulares aunque esta tarea se retrase
+      time_t sample_time =
+          time(NULL) - (esp_timer_get_time() - sample.timestamp) / 1000000;
+      // Sin hora de SNTP el reloj cuenta desde 1970 y esos puntos quedarían
+      // sueltos al principio del historial; mismo criterio que la flash
+      if (sample_time >= HISTORY_FLASH_MIN_TIME) {
+        history_add((uint32_t)sample_time, sample.temperature,
+                    sample.humidity);
+      }
+      rolling_stats_add(sample.timestamp, sample.temperature, sample.humidity);
 
-      // Mostrar temperatura en la consola
-      ESP_LOGI(TAG, "Temperatura: %.1f°C, Humedad: %.1f%%", temp_c, hum_p);
+      // Solo con el nivel de log en debug: a nivel info sería un vprintf
+      // por lectura
+      ESP_LOGD(TAG, "Temperatura: " DECI_FMT "°C, Humedad: " DECI_FMT "%%",
+               DECI_ARGS(sample.temperature), DECI_ARGS(sample.humidity));
 
       // Control del relé basado en la temperatura
-      if (temp_c > TEMP_THRESHOLD) {
+      if (relay_state) {
         gpio_set_level(RELAY_GPIO, 1); // Enciende el relé
-        
-        // Iniciar parpadeo si no está activo
-        if (blink_task_handle == NULL) {
-          xTaskCreate(blink_led_task, "blink_led_task", 2048, NULL, 5, &blink_task_handle);
-        }
+        led_indicator_set(&LED_PATTERN_ALARM);
 
-        ESP_LOGI(TAG, "Temperatura alta (%.1f°C > %.1f°C) - Relé ACTIVADO",
-                 temp_c, TEMP_THRESHOLD);
-                 
-        // Telegram Alert
-        int64_t now = esp_timer_get_time() / 1000;
-        if (now - last_alert_time > ALERT_COOLDOWN_MS) {
-            char alert_msg[128];
-            snprintf(alert_msg, sizeof(alert_msg), "⚠️ ALERTA: Temperatura Alta!\nValor: %.1f°C\nUmbral: %.1f°C", temp_c, TEMP_THRESHOLD);
-            send_telegram_message(alert_msg);
-            last_alert_time = now;
+        if (!last_relay) {
+          ESP_LOGI(TAG,
+                   "Temperatura alta (" DECI_FMT "°C > " DECI_FMT
+                   "°C) - Relé ACTIVADO",
+                   DECI_ARGS(sample.temperature), DECI_ARGS(TEMP_THRESHOLD));
         }
       } else {
         gpio_set_level(RELAY_GPIO, 0); // Apaga el relé
-        
-        // Detener parpadeo si está activo
-        if (blink_task_handle != NULL) {
-          vTaskDelete(blink_task_handle);
-          blink_task_handle = NULL;
-          gpio_set_level(LED_GPIO, 0); // Asegurar que el LED quede apagado
-        }
+        led_indicator_set(&LED_PATTERN_OFF);
       }
-
-      // Mostrar en la pantalla OLED (Alternar cada 3 ciclos)
-      display_counter++;
-      if (display_counter % 3 == 0) {
-          // Mostrar Min/Max
-          snprintf(lineChar, sizeof(lineChar), "Min:%.0f Max:%.0f", min_temp, max_temp);
-          ssd1306_display_text(&oled_dev, 5, lineChar, strlen(lineChar), false);
-          
-          snprintf(lineChar, sizeof(lineChar), "m:%.0f M:%.0f %%", min_hum, max_hum);
-          ssd1306_display_text(&oled_dev, 6, lineChar, strlen(lineChar), false);
-      } else {
-          // Mostrar Actual
-          snprintf(lineChar, sizeof(lineChar), "Temp.: %.1f C", temp_c);
-          ssd1306_display_text(&oled_dev, 5, lineChar, strlen(lineChar), false);
-
-          snprintf(lineChar, sizeof(lineChar), "Hum.: %.1f %%", hum_p);
-          ssd1306_display_text(&oled_dev, 6, lineChar, strlen(lineChar), false);
-      }
-
-      // Publicar datos MQTT (Incluyendo Min/Max)
-      char mqtt_msg[128];
-      snprintf(mqtt_msg, sizeof(mqtt_msg),
-               "{\"temperatura\": %.1f, \"humedad\": %.1f, \"min_temp\": %.1f, \"max_temp\": %.1f}", 
-               temp_c, hum_p, min_temp, max_temp);
-      esp_mqtt_client_publish(mqtt_client, MQTT_TOPIC, mqtt_msg, 0, 1, 0);
-
-      // Mostrar mensaje de publicación exitosa
-      ESP_LOGI(TAG, "Datos publicados en MQTT: %s", mqtt_msg);
-
-      // Mostrar mensaje en pantalla OLED
-      display_centered_text("Datos enviados", 7, true);
-      vTaskDelay(2000 / portTICK_PERIOD_MS);
-
-      // Enviar por WebSocket (Incluyendo Min/Max, estado del relé y límite)
-      char json_msg[200]; // Aumentado el tamaño del buffer
-      int relay_state = (temp_c > TEMP_THRESHOLD) ? 1 : 0;
-      snprintf(json_msg, sizeof(json_msg), 
-               "{\"temp\": %.1f, \"hum\": %.1f, \"min_t\": %.1f, \"max_t\": %.1f, \"relay\": %d, \"limit\": %.1f}",
-               temp_c, hum_p, min_temp, max_temp, relay_state, TEMP_THRESHOLD);
-      send_ws_message(json_msg);
-
+      last_relay = relay_state;
     } else {
       ESP_LOGE(TAG, "Error lectura: %s", esp_err_to_name(result));
-      ssd1306_display_text(&oled_dev, 5, "Error lectura", 13, false);
-      ssd1306_display_text(&oled_dev, 6, "Revisa conexiones", 17, false);
+      led_indicator_set(&LED_PATTERN_SENSOR_ERROR);
     }
 
-    vTaskDelay(5000 / portTICK_PERIOD_MS); // Lectura cada 5 segundos
+    // Codificar una vez y repartir; los destinos lentos descartan, no frenan
+    sensor_snapshot_t snap;
+    payload_t *payload = NULL;
+    sensor_snapshot_read(&snap);
+    if (result == ESP_OK) {
+      rolling_stats_t stats;
+      rolling_stats_get(ROLLING_LONG, &stats);
+      payload = payload_encode(&snap, &stats, TEMP_THRESHOLD);
+      payload_set_latest(payload);
+    }
+    sink_publish(result, &snap, payload);
+    payload_release(payload);
   }
 }
 
@@ -979,6 +1207,10 @@ void app_main(void) {
   }
   ESP_ERROR_CHECK(ret);
 
+#if CONFIG_SAMPLE_BENCH
+  sample_bench_run();
+#endif
+
   // Inicializar SPIFFS
   if (mount_spiffs() != ESP_OK) {
     ESP_LOGE(TAG, "Error montando SPIFFS, deteniendo...");
@@ -993,14 +1225,25 @@ void app_main(void) {
     // hardcodeadas si se desea
   }
 
-  // Conectar a WiFi
+  // Conectar a WiFi y poner en hora el reloj
   wifi_init_sta();
+  start_sntp();
 
   // Iniciar servidor web
   server = start_webserver();
+  if (server) {
+    screen_mirror_register(server, &oled_dev);
+    sensor_service_register(server);
+    sink_register_http(server);
+    history_http_register(server);
+    payload_register_http(server);
+    sys_metrics_register_http(server);
+    metrics_http_register(server);
+  }
 
-  // Iniciar cliente MQTT
+  // Iniciar cliente MQTT y las métricas del sistema que publica
   mqtt_app_start();
+  sys_metrics_start(publish_system_metrics, NULL);
 
   // Iniciar tarea DHT11 - MOVIDO AL FINAL PARA EVITAR DUPLICADOS
   // xTaskCreate(dht11_task, "dht11_task", 4096, NULL, 5, NULL);
@@ -1012,7 +1255,7 @@ void app_main(void) {
   ESP_LOGI(tag, "CONFIG_RESET_GPIO=%d", CONFIG_RESET_GPIO);
   i2c_master_init(&oled_dev, CONFIG_SDA_GPIO, CONFIG_SCL_GPIO,
                   CONFIG_RESET_GPIO);
-  ssd1306_init(&oled_dev, 128, 64);
+  ssd1306_init(&oled_dev, SSD1306_WIDTH, SSD1306_HEIGHT);
 
   // Inicializar relé
   init_relay();
@@ -1041,7 +1284,8 @@ void app_main(void) {
   printf("Sensor DHT11 en GPIO: %d\n", DHT_GPIO);
   printf("------------------------------------\n");
 
-  // Crear tarea principal
+  // Iniciar el servicio de lectura del sensor y la tarea principal
+  sensor_service_start(DHT_TYPE_DHT11, (gpio_num_t)DHT_GPIO, SENSOR_PERIOD_MS);
   xTaskCreate(dht11_task, "dht11_task", 4096, NULL, 5, NULL);
 
   ESP_LOGI(TAG, "Sistema iniciado - Esperando lecturas...");
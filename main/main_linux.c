@@ -0,0 +1,104 @@
+/* Archivo: main_linux.c
+ * Descripción: Punto de entrada para el target linux de ESP-IDF. Arranca el
+ *              servicio de sensor con la fuente de reproducción y consume
+ *              sus resultados como lo hace la tarea de pantalla, midiendo
+ *              cada segundo las muestras publicadas, las recibidas, las que
+ *              el consumidor no llegó a ver y la latencia entre publicación
+ *              y recepción. Al terminar una traza sin bucle imprime el
+ *              resumen y sale.
+ *
+ *              Uso:
+ *                idf.py --preview set-target linux
+ *                idf.py build
+ *                ./build/DHT11_Oled_Info.elf   (lee trace.csv del directorio
+ *                                               actual, ver menuconfig)
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sensor_service.h"
+
+// Sin resultados nuevos durante este tiempo se da la traza por terminada
+#define BENCH_IDLE_MS 2000
+#define BENCH_REPORT_US 1000000
+
+typedef struct {
+  uint32_t received;   // Resultados vistos por el consumidor
+  uint32_t skipped;    // Resultados publicados que el consumidor no vio
+  uint32_t errors;     // Resultados con error
+  uint64_t latency_us; // Suma de latencias de las lecturas válidas
+  uint32_t latency_n;
+  uint32_t latency_max_us;
+} bench_stats_t;
+
+static void bench_print(const char *label, const bench_stats_t *s,
+                        uint64_t elapsed_us) {
+  uint32_t published = s->received + s->skipped;
+  printf("%s: %" PRIu32 " publicadas (%.0f/s), %" PRIu32 " recibidas, %" PRIu32
+         " sin ver, %" PRIu32 " errores, latencia media %" PRIu64
+         " us, máx %" PRIu32 " us\n",
+         label, published,
+         elapsed_us ? published * 1e6 / elapsed_us : 0.0, s->received,
+         s->skipped, s->errors,
+         s->latency_n ? s->latency_us / s->latency_n : 0, s->latency_max_us);
+}
+
+static void bench_task(void *pvParameters) {
+  bench_stats_t total = {0};
+  bench_stats_t window = {0};
+  uint32_t last_seq = 0;
+  int64_t start = esp_timer_get_time();
+  int64_t window_start = start;
+
+  while (1) {
+    sensor_sample_t sample;
+    if (sensor_service_wait(&sample, last_seq,
+                            pdMS_TO_TICKS(BENCH_IDLE_MS)) != ESP_OK) {
+      break;
+    }
+    int64_t now = esp_timer_get_time();
+
+    bench_stats_t *stats[] = {&total, &window};
+    for (int i = 0; i < 2; i++) {
+      stats[i]->received++;
+      stats[i]->skipped += sample.seq - last_seq - 1;
+      if (sample.status != ESP_OK) {
+        stats[i]->errors++;
+      } else {
+        uint32_t latency = now - sample.timestamp;
+        stats[i]->latency_us += latency;
+        stats[i]->latency_n++;
+        if (latency > stats[i]->latency_max_us) {
+          stats[i]->latency_max_us = latency;
+        }
+      }
+    }
+    last_seq = sample.seq;
+
+    if (now - window_start >= BENCH_REPORT_US) {
+      bench_print("1 s", &window, now - window_start);
+      window = (bench_stats_t){0};
+      window_start = now;
+    }
+  }
+
+  bench_print("Total", &total, esp_timer_get_time() - start - BENCH_IDLE_MS * 1000);
+  exit(0);
+}
+
+void app_main(void) {
+  if (sensor_service_start(DHT_TYPE_DHT11, 0, 0) != ESP_OK) {
+    exit(1);
+  }
+  xTaskCreate(bench_task, "bench_task", 4096, NULL, 5, NULL);
+}
@@ -0,0 +1,358 @@
+/* Archivo: metrics_http.c
+ * Descripción: Métricas en el formato de texto de Prometheus. Ver
+ *              metrics_http.h.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "metrics_http.h"
+
+#include <stddef.h>
+
+#include "dht_diag.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "fmt.h"
+#include "rolling_stats.h"
+#include "sensor_service.h"
+#include "sensor_snapshot.h"
+#include "sink.h"
+#include "sys_metrics.h"
+#include "ws_clients.h"
+
+#define METRICS_HTTP_BUF 512
+#define LINE_MAX 128 // Más que la línea más larga, el HELP de una familia
+
+static const char *TAG = "METRICS";
+
+// Respuesta en construcción: se envía un trozo cuando no cabe otra línea
+typedef struct {
+  httpd_req_t *req;
+  fmt_t out;
+  esp_err_t err;
+} prom_t;
+
+static void flush(prom_t *p) {
+  if (p->err == ESP_OK && p->out.len > 0) {
+    p->err = httpd_resp_send_chunk(p->req, p->out.buf, p->out.len);
+  }
+  fmt_init(&p->out, p->out.buf, p->out.size);
+}
+
+static void reserve(prom_t *p) {
+  if (p->out.size - 1 - p->out.len < LINE_MAX) {
+    flush(p);
+  }
+}
+
+static void family(prom_t *p, const char *name, const char *type,
+                   const char *help) {
+  reserve(p);
+  fmt_str(&p->out, "# HELP ");
+  fmt_str(&p->out, name);
+  fmt_str(&p->out, " ");
+  fmt_str(&p->out, help);
+  fmt_str(&p->out, "\n");
+  reserve(p);
+  fmt_str(&p->out, "# TYPE ");
+  fmt_str(&p->out, name);
+  fmt_str(&p->out, " ");
+  fmt_str(&p->out, type);
+  fmt_str(&p->out, "\n");
+}
+
+// Empieza una muestra; labels sin llaves, NULL si no lleva
+static void begin(prom_t *p, const char *name, const char *labels) {
+  reserve(p);
+  fmt_str(&p->out, name);
+  if (labels != NULL) {
+    fmt_str(&p->out, "{");
+    fmt_str(&p->out, labels);
+    fmt_str(&p->out, "}");
+  }
+  fmt_str(&p->out, " ");
+}
+
+static void value_uint(prom_t *p, const char *name, const char *labels,
+                       uint32_t value) {
+  begin(p, name, labels);
+  fmt_uint(&p->out, value);
+  fmt_str(&p->out, "\n");
+}
+
+static void value_deci(prom_t *p, const char *name, const char *labels,
+                       int32_t deci) {
+  begin(p, name, labels);
+  fmt_deci(&p->out, deci);
+  fmt_str(&p->out, "\n");
+}
+
+// value / scale con tantos decimales como ceros tiene scale (10^n)
+static void value_frac(prom_t *p, const char *name, const char *labels,
+                       uint64_t value, uint32_t scale) {
+  uint32_t rest = value % scale;
+
+  begin(p, name, labels);
+  fmt_uint(&p->out, value / scale);
+  if (scale > 1) {
+    char digits[10];
+    int n = 0;
+    digits[n++] = '.';
+    for (uint32_t s = scale / 10; s > 0; s /= 10) {
+      digits[n++] = '0' + rest / s % 10;
+    }
+    fmt_strn(&p->out, digits, n);
+  }
+  fmt_str(&p->out, "\n");
+}
+
+// Una etiqueta key="value" en buf
+static const char *label(char *buf, size_t size, const char *key,
+                         const char *value) {
+  fmt_t l;
+
+  fmt_init(&l, buf, size);
+  fmt_str(&l, key);
+  fmt_str(&l, "=\"");
+  fmt_str(&l, value);
+  fmt_str(&l, "\"");
+  return buf;
+}
+
+static void write_reading(prom_t *p) {
+  sensor_snapshot_t snap;
+  sensor_sample_t sample;
+
+  sensor_snapshot_read(&snap);
+  if (snap.timestamp != 0) {
+    family(p, "dht11_temperature_celsius", "gauge",
+           "Última temperatura válida.");
+    value_deci(p, "dht11_temperature_celsius", NULL, snap.temperature);
+    family(p, "dht11_humidity_percent", "gauge",
+           "Última humedad relativa válida.");
+    value_deci(p, "dht11_humidity_percent", NULL, snap.humidity);
+    family(p, "dht11_reading_age_seconds", "gauge",
+           "Antigüedad de la última lectura válida.");
+    value_frac(p, "dht11_reading_age_seconds", NULL,
+               esp_timer_get_time() - snap.timestamp, 1000000);
+  }
+  family(p, "dht11_relay_on", "gauge",
+         "Estado del relé, 1 si está activado.");
+  value_uint(p, "dht11_relay_on", NULL, snap.relay);
+
+  if (sensor_service_get(&sample) == ESP_OK) {
+    family(p, "dht11_sensor_consecutive_failures", "gauge",
+           "Lecturas fallidas desde la última válida.");
+    value_uint(p, "dht11_sensor_consecutive_failures", NULL, sample.failures);
+  }
+}
+
+static void write_rolling(prom_t *p) {
+  static const char *const names[] = {
+      "dht11_temperature_min_celsius",
+      "dht11_temperature_max_celsius",
+      "dht11_humidity_min_percent",
+      "dht11_humidity_max_percent",
+  };
+  static const char *const helps[] = {
+      "Temperatura mínima de la ventana móvil.",
+      "Temperatura máxima de la ventana móvil.",
+      "Humedad mínima de la ventana móvil.",
+      "Humedad máxima de la ventana móvil.",
+  };
+  rolling_stats_t stats[ROLLING_WINDOWS];
+  char labels[ROLLING_WINDOWS][24];
+
+  for (int w = 0; w < ROLLING_WINDOWS; w++) {
+    char seconds[12];
+    fmt_t s;
+    rolling_stats_get(w, &stats[w]);
+    fmt_init(&s, seconds, sizeof(seconds));
+    fmt_uint(&s, stats[w].window_s);
+    label(labels[w], sizeof(labels[w]), "window_seconds", seconds);
+  }
+  for (int i = 0; i < 4; i++) {
+    family(p, names[i], "gauge", helps[i]);
+    for (int w = 0; w < ROLLING_WINDOWS; w++) {
+      if (stats[w].count == 0) {
+        continue;
+      }
+      const rolling_value_t *v =
+          i < 2 ? &stats[w].temperature : &stats[w].humidity;
+      value_deci(p, names[i], labels[w], i % 2 ? v->max : v->min);
+    }
+  }
+}
+
+static void write_sensor(prom_t *p) {
+  dht_diag_t diag;
+  sensor_timing_t timing;
+
+  family(p, "dht11_sensor_reads_total", "counter",
+         "Lecturas del sensor por resultado; salvo ok, son fallos.");
+  for (int i = 0; dht_diag_get_index(i, &diag) == ESP_OK; i++) {
+    char labels[48];
+    fmt_t l;
+    for (int e = 0; e < DHT_DIAG_MAX; e++) {
+      fmt_init(&l, labels, sizeof(labels));
+      fmt_str(&l, "pin=\"");
+      fmt_uint(&l, diag.pin);
+      fmt_str(&l, "\",outcome=\"");
+      fmt_str(&l, dht_diag_event_name(e));
+      fmt_str(&l, "\"");
+      value_uint(p, "dht11_sensor_reads_total", labels, diag.count[e]);
+    }
+  }
+
+  if (sensor_service_get_timing(&timing) != ESP_OK) {
+    return;
+  }
+  family(p, "dht11_sensor_ticks_total", "counter",
+         "Instantes de muestreo vencidos desde el arranque.");
+  value_uint(p, "dht11_sensor_ticks_total", NULL, timing.ticks);
+  family(p, "dht11_sensor_overruns_total", "counter",
+         "Instantes sin lectura porque la tarea no llegó a tiempo.");
+  value_uint(p, "dht11_sensor_overruns_total", NULL, timing.overruns);
+  family(p, "dht11_sensor_retries_total", "counter",
+         "Reintentos entre dos instantes tras un error.");
+  value_uint(p, "dht11_sensor_retries_total", NULL, timing.retries);
+  family(p, "dht11_sensor_skipped_total", "counter",
+         "Instantes sin lectura porque el sensor aún no podía leerse.");
+  value_uint(p, "dht11_sensor_skipped_total", NULL, timing.skipped);
+  family(p, "dht11_sensor_jitter_max_seconds", "gauge",
+         "Mayor retraso al despertar tras un instante de muestreo.");
+  value_frac(p, "dht11_sensor_jitter_max_seconds", NULL, timing.max_jitter_us,
+             1000000);
+}
+
+static void write_sinks(prom_t *p) {
+  static const struct {
+    const char *name;
+    const char *help;
+    size_t offset;
+  } counters[] = {
+      {"dht11_sink_enqueued_total", "Eventos aceptados en la cola.",
+       offsetof(sink_stats_t, enqueued)},
+      {"dht11_sink_dropped_total", "Eventos descartados por cola llena.",
+       offsetof(sink_stats_t, dropped)},
+      {"dht11_sink_delivered_total", "Entregas (publicaciones) con éxito.",
+       offsetof(sink_stats_t, delivered)},
+      {"dht11_sink_failed_total", "Entregas con error.",
+       offsetof(sink_stats_t, failed)},
+  };
+  sink_stats_t stats[SINK_MAX];
+  char labels[SINK_MAX][24];
+  int count = 0;
+  const char *name;
+
+  while (count < SINK_MAX &&
+         sink_get_stats(count, &name, &stats[count]) == ESP_OK) {
+    label(labels[count], sizeof(labels[count]), "sink", name);
+    count++;
+  }
+
+  for (size_t c = 0; c < sizeof(counters) / sizeof(counters[0]); c++) {
+    family(p, counters[c].name, "counter", counters[c].help);
+    for (int i = 0; i < count; i++) {
+      const uint32_t *value =
+          (const uint32_t *)((const char *)&stats[i] + counters[c].offset);
+      value_uint(p, counters[c].name, labels[i], *value);
+    }
+  }
+  family(p, "dht11_sink_queue_depth", "gauge", "Eventos en cola.");
+  for (int i = 0; i < count; i++) {
+    value_uint(p, "dht11_sink_queue_depth", labels[i], stats[i].depth);
+  }
+  family(p, "dht11_sink_latency_seconds", "summary",
+         "Desde que se encola hasta que termina la entrega.");
+  for (int i = 0; i < count; i++) {
+    value_frac(p, "dht11_sink_latency_seconds_sum", labels[i],
+               stats[i].total_latency_us, 1000000);
+    value_uint(p, "dht11_sink_latency_seconds_count", labels[i],
+               stats[i].delivered + stats[i].failed);
+  }
+  family(p, "dht11_sink_latency_max_seconds", "gauge",
+         "Mayor latencia de entrega desde el arranque.");
+  for (int i = 0; i < count; i++) {
+    value_frac(p, "dht11_sink_latency_max_seconds", labels[i],
+               stats[i].max_latency_us, 1000000);
+  }
+}
+
+static void write_system(prom_t *p) {
+  // Unos 500 bytes: fuera de la pila; el servidor atiende de una en una
+  static sys_metrics_t m;
+
+  family(p, "dht11_ws_clients", "gauge", "Clientes del WebSocket conectados.");
+  value_uint(p, "dht11_ws_clients", NULL, ws_clients_count());
+  family(p, "dht11_uptime_seconds", "gauge", "Tiempo desde el arranque.");
+  value_uint(p, "dht11_uptime_seconds", NULL, esp_timer_get_time() / 1000000);
+
+  family(p, "dht11_heap_free_bytes", "gauge", "Heap libre.");
+  value_uint(p, "dht11_heap_free_bytes", NULL,
+             heap_caps_get_free_size(MALLOC_CAP_8BIT));
+  family(p, "dht11_heap_min_free_bytes", "gauge",
+         "Mínimo de heap libre desde el arranque.");
+  value_uint(p, "dht11_heap_min_free_bytes", NULL,
+             heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+  family(p, "dht11_heap_largest_free_block_bytes", "gauge",
+         "Mayor bloque libre; muy por debajo del libre indica fragmentación.");
+  value_uint(p, "dht11_heap_largest_free_block_bytes", NULL,
+             heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+
+  if (sys_metrics_get(&m) != ESP_OK) {
+    return;
+  }
+  family(p, "dht11_task_stack_free_bytes", "gauge",
+         "Mínimo de pila libre de la tarea desde que arrancó.");
+  for (int i = 0; i < m.task_count; i++) {
+    char labels[32];
+    value_uint(p, "dht11_task_stack_free_bytes",
+               label(labels, sizeof(labels), "task", m.tasks[i].name),
+               m.tasks[i].stack_free);
+  }
+  family(p, "dht11_task_cpu_ratio", "gauge",
+         "Fracción de CPU de la tarea en el último periodo de métricas.");
+  for (int i = 0; i < m.task_count; i++) {
+    char labels[32];
+    value_frac(p, "dht11_task_cpu_ratio",
+               label(labels, sizeof(labels), "task", m.tasks[i].name),
+               m.tasks[i].cpu_permille, 1000);
+  }
+}
+
+static esp_err_t metrics_handler(httpd_req_t *req) {
+  char buf[METRICS_HTTP_BUF];
+  prom_t p = {.req = req, .err = ESP_OK};
+
+  httpd_resp_set_type(req, "text/plain; version=0.0.4; charset=utf-8");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+  fmt_init(&p.out, buf, sizeof(buf));
+  write_reading(&p);
+  write_rolling(&p);
+  write_sensor(&p);
+  write_sinks(&p);
+  write_system(&p);
+  flush(&p);
+  if (p.err != ESP_OK) {
+    return ESP_FAIL;
+  }
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+esp_err_t metrics_http_register(httpd_handle_t server) {
+  httpd_uri_t uri = {.uri = "/metrics",
+                     .method = HTTP_GET,
+                     .handler = metrics_handler,
+                     .user_ctx = NULL};
+  esp_err_t ret = httpd_register_uri_handler(server, &uri);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo registrar /metrics: %s", esp_err_to_name(ret));
+  }
+  return ret;
+}
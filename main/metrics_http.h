@@ -0,0 +1,38 @@
+/* Archivo: metrics_http.h
+ * Descripción: Métricas para Prometheus en formato de texto:
+ *
+ *                GET /metrics
+ *
+ *              Lectura actual, mínimo y máximo de cada ventana móvil,
+ *              estado del relé, contadores de lecturas del DHT por
+ *              resultado, temporización del muestreo, envíos y latencias
+ *              de cada destino (MQTT incluido), clientes del WebSocket,
+ *              heap y, de la última muestra de sys_metrics, pila libre y
+ *              CPU de cada tarea. Todas llevan el prefijo dht11_ y van en
+ *              unidades base: °C, %, bytes, segundos y proporciones.
+ *
+ *              La respuesta se escribe por trozos en un buffer de pila con
+ *              fmt.h, sin memoria dinámica ni printf: cada consulta lee
+ *              contadores que ya existen y cuesta unos pocos KB de texto.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_METRICS_HTTP_H_
+#define MAIN_METRICS_HTTP_H_
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/**
+ * @brief Registra GET /metrics
+ *
+ * @param server Servidor HTTP ya iniciado
+ * @return esp_err_t Resultado del registro del handler
+ */
+esp_err_t metrics_http_register(httpd_handle_t server);
+
+#endif /* MAIN_METRICS_HTTP_H_ */
@@ -0,0 +1,237 @@
+/* Archivo: payload.c
+ * Descripción: Codificación única y reparto por referencias de cada
+ *              lectura. Ver payload.h.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "payload.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "cbor_writer.h"
+#include "freertos/FreeRTOS.h"
+#include "json_writer.h"
+
+// Holgados para los documentos con los valores más largos
+#define JSON_MAX 160
+#define CBOR_MAX 32
+#define JSON_MQTT_MAX 128
+
+struct payload {
+  uint32_t refs;
+  int16_t values[PAYLOAD_FIELDS]; // Para las suscripciones a menos campos
+  uint16_t offset[PAYLOAD_FORMATS];
+  uint16_t len[PAYLOAD_FORMATS];
+  char data[]; // Los formatos uno tras otro
+};
+
+static const char *const s_field_names[PAYLOAD_FIELDS] = {
+    "temp", "hum", "min_t", "max_t", "relay", "limit"};
+
+static const char *TAG = "PAYLOAD";
+
+static payload_t *s_latest = NULL;
+// Protege las cuentas de referencias y s_latest
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static size_t encode_json(char *buf, size_t size, const int16_t *values,
+                          uint32_t fields) {
+  json_writer_t j;
+
+  json_init(&j, buf, size);
+  json_object_begin(&j);
+  for (int i = 0; i < PAYLOAD_FIELDS; i++) {
+    if (!(fields & PAYLOAD_FIELD(i))) {
+      continue;
+    }
+    json_key(&j, s_field_names[i]);
+    if (i == PAYLOAD_RELAY) {
+      json_uint(&j, values[i]);
+    } else {
+      json_deci(&j, values[i]);
+    }
+  }
+  json_object_end(&j);
+  return j.out.overflow ? 0 : j.out.len;
+}
+
+static size_t encode_json_mqtt(char *buf, size_t size,
+                               const int16_t *values) {
+  json_writer_t j;
+
+  json_init(&j, buf, size);
+  json_object_begin(&j);
+  json_key(&j, "temperatura");
+  json_deci(&j, values[PAYLOAD_TEMP]);
+  json_key(&j, "humedad");
+  json_deci(&j, values[PAYLOAD_HUM]);
+  json_key(&j, "min_temp");
+  json_deci(&j, values[PAYLOAD_MIN_T]);
+  json_key(&j, "max_temp");
+  json_deci(&j, values[PAYLOAD_MAX_T]);
+  json_object_end(&j);
+  return j.out.overflow ? 0 : j.out.len;
+}
+
+static size_t encode_cbor(uint8_t *buf, size_t size, const int16_t *values,
+                          uint32_t fields) {
+  cbor_writer_t c;
+  int count = 0;
+
+  for (int i = 0; i < PAYLOAD_FIELDS; i++) {
+    count += (fields & PAYLOAD_FIELD(i)) != 0;
+  }
+  cbor_init(&c, buf, size);
+  cbor_map(&c, count);
+  for (int i = 0; i < PAYLOAD_FIELDS; i++) {
+    if (fields & PAYLOAD_FIELD(i)) {
+      cbor_uint(&c, i);
+      cbor_int(&c, values[i]);
+    }
+  }
+  return c.overflow ? 0 : c.len;
+}
+
+payload_t *payload_encode(const sensor_snapshot_t *snap,
+                          const rolling_stats_t *stats, int16_t limit) {
+  const int16_t values[PAYLOAD_FIELDS] = {
+      [PAYLOAD_TEMP] = snap->temperature,
+      [PAYLOAD_HUM] = snap->humidity,
+      [PAYLOAD_MIN_T] = stats->temperature.min,
+      [PAYLOAD_MAX_T] = stats->temperature.max,
+      [PAYLOAD_RELAY] = snap->relay,
+      [PAYLOAD_LIMIT] = limit,
+  };
+  char json[JSON_MAX];
+  uint8_t cbor[CBOR_MAX];
+  char json_mqtt[JSON_MQTT_MAX];
+  const char *doc[PAYLOAD_FORMATS] = {
+      [PAYLOAD_JSON] = json,
+      [PAYLOAD_CBOR] = (const char *)cbor,
+      [PAYLOAD_JSON_MQTT] = json_mqtt,
+  };
+  size_t len[PAYLOAD_FORMATS] = {
+      [PAYLOAD_JSON] =
+          encode_json(json, sizeof(json), values, PAYLOAD_ALL_FIELDS),
+      [PAYLOAD_CBOR] =
+          encode_cbor(cbor, sizeof(cbor), values, PAYLOAD_ALL_FIELDS),
+      [PAYLOAD_JSON_MQTT] =
+          encode_json_mqtt(json_mqtt, sizeof(json_mqtt), values),
+  };
+  size_t total = 0;
+  for (int f = 0; f < PAYLOAD_FORMATS; f++) {
+    total += len[f] + 1;
+  }
+
+  // Una sola reserva para la cabecera y todos los formatos
+  payload_t *p = malloc(sizeof(payload_t) + total);
+  if (p == NULL) {
+    ESP_LOGW(TAG, "Sin memoria para la lectura codificada");
+    return NULL;
+  }
+  p->refs = 1;
+  memcpy(p->values, values, sizeof(values));
+  size_t offset = 0;
+  for (int f = 0; f < PAYLOAD_FORMATS; f++) {
+    p->offset[f] = offset;
+    p->len[f] = len[f];
+    memcpy(p->data + offset, doc[f], len[f]);
+    p->data[offset + len[f]] = '\0';
+    offset += len[f] + 1;
+  }
+  ESP_LOGD(TAG, "Lectura codificada: JSON %u, CBOR %u, MQTT %u bytes",
+           (unsigned)len[PAYLOAD_JSON], (unsigned)len[PAYLOAD_CBOR],
+           (unsigned)len[PAYLOAD_JSON_MQTT]);
+  return p;
+}
+
+payload_t *payload_ref(payload_t *p) {
+  if (p != NULL) {
+    taskENTER_CRITICAL(&s_lock);
+    p->refs++;
+    taskEXIT_CRITICAL(&s_lock);
+  }
+  return p;
+}
+
+void payload_release(payload_t *p) {
+  if (p == NULL) {
+    return;
+  }
+  taskENTER_CRITICAL(&s_lock);
+  uint32_t refs = --p->refs;
+  taskEXIT_CRITICAL(&s_lock);
+  if (refs == 0) {
+    free(p);
+  }
+}
+
+const char *payload_data(const payload_t *p, payload_format_t format,
+                         size_t *len) {
+  *len = p->len[format];
+  return p->data + p->offset[format];
+}
+
+size_t payload_encode_fields(const payload_t *p, payload_format_t format,
+                             uint32_t fields, char *buf, size_t size) {
+  if (format == PAYLOAD_CBOR) {
+    return encode_cbor((uint8_t *)buf, size, p->values, fields);
+  }
+  return encode_json(buf, size, p->values, fields);
+}
+
+const char *payload_field_name(payload_field_t field) {
+  return s_field_names[field];
+}
+
+void payload_set_latest(payload_t *p) {
+  payload_ref(p);
+  taskENTER_CRITICAL(&s_lock);
+  payload_t *old = s_latest;
+  s_latest = p;
+  taskEXIT_CRITICAL(&s_lock);
+  payload_release(old);
+}
+
+/**
+ * @brief Devuelve el documento JSON de la última lectura tal cual
+ */
+static esp_err_t latest_handler(httpd_req_t *req) {
+  taskENTER_CRITICAL(&s_lock);
+  payload_t *p = s_latest;
+  if (p != NULL) {
+    p->refs++;
+  }
+  taskEXIT_CRITICAL(&s_lock);
+
+  if (p == NULL) {
+    return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND,
+                               "Todavía no hay lecturas");
+  }
+  size_t len;
+  const char *json = payload_data(p, PAYLOAD_JSON, &len);
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  esp_err_t ret = httpd_resp_send(req, json, len);
+  payload_release(p);
+  return ret;
+}
+
+esp_err_t payload_register_http(httpd_handle_t server) {
+  httpd_uri_t uri = {.uri = "/api/latest",
+                     .method = HTTP_GET,
+                     .handler = latest_handler,
+                     .user_ctx = NULL};
+  esp_err_t ret = httpd_register_uri_handler(server, &uri);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo registrar /api/latest: %s",
+             esp_err_to_name(ret));
+  }
+  return ret;
+}
@@ -0,0 +1,148 @@
+/* Archivo: payload.h
+ * Descripción: Cada lectura se codifica una sola vez. El productor genera
+ *              el documento de la lectura en un buffer inmutable con
+ *              cuenta de referencias y los destinos (MQTT, WebSocket) y la
+ *              API HTTP envían esos mismos bytes: ni vuelven a darle
+ *              formato ni lo copian. El buffer se libera cuando lo suelta
+ *              el último que lo usa.
+ *
+ *              Documento JSON de cada lectura (décimas con un decimal):
+ *
+ *                {"temp": 23.4, "hum": 56.1, "min_t": 18.0, "max_t": 31.2,
+ *                 "relay": 0, "limit": 30.0}
+ *
+ *              min_t y max_t son los de la ventana larga de
+ *              rolling_stats.h.
+ *
+ *              Documento CBOR (RFC 8949) con los mismos campos: un mapa con
+ *              claves enteras y valores enteros, temperaturas y humedades
+ *              en décimas (unos 20 bytes frente a unos 90 del JSON):
+ *
+ *                {0: temp, 1: hum, 2: min_t, 3: max_t, 4: relay, 5: limit}
+ *
+ *              Los clientes suscritos a una parte de los campos reciben los
+ *              mismos documentos sin las claves que no pidieron
+ *              (payload_encode_fields()).
+ *
+ *              Documento JSON de MQTT, el de siempre para no romper a los
+ *              suscriptores existentes:
+ *
+ *                {"temperatura": 23.4, "humedad": 56.1, "min_temp": 18.0,
+ *                 "max_temp": 31.2}
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_PAYLOAD_H_
+#define MAIN_PAYLOAD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "rolling_stats.h"
+#include "sensor_snapshot.h"
+
+/**
+ * @brief Formatos en los que se codifica cada lectura
+ */
+typedef enum {
+  PAYLOAD_JSON = 0,
+  PAYLOAD_CBOR,
+  PAYLOAD_JSON_MQTT, // Claves anteriores, solo para MQTT
+  PAYLOAD_FORMATS
+} payload_format_t;
+
+/**
+ * @brief Campos de la lectura; su valor es también su clave CBOR
+ */
+typedef enum {
+  PAYLOAD_TEMP = 0,
+  PAYLOAD_HUM,
+  PAYLOAD_MIN_T,
+  PAYLOAD_MAX_T,
+  PAYLOAD_RELAY,
+  PAYLOAD_LIMIT,
+  PAYLOAD_FIELDS
+} payload_field_t;
+
+// Máscaras de campos
+#define PAYLOAD_FIELD(field) (1u << (field))
+#define PAYLOAD_ALL_FIELDS (PAYLOAD_FIELD(PAYLOAD_FIELDS) - 1)
+
+/**
+ * @brief Lectura codificada; no se modifica tras payload_encode()
+ */
+typedef struct payload payload_t;
+
+/**
+ * @brief Codifica una lectura en todos los formatos
+ *
+ * @param snap Estado publicado tras la lectura
+ * @param stats Estadísticas de la ventana larga
+ * @param limit Umbral del relé en décimas de °C
+ * @return payload_t* Con una referencia para el llamante, NULL sin memoria
+ */
+payload_t *payload_encode(const sensor_snapshot_t *snap,
+                          const rolling_stats_t *stats, int16_t limit);
+
+/**
+ * @brief Toma otra referencia
+ *
+ * @return payload_t* El mismo p (NULL si p es NULL)
+ */
+payload_t *payload_ref(payload_t *p);
+
+/**
+ * @brief Suelta una referencia; la última libera el buffer. Admite NULL.
+ */
+void payload_release(payload_t *p);
+
+/**
+ * @brief Bytes de un formato
+ *
+ * Todos terminan además en '\0', que no cuenta en len.
+ *
+ * @param[out] len Longitud en bytes
+ */
+const char *payload_data(const payload_t *p, payload_format_t format,
+                         size_t *len);
+
+/**
+ * @brief Codifica solo algunos campos de la lectura en buf
+ *
+ * Para los clientes que no quieren el documento completo; el completo está
+ * ya codificado en payload_data(). El JSON no termina en '\0'.
+ *
+ * @param format PAYLOAD_JSON o PAYLOAD_CBOR
+ * @param fields Máscara de PAYLOAD_FIELD()
+ * @return size_t Longitud, 0 si no cabe en size
+ */
+size_t payload_encode_fields(const payload_t *p, payload_format_t format,
+                             uint32_t fields, char *buf, size_t size);
+
+/**
+ * @brief Nombre de un campo en el JSON ("temp", "hum"...)
+ */
+const char *payload_field_name(payload_field_t field);
+
+/**
+ * @brief Publica p como la última lectura que sirve la API HTTP
+ *
+ * Toma su propia referencia y suelta la de la lectura anterior.
+ */
+void payload_set_latest(payload_t *p);
+
+/**
+ * @brief Registra GET /api/latest (el documento JSON de la última lectura)
+ *
+ * @param server Servidor HTTP ya iniciado
+ * @return esp_err_t Resultado del registro del handler
+ */
+esp_err_t payload_register_http(httpd_handle_t server);
+
+#endif /* MAIN_PAYLOAD_H_ */
@@ -0,0 +1,278 @@
+/* Archivo: rolling_stats.c
+ * Descripción: Ventanas deslizantes de estadísticas. Cada ventana tiene una
+ *              ranura abierta que acumula las lecturas y un anillo con las
+ *              sumas de las ranuras cerradas que siguen dentro; las colas
+ *              monótonas guardan solo las ranuras que aún pueden ser el
+ *              mínimo o el máximo. Todo en aritmética entera: las sumas de
+ *              décimas y de sus cuadrados son exactas, así la varianza no
+ *              sufre la cancelación que obliga a usar Welford con floats.
+ *              Ver rolling_stats.h.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "rolling_stats.h"
+
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+
+#define SLOTS CONFIG_ROLLING_SLOTS
+
+// Entrada de una cola monótona: extremo de una ranura cerrada
+typedef struct {
+  uint32_t slot;
+  int16_t value;
+} mono_entry_t;
+
+// Cola doble sobre un anillo; cabe una entrada por ranura cerrada
+typedef struct {
+  mono_entry_t buf[SLOTS];
+  uint16_t head;
+  uint16_t len;
+} mono_deque_t;
+
+// Sumas de una ranura o de toda la ventana
+typedef struct {
+  uint32_t count;
+  int32_t temp_sum;
+  int32_t hum_sum;
+  int64_t temp_sq;
+  int64_t hum_sq;
+} sums_t;
+
+typedef struct {
+  uint32_t slot;
+  sums_t sums;
+} closed_slot_t;
+
+typedef struct {
+  uint32_t slot_s;
+  // Ranura abierta
+  uint32_t slot;
+  sums_t open;
+  int16_t temp_min;
+  int16_t temp_max;
+  int16_t hum_min;
+  int16_t hum_max;
+  // Ranuras cerradas dentro de la ventana, de la más antigua a la última
+  closed_slot_t ring[SLOTS];
+  uint16_t ring_head;
+  uint16_t ring_len;
+  sums_t closed;
+  mono_deque_t temp_mins;
+  mono_deque_t temp_maxs;
+  mono_deque_t hum_mins;
+  mono_deque_t hum_maxs;
+  // EWMA en décimas * 2^24: con la ventana de 24 h y lecturas cada 5 s el
+  // paso es ~1/17000 de la diferencia, que en décimas * 256 se truncaba a 0
+  int64_t temp_ewma;
+  int64_t hum_ewma;
+  int64_t ewma_time; // µs de la última lectura, 0 si no hay
+} window_t;
+
+static window_t s_windows[ROLLING_WINDOWS];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static inline mono_entry_t *deque_at(mono_deque_t *d, uint16_t i) {
+  return &d->buf[(d->head + i) % SLOTS];
+}
+
+// Añade por detrás quitando las entradas que ya no pueden ser el extremo
+static void deque_push(mono_deque_t *d, uint32_t slot, int16_t value,
+                       bool is_max) {
+  while (d->len > 0) {
+    int16_t back = deque_at(d, d->len - 1)->value;
+    if (is_max ? back > value : back < value) {
+      break;
+    }
+    d->len--;
+  }
+  *deque_at(d, d->len) = (mono_entry_t){slot, value};
+  d->len++;
+}
+
+static void deque_expire(mono_deque_t *d, uint32_t first_slot) {
+  while (d->len > 0 && deque_at(d, 0)->slot < first_slot) {
+    d->head = (d->head + 1) % SLOTS;
+    d->len--;
+  }
+}
+
+static void sums_add(sums_t *acc, const sums_t *s, int sign) {
+  acc->count += sign * (int32_t)s->count;
+  acc->temp_sum += sign * s->temp_sum;
+  acc->hum_sum += sign * s->hum_sum;
+  acc->temp_sq += sign * s->temp_sq;
+  acc->hum_sq += sign * s->hum_sq;
+}
+
+static void window_close(window_t *w) {
+  closed_slot_t *c = &w->ring[(w->ring_head + w->ring_len) % SLOTS];
+
+  c->slot = w->slot;
+  c->sums = w->open;
+  w->ring_len++;
+  sums_add(&w->closed, &w->open, 1);
+  deque_push(&w->temp_mins, w->slot, w->temp_min, false);
+  deque_push(&w->temp_maxs, w->slot, w->temp_max, true);
+  deque_push(&w->hum_mins, w->slot, w->hum_min, false);
+  deque_push(&w->hum_maxs, w->slot, w->hum_max, true);
+  w->open = (sums_t){0};
+}
+
+// Quita las ranuras cerradas que salen de la ventana con slot abierta
+static void window_expire(window_t *w, uint32_t slot) {
+  uint32_t first = slot >= SLOTS - 1 ? slot - (SLOTS - 1) : 0;
+
+  while (w->ring_len > 0 && w->ring[w->ring_head].slot < first) {
+    sums_add(&w->closed, &w->ring[w->ring_head].sums, -1);
+    w->ring_head = (w->ring_head + 1) % SLOTS;
+    w->ring_len--;
+  }
+  deque_expire(&w->temp_mins, first);
+  deque_expire(&w->temp_maxs, first);
+  deque_expire(&w->hum_mins, first);
+  deque_expire(&w->hum_maxs, first);
+}
+
+#define EWMA_SHIFT 24
+#define EWMA_ONE ((int64_t)1 << EWMA_SHIFT)
+
+// Las décimas del sensor caben de sobra en 12 bits: |x - ewma| < 2^36 y,
+// con alpha <= 2^24, el producto cabe en 64 bits
+static inline int64_t ewma_step(int64_t ewma, int16_t value,
+                                uint32_t alpha_q24) {
+  int64_t diff = value * EWMA_ONE - ewma;
+  return ewma + ((diff * alpha_q24 + EWMA_ONE / 2) >> EWMA_SHIFT);
+}
+
+static void window_add(window_t *w, int64_t timestamp, int16_t temperature,
+                       int16_t humidity) {
+  uint32_t slot = (uint32_t)(timestamp / 1000000) / w->slot_s;
+
+  if (w->open.count > 0 && slot > w->slot) {
+    window_close(w);
+  }
+  if (w->open.count == 0) {
+    w->slot = slot;
+    w->temp_min = w->temp_max = temperature;
+    w->hum_min = w->hum_max = humidity;
+  }
+  window_expire(w, w->slot);
+
+  if (temperature < w->temp_min) w->temp_min = temperature;
+  if (temperature > w->temp_max) w->temp_max = temperature;
+  if (humidity < w->hum_min) w->hum_min = humidity;
+  if (humidity > w->hum_max) w->hum_max = humidity;
+  w->open.count++;
+  w->open.temp_sum += temperature;
+  w->open.hum_sum += humidity;
+  w->open.temp_sq += (int32_t)temperature * temperature;
+  w->open.hum_sq += (int32_t)humidity * humidity;
+
+  // alpha = dt / (tau + dt), con tau la duración de la ventana
+  if (w->ewma_time == 0) {
+    w->temp_ewma = temperature * EWMA_ONE;
+    w->hum_ewma = humidity * EWMA_ONE;
+  } else {
+    uint64_t dt_ms =
+        timestamp > w->ewma_time ? (timestamp - w->ewma_time) / 1000 : 0;
+    uint64_t tau_ms = (uint64_t)w->slot_s * SLOTS * 1000;
+    uint32_t alpha_q24 = (dt_ms << EWMA_SHIFT) / (tau_ms + dt_ms);
+    w->temp_ewma = ewma_step(w->temp_ewma, temperature, alpha_q24);
+    w->hum_ewma = ewma_step(w->hum_ewma, humidity, alpha_q24);
+  }
+  w->ewma_time = timestamp;
+}
+
+static uint32_t isqrt64(uint64_t x) {
+  uint64_t root = 0;
+  uint64_t bit = 1ULL << 62;
+
+  while (bit > x) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (x >= root + bit) {
+      x -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+static void value_from(rolling_value_t *v, int16_t min, int16_t max,
+                       int32_t sum, int64_t sq, uint32_t n, int64_t ewma) {
+  // Media redondeada; sum(x - m)^2 = sq - 2 m sum + n m^2 es exacta para
+  // cualquier m entero y no desborda aunque lo haría n * sq - sum^2
+  int32_t m = sum >= 0 ? (sum + (int32_t)n / 2) / (int32_t)n
+                       : (sum - (int32_t)n / 2) / (int32_t)n;
+  int64_t dev = sq - 2 * (int64_t)m * sum + (int64_t)n * m * m;
+
+  v->min = min;
+  v->max = max;
+  v->mean = m;
+  // En centésimas para redondear a décimas
+  v->stddev = (isqrt64((uint64_t)(dev > 0 ? dev : 0) * 100 / n) + 5) / 10;
+  v->ewma = (ewma + EWMA_ONE / 2) >> EWMA_SHIFT;
+}
+
+static int16_t extreme(mono_deque_t *d, int16_t open, bool has_open,
+                       bool is_max) {
+  if (d->len == 0) {
+    return open;
+  }
+  int16_t value = deque_at(d, 0)->value;
+  if (has_open && (is_max ? open > value : open < value)) {
+    return open;
+  }
+  return value;
+}
+
+void rolling_stats_add(int64_t timestamp, int16_t temperature,
+                       int16_t humidity) {
+  static const uint32_t window_s[ROLLING_WINDOWS] = {
+      CONFIG_ROLLING_SHORT_WINDOW_S,
+      CONFIG_ROLLING_LONG_WINDOW_S,
+  };
+
+  taskENTER_CRITICAL(&s_lock);
+  for (int i = 0; i < ROLLING_WINDOWS; i++) {
+    window_t *w = &s_windows[i];
+    if (w->slot_s == 0) {
+      w->slot_s = window_s[i] >= SLOTS ? window_s[i] / SLOTS : 1;
+    }
+    window_add(w, timestamp, temperature, humidity);
+  }
+  taskEXIT_CRITICAL(&s_lock);
+}
+
+void rolling_stats_get(rolling_window_t window, rolling_stats_t *out) {
+  window_t *w = &s_windows[window];
+
+  *out = (rolling_stats_t){0};
+  taskENTER_CRITICAL(&s_lock);
+  out->window_s = w->slot_s * SLOTS;
+  sums_t total = w->closed;
+  sums_add(&total, &w->open, 1);
+  bool has_open = w->open.count > 0;
+  if (total.count > 0) {
+    out->count = total.count;
+    value_from(&out->temperature,
+               extreme(&w->temp_mins, w->temp_min, has_open, false),
+               extreme(&w->temp_maxs, w->temp_max, has_open, true),
+               total.temp_sum, total.temp_sq, total.count, w->temp_ewma);
+    value_from(&out->humidity,
+               extreme(&w->hum_mins, w->hum_min, has_open, false),
+               extreme(&w->hum_maxs, w->hum_max, has_open, true),
+               total.hum_sum, total.hum_sq, total.count, w->hum_ewma);
+  }
+  taskEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,81 @@
+/* Archivo: rolling_stats.h
+ * Descripción: Estadísticas de temperatura y humedad sobre ventanas
+ *              deslizantes (por defecto la última hora y las últimas 24
+ *              horas): mínimo, máximo, media, desviación típica y media
+ *              móvil exponencial (EWMA). Sustituyen a los extremos desde el
+ *              arranque, que tras el primer día caluroso ya no cambian.
+ *
+ *              Cada ventana se divide en CONFIG_ROLLING_SLOTS ranuras; el
+ *              mínimo y el máximo se mantienen con colas monótonas de
+ *              ranuras y las sumas de la ventana se actualizan al entrar y
+ *              salir cada ranura, así cada lectura cuesta O(1) amortizado y
+ *              la memoria es fija. El borde de la ventana avanza de ranura
+ *              en ranura (1 minuto en la de una hora con 60 ranuras).
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_ROLLING_STATS_H_
+#define MAIN_ROLLING_STATS_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Ventanas disponibles
+ */
+typedef enum {
+  ROLLING_SHORT = 0, // CONFIG_ROLLING_SHORT_WINDOW_S (1 h)
+  ROLLING_LONG,      // CONFIG_ROLLING_LONG_WINDOW_S (24 h)
+  ROLLING_WINDOWS
+} rolling_window_t;
+
+/**
+ * @brief Estadísticas de una magnitud en una ventana
+ *
+ * En décimas de °C o de %. Sin lecturas en la ventana todo vale 0.
+ */
+typedef struct {
+  int16_t min;
+  int16_t max;
+  int16_t mean;
+  uint16_t stddev;
+  int16_t ewma; // Constante de tiempo igual a la ventana
+} rolling_value_t;
+
+/**
+ * @brief Estadísticas de una ventana
+ */
+typedef struct {
+  rolling_value_t temperature;
+  rolling_value_t humidity;
+  uint32_t count;    // Lecturas dentro de la ventana
+  uint32_t window_s; // Duración efectiva de la ventana
+} rolling_stats_t;
+
+/**
+ * @brief Añade una lectura válida a todas las ventanas
+ *
+ * Solo puede llamarla una tarea. Las ventanas van con el reloj monótono,
+ * no con time(): un salto de la hora por SNTP no las vacía.
+ *
+ * @param timestamp esp_timer_get_time() de la lectura
+ * @param temperature Décimas de °C
+ * @param humidity Décimas de %
+ */
+void rolling_stats_add(int64_t timestamp, int16_t temperature,
+                       int16_t humidity);
+
+/**
+ * @brief Copia las estadísticas de una ventana
+ *
+ * Segura desde cualquier tarea; O(1).
+ *
+ * @param window Ventana
+ * @param[out] out Estadísticas a la última lectura añadida
+ */
+void rolling_stats_get(rolling_window_t window, rolling_stats_t *out);
+
+#endif /* MAIN_ROLLING_STATS_H_ */
@@ -0,0 +1,114 @@
+/* Archivo: sample_bench.c
+ * Descripción: Ver sample_bench.h. Cada iteración hace el trabajo de una
+ *              lectura en el camino de reparto: comparación con el umbral
+ *              del relé, JSON de MQTT, JSON del WebSocket y las dos líneas
+ *              de la pantalla.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "sample_bench.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "fmt.h"
+
+#define ITERATIONS 1000
+#define THRESHOLD 300
+
+static const char *TAG = "SAMPLE_BENCH";
+
+// volatile para que el compilador no pliegue los valores
+static volatile int16_t s_temp = 234;
+static volatile int16_t s_hum = 561;
+static volatile int16_t s_min = -15;
+static volatile int16_t s_max = 317;
+static volatile int s_sink;
+
+static void path_float(char *buf, size_t size) {
+  float temp_c = s_temp / 10.0;
+  int relay = temp_c > THRESHOLD / 10.0;
+
+  snprintf(buf, size,
+           "{\"temperatura\": %.1f, \"humedad\": %.1f, \"min_temp\": %.1f, "
+           "\"max_temp\": %.1f}",
+           s_temp / 10.0, s_hum / 10.0, s_min / 10.0, s_max / 10.0);
+  s_sink += buf[1];
+  snprintf(buf, size,
+           "{\"temp\": %.1f, \"hum\": %.1f, \"min_t\": %.1f, \"max_t\": %.1f, "
+           "\"relay\": %d, \"limit\": %.1f}",
+           s_temp / 10.0, s_hum / 10.0, s_min / 10.0, s_max / 10.0, relay,
+           THRESHOLD / 10.0);
+  s_sink += buf[1];
+  snprintf(buf, size, "Temp.: %.1f C", s_temp / 10.0);
+  s_sink += buf[1];
+  snprintf(buf, size, "Hum.: %.1f %%", s_hum / 10.0);
+  s_sink += buf[1];
+}
+
+static void path_fixed(char *buf, size_t size) {
+  int relay = s_temp > THRESHOLD;
+  fmt_t f;
+
+  fmt_init(&f, buf, size);
+  fmt_str(&f, "{\"temperatura\": ");
+  fmt_deci(&f, s_temp);
+  fmt_str(&f, ", \"humedad\": ");
+  fmt_deci(&f, s_hum);
+  fmt_str(&f, ", \"min_temp\": ");
+  fmt_deci(&f, s_min);
+  fmt_str(&f, ", \"max_temp\": ");
+  fmt_deci(&f, s_max);
+  fmt_str(&f, "}");
+  s_sink += buf[1];
+  fmt_init(&f, buf, size);
+  fmt_str(&f, "{\"temp\": ");
+  fmt_deci(&f, s_temp);
+  fmt_str(&f, ", \"hum\": ");
+  fmt_deci(&f, s_hum);
+  fmt_str(&f, ", \"min_t\": ");
+  fmt_deci(&f, s_min);
+  fmt_str(&f, ", \"max_t\": ");
+  fmt_deci(&f, s_max);
+  fmt_str(&f, ", \"relay\": ");
+  fmt_uint(&f, relay);
+  fmt_str(&f, ", \"limit\": ");
+  fmt_deci(&f, THRESHOLD);
+  fmt_str(&f, "}");
+  s_sink += buf[1];
+  fmt_init(&f, buf, size);
+  fmt_str(&f, "Temp.: ");
+  fmt_deci(&f, s_temp);
+  fmt_str(&f, " C");
+  s_sink += buf[1];
+  fmt_init(&f, buf, size);
+  fmt_str(&f, "Hum.: ");
+  fmt_deci(&f, s_hum);
+  fmt_str(&f, " %");
+  s_sink += buf[1];
+}
+
+static uint32_t measure(void (*path)(char *, size_t)) {
+  char buf[200];
+
+  path(buf, sizeof(buf)); // Calienta la caché de instrucciones
+  uint32_t start = esp_cpu_get_cycle_count();
+  for (int i = 0; i < ITERATIONS; i++) {
+    path(buf, sizeof(buf));
+  }
+  return (esp_cpu_get_cycle_count() - start) / ITERATIONS;
+}
+
+void sample_bench_run(void) {
+  uint32_t cycles_float = measure(path_float);
+  uint32_t cycles_fixed = measure(path_fixed);
+
+  ESP_LOGI(TAG, "Ciclos por lectura: float+printf %lu, décimas+fmt %lu",
+           (unsigned long)cycles_float, (unsigned long)cycles_fixed);
+}
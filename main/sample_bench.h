@@ -0,0 +1,22 @@
+/* Archivo: sample_bench.h
+ * Descripción: Medida en el arranque de los ciclos de CPU que cuesta dar
+ *              formato a una lectura, con coma flotante y printf como antes
+ *              y con fmt.h. Solo con CONFIG_SAMPLE_BENCH.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_SAMPLE_BENCH_H_
+#define MAIN_SAMPLE_BENCH_H_
+
+/**
+ * @brief Mide los dos caminos y registra los ciclos por lectura
+ *
+ * Bloquea unos cientos de milisegundos; llamar antes de arrancar las tareas.
+ */
+void sample_bench_run(void);
+
+#endif /* MAIN_SAMPLE_BENCH_H_ */
@@ -0,0 +1,281 @@
+/* Archivo: screen_mirror.c
+ * Descripción: Espejo remoto de la pantalla OLED SSD1306 por HTTP y WebSocket.
+ *              /screen devuelve el contenido actual de _page[] como imagen PBM
+ *              generada página a página, sin copiar el frame completo.
+ *              /screen/ws envía solo los cambios (XOR + RLE de ceros).
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "screen_mirror.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+#define SCREEN_MAX_PAGES SSD1306_MAX_PAGES
+#define SCREEN_MAX_WIDTH SSD1306_WIDTH
+#define SCREEN_FRAME_SIZE (SCREEN_MAX_PAGES * SCREEN_MAX_WIDTH)
+#define SCREEN_MAX_CLIENTS 4
+
+// Peor caso del RLE: alternancia cero/no-cero (3 bytes por cada 2 de entrada)
+#define SCREEN_OUT_SIZE (3 + (SCREEN_FRAME_SIZE * 3) / 2 + 2)
+
+static const char *TAG = "SCREEN";
+
+static httpd_handle_t s_server = NULL;
+static SSD1306_t *s_dev = NULL;
+
+// Clientes de /screen/ws; protegidos por s_lock (handler HTTP vs. tarea OLED)
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static int s_clients[SCREEN_MAX_CLIENTS] = {-1, -1, -1, -1};
+static bool s_keyframe_pending = false;
+
+// Último frame enviado y buffer de salida, usados solo desde screen_mirror_poll
+static uint8_t s_prev[SCREEN_FRAME_SIZE];
+static uint8_t s_out[SCREEN_OUT_SIZE];
+
+static esp_err_t add_client(int fd) {
+  esp_err_t ret = ESP_ERR_NO_MEM;
+
+  taskENTER_CRITICAL(&s_lock);
+  for (int i = 0; i < SCREEN_MAX_CLIENTS; i++) {
+    if (s_clients[i] == fd) {
+      ret = ESP_OK;
+      break;
+    }
+  }
+  for (int i = 0; ret != ESP_OK && i < SCREEN_MAX_CLIENTS; i++) {
+    if (s_clients[i] < 0) {
+      s_clients[i] = fd;
+      ret = ESP_OK;
+    }
+  }
+  if (ret == ESP_OK) {
+    // Un cliente nuevo necesita el frame completo
+    s_keyframe_pending = true;
+  }
+  taskEXIT_CRITICAL(&s_lock);
+  return ret;
+}
+
+void screen_mirror_on_close(int fd) {
+  taskENTER_CRITICAL(&s_lock);
+  for (int i = 0; i < SCREEN_MAX_CLIENTS; i++) {
+    if (s_clients[i] == fd) {
+      s_clients[i] = -1;
+    }
+  }
+  taskEXIT_CRITICAL(&s_lock);
+}
+
+bool screen_mirror_is_client(int fd) {
+  bool found = false;
+  taskENTER_CRITICAL(&s_lock);
+  for (int i = 0; i < SCREEN_MAX_CLIENTS; i++) {
+    if (s_clients[i] == fd) {
+      found = true;
+    }
+  }
+  taskEXIT_CRITICAL(&s_lock);
+  return found;
+}
+
+/**
+ * @brief Devuelve la pantalla actual como PBM binario (P4)
+ *
+ * El framebuffer del SSD1306 está organizado en páginas de 8 filas con un
+ * byte por columna; PBM es fila a fila, MSB primero. Se convierte una página
+ * cada vez (128 bytes en pila) y se envía como un chunk. Los píxeles
+ * encendidos se dibujan en blanco, igual que en el panel.
+ */
+static esp_err_t screen_pbm_handler(httpd_req_t *req) {
+  int pages = ssd1306_get_pages(s_dev);
+  int width = ssd1306_get_width(s_dev);
+  int row_bytes = width / 8;
+
+  httpd_resp_set_type(req, "image/x-portable-bitmap");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+  char header[24];
+  snprintf(header, sizeof(header), "P4\n%d %d\n", width, pages * 8);
+  httpd_resp_send_chunk(req, header, HTTPD_RESP_USE_STRLEN);
+
+  uint8_t segs[SCREEN_MAX_WIDTH];
+  uint8_t rows[8 * SCREEN_MAX_WIDTH / 8];
+  for (int page = 0; page < pages; page++) {
+    ssd1306_get_page(s_dev, page, segs);
+    for (int bit = 0; bit < 8; bit++) {
+      uint8_t *row = &rows[bit * row_bytes];
+      for (int col = 0; col < row_bytes; col++) {
+        uint8_t out = 0;
+        for (int x = 0; x < 8; x++) {
+          out = (out << 1) | ((segs[col * 8 + x] >> bit) & 0x01);
+        }
+        row[col] = ~out; // PBM: 1 = negro
+      }
+    }
+    if (httpd_resp_send_chunk(req, (const char *)rows, 8 * row_bytes) !=
+        ESP_OK) {
+      ESP_LOGW(TAG, "Cliente /screen desconectado");
+      return ESP_FAIL;
+    }
+  }
+  httpd_resp_send_chunk(req, NULL, 0);
+  return ESP_OK;
+}
+
+static esp_err_t screen_ws_handler(httpd_req_t *req) {
+  if (req->method == HTTP_GET) {
+    int fd = httpd_req_to_sockfd(req);
+    if (add_client(fd) != ESP_OK) {
+      // Al devolver error el servidor cierra la conexión
+      ESP_LOGW(TAG, "Sin hueco para el cliente de espejo %d", fd);
+      return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Cliente de espejo conectado (fd: %d)", fd);
+    return ESP_OK;
+  }
+
+  // El canal es solo de salida: se consumen y descartan los frames entrantes
+  httpd_ws_frame_t ws_pkt = {0};
+  esp_err_t ret = httpd_ws_recv_frame(req, &ws_pkt, 0);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+  if (ws_pkt.len == 0) {
+    return ESP_OK;
+  }
+  uint8_t discard[16];
+  if (ws_pkt.len > sizeof(discard)) {
+    return ESP_FAIL; // Cierra la conexión
+  }
+  ws_pkt.payload = discard;
+  return httpd_ws_recv_frame(req, &ws_pkt, ws_pkt.len);
+}
+
+/**
+ * @brief Codifica el XOR entre el frame actual y s_prev en s_out
+ *
+ * Actualiza s_prev con el frame actual mientras codifica.
+ *
+ * @param keyframe Si es true, se codifica contra un frame a cero
+ * @param changed Se pone a true si algún byte cambió
+ * @return size_t Longitud total del mensaje en s_out
+ */
+static size_t encode_frame(bool keyframe, bool *changed) {
+  int pages = ssd1306_get_pages(s_dev);
+  int width = ssd1306_get_width(s_dev);
+  size_t out = 0;
+  uint8_t zeros = 0;
+
+  s_out[out++] = keyframe ? 'K' : 'D';
+  s_out[out++] = (uint8_t)pages;
+  s_out[out++] = (uint8_t)width;
+  *changed = false;
+
+  uint8_t segs[SCREEN_MAX_WIDTH];
+  for (int page = 0; page < pages; page++) {
+    ssd1306_get_page(s_dev, page, segs);
+    uint8_t *prev = &s_prev[page * SCREEN_MAX_WIDTH];
+    for (int seg = 0; seg < width; seg++) {
+      uint8_t delta = keyframe ? segs[seg] : (segs[seg] ^ prev[seg]);
+      if (segs[seg] != prev[seg]) {
+        *changed = true;
+      }
+      prev[seg] = segs[seg];
+
+      if (delta == 0) {
+        if (++zeros == 255) {
+          s_out[out++] = 0x00;
+          s_out[out++] = zeros;
+          zeros = 0;
+        }
+        continue;
+      }
+      if (zeros) {
+        s_out[out++] = 0x00;
+        s_out[out++] = zeros;
+        zeros = 0;
+      }
+      s_out[out++] = delta;
+    }
+  }
+  if (zeros) {
+    s_out[out++] = 0x00;
+    s_out[out++] = zeros;
+  }
+  return out;
+}
+
+void screen_mirror_poll(void) {
+  if (s_server == NULL || s_dev == NULL) {
+    return;
+  }
+
+  int clients[SCREEN_MAX_CLIENTS];
+  int count = 0;
+  bool keyframe;
+  taskENTER_CRITICAL(&s_lock);
+  for (int i = 0; i < SCREEN_MAX_CLIENTS; i++) {
+    if (s_clients[i] >= 0) {
+      clients[count++] = s_clients[i];
+    }
+  }
+  keyframe = s_keyframe_pending;
+  s_keyframe_pending = false;
+  taskEXIT_CRITICAL(&s_lock);
+
+  if (count == 0) {
+    return;
+  }
+
+  bool changed;
+  size_t len = encode_frame(keyframe, &changed);
+  if (!keyframe && !changed) {
+    return;
+  }
+
+  httpd_ws_frame_t ws_pkt = {
+      .payload = s_out, .len = len, .type = HTTPD_WS_TYPE_BINARY};
+  for (int i = 0; i < count; i++) {
+    if (httpd_ws_get_fd_info(s_server, clients[i]) !=
+            HTTPD_WS_CLIENT_WEBSOCKET ||
+        httpd_ws_send_frame_async(s_server, clients[i], &ws_pkt) != ESP_OK) {
+      ESP_LOGD(TAG, "Cliente de espejo %d desconectado", clients[i]);
+      screen_mirror_on_close(clients[i]);
+    }
+  }
+  ESP_LOGD(TAG, "Frame %c enviado: %u bytes", s_out[0], (unsigned)len);
+}
+
+esp_err_t screen_mirror_register(httpd_handle_t server, SSD1306_t *dev) {
+  s_server = server;
+  s_dev = dev;
+
+  httpd_uri_t pbm = {.uri = "/screen",
+                     .method = HTTP_GET,
+                     .handler = screen_pbm_handler,
+                     .user_ctx = NULL};
+  esp_err_t ret = httpd_register_uri_handler(server, &pbm);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo registrar /screen: %s", esp_err_to_name(ret));
+    return ret;
+  }
+
+  httpd_uri_t ws = {.uri = "/screen/ws",
+                    .method = HTTP_GET,
+                    .handler = screen_ws_handler,
+                    .user_ctx = NULL,
+                    .is_websocket = true};
+  ret = httpd_register_uri_handler(server, &ws);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo registrar /screen/ws: %s", esp_err_to_name(ret));
+  }
+  return ret;
+}
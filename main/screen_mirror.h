@@ -0,0 +1,67 @@
+/* Archivo: screen_mirror.h
+ * Descripción: Espejo remoto de la pantalla OLED SSD1306.
+ *              Expone el framebuffer actual por HTTP (/screen, formato PBM) y
+ *              por WebSocket (/screen/ws) con frames delta comprimidos.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ *
+ * Formato de los frames WebSocket (binarios):
+ *  - Byte 0: 'K' (keyframe) o 'D' (delta respecto al frame anterior)
+ *  - Byte 1: número de páginas del panel
+ *  - Byte 2: ancho del panel en columnas
+ *  - Resto: bytes del framebuffer (orden página/columna de _page[]) tras XOR
+ *    con el frame anterior (o con cero en un keyframe), codificados así:
+ *      0x00 N  -> N bytes a cero (1..255)
+ *      otro    -> byte literal
+ *
+ * Cuando la pantalla no cambia no se envía nada.
+ */
+
+#ifndef MAIN_SCREEN_MIRROR_H_
+#define MAIN_SCREEN_MIRROR_H_
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "ssd1306.h"
+
+/**
+ * @brief Registra los endpoints /screen y /screen/ws en el servidor HTTP
+ *
+ * @param server Servidor HTTP ya iniciado
+ * @param dev Pantalla cuyo framebuffer se replica
+ * @return esp_err_t ESP_OK si ambos handlers quedaron registrados
+ */
+esp_err_t screen_mirror_register(httpd_handle_t server, SSD1306_t *dev);
+
+/**
+ * @brief Envía a los clientes /screen/ws los cambios del framebuffer
+ *
+ * Debe llamarse desde la tarea que dibuja en la pantalla, después de
+ * actualizarla. No hace nada si no hay clientes o si el frame no cambió.
+ */
+void screen_mirror_poll(void);
+
+/**
+ * @brief Indica si el descriptor pertenece a un cliente de /screen/ws
+ *
+ * @param fd Descriptor de socket del cliente
+ * @return true si el cliente está suscrito al espejo de pantalla
+ */
+bool screen_mirror_is_client(int fd);
+
+/**
+ * @brief Olvida un cliente cuyo socket se ha cerrado
+ *
+ * Debe llamarse desde el close_fn del servidor HTTP para que un descriptor
+ * reutilizado por otro cliente no reciba frames del espejo.
+ *
+ * @param fd Descriptor de socket cerrado
+ */
+void screen_mirror_on_close(int fd);
+
+#endif /* MAIN_SCREEN_MIRROR_H_ */
@@ -0,0 +1,192 @@
+/* Archivo: sensor_replay.c
+ * Descripción: Lectura de trazas CSV para la fuente de reproducción del
+ *              servicio de sensor. Ver sensor_replay.h para el formato.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "sensor_replay.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#define REPLAY_LINE_MAX 96
+
+static const char *TAG = "REPLAY";
+
+struct sensor_replay {
+  FILE *file;
+  bool loop;
+  bool started;  // Ya se devolvió alguna muestra
+  bool has_prev; // prev_t_ms es de la pasada actual
+  uint32_t prev_t_ms;
+  uint32_t last_delay_ms;
+  uint32_t line;
+};
+
+// Alias cortos y nombres de esp_err_to_name() aceptados en la columna estado
+static const struct {
+  const char *name;
+  esp_err_t err;
+} status_names[] = {
+    {"ok", ESP_OK},
+    {"crc", ESP_ERR_INVALID_CRC},
+    {"timeout", ESP_ERR_TIMEOUT},
+    {"response", ESP_ERR_INVALID_RESPONSE},
+    {"ESP_OK", ESP_OK},
+    {"ESP_FAIL", ESP_FAIL},
+    {"ESP_ERR_INVALID_CRC", ESP_ERR_INVALID_CRC},
+    {"ESP_ERR_TIMEOUT", ESP_ERR_TIMEOUT},
+    {"ESP_ERR_INVALID_RESPONSE", ESP_ERR_INVALID_RESPONSE},
+    {"ESP_ERR_INVALID_STATE", ESP_ERR_INVALID_STATE},
+    {"ESP_ERR_NOT_FOUND", ESP_ERR_NOT_FOUND},
+};
+
+static const char *skip_spaces(const char *p) {
+  while (*p == ' ' || *p == '\t') {
+    p++;
+  }
+  return p;
+}
+
+/**
+ * @brief Lee un valor con decimales en décimas
+ *
+ * @param p Inicio del campo
+ * @param[out] end Fin del campo
+ * @param[out] out Valor en décimas, 0 si el campo está vacío
+ * @return true si el campo está vacío o es un número válido
+ */
+static bool parse_deci(const char *p, const char **end, int16_t *out) {
+  p = skip_spaces(p);
+  if (*p == ',' || *p == '\0' || *p == '\r' || *p == '\n') {
+    *out = 0;
+    *end = p;
+    return true;
+  }
+  char *e;
+  double v = strtod(p, &e);
+  if (e == p || v < -3276.8 || v > 3276.7) {
+    return false;
+  }
+  *out = (int16_t)lround(v * 10);
+  *end = skip_spaces(e);
+  return true;
+}
+
+esp_err_t sensor_replay_parse_line(const char *line,
+                                   sensor_replay_record_t *rec) {
+  const char *p = skip_spaces(line);
+  if (!isdigit((unsigned char)*p)) {
+    return ESP_ERR_NOT_FOUND;
+  }
+
+  char *e;
+  unsigned long t = strtoul(p, &e, 10);
+  p = skip_spaces(e);
+  if (*p++ != ',' || !parse_deci(p, &p, &rec->temperature) || *p++ != ',' ||
+      !parse_deci(p, &p, &rec->humidity)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  rec->t_ms = t;
+  rec->status = ESP_OK;
+
+  if (*p == ',') {
+    p = skip_spaces(p + 1);
+    size_t len = strcspn(p, " \t\r\n");
+    if (len > 0) {
+      size_t i;
+      for (i = 0; i < sizeof(status_names) / sizeof(status_names[0]); i++) {
+        if (strlen(status_names[i].name) == len &&
+            strncmp(p, status_names[i].name, len) == 0) {
+          break;
+        }
+      }
+      if (i == sizeof(status_names) / sizeof(status_names[0])) {
+        return ESP_ERR_INVALID_ARG;
+      }
+      rec->status = status_names[i].err;
+    }
+  } else if (*p != '\0' && *p != '\r' && *p != '\n') {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  if (rec->status != ESP_OK) {
+    rec->temperature = 0;
+    rec->humidity = 0;
+  }
+  return ESP_OK;
+}
+
+esp_err_t sensor_replay_open(const char *path, bool loop,
+                             sensor_replay_t **out) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL) {
+    return ESP_ERR_NOT_FOUND;
+  }
+  sensor_replay_t *r = calloc(1, sizeof(*r));
+  if (r == NULL) {
+    fclose(f);
+    return ESP_ERR_NO_MEM;
+  }
+  r->file = f;
+  r->loop = loop;
+  *out = r;
+  return ESP_OK;
+}
+
+esp_err_t sensor_replay_next(sensor_replay_t *r, sensor_replay_record_t *rec,
+                             uint32_t *delay_ms) {
+  char line[REPLAY_LINE_MAX];
+  bool wrapped = false;
+
+  while (1) {
+    if (fgets(line, sizeof(line), r->file) == NULL) {
+      // Una vuelta completa sin muestras: la traza no tiene ninguna válida
+      if (!r->loop || wrapped) {
+        return ESP_ERR_NOT_FOUND;
+      }
+      rewind(r->file);
+      r->line = 0;
+      r->has_prev = false;
+      wrapped = true;
+      continue;
+    }
+    r->line++;
+
+    esp_err_t ret = sensor_replay_parse_line(line, rec);
+    if (ret == ESP_ERR_INVALID_ARG) {
+      ESP_LOGW(TAG, "Línea %lu ignorada: %.*s", (unsigned long)r->line,
+               (int)strcspn(line, "\r\n"), line);
+    }
+    if (ret != ESP_OK) {
+      continue;
+    }
+
+    // La primera muestra tras dar la vuelta (o tras un salto atrás en t_ms)
+    // repite el último intervalo
+    if (r->has_prev && rec->t_ms >= r->prev_t_ms) {
+      r->last_delay_ms = rec->t_ms - r->prev_t_ms;
+    }
+    *delay_ms = r->started ? r->last_delay_ms : 0;
+    r->prev_t_ms = rec->t_ms;
+    r->started = true;
+    r->has_prev = true;
+    return ESP_OK;
+  }
+}
+
+void sensor_replay_close(sensor_replay_t *r) {
+  if (r != NULL) {
+    fclose(r->file);
+    free(r);
+  }
+}
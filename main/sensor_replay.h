@@ -0,0 +1,82 @@
+/* Archivo: sensor_replay.h
+ * Descripción: Fuente de lecturas que reproduce una traza CSV grabada o
+ *              sintética, incluidos los fallos del sensor. Solo usa la
+ *              biblioteca C, por lo que funciona igual en el ESP32 (traza en
+ *              SPIFFS) y en el target linux de ESP-IDF.
+ *
+ *              Formato, una muestra por línea:
+ *                t_ms,temp,hum[,estado]
+ *              t_ms es el instante de la muestra desde el inicio de la traza,
+ *              temp y hum van en °C y % con un decimal, y estado es "ok"
+ *              (por defecto), "crc", "timeout", "response" o el nombre de un
+ *              esp_err_t (p. ej. ESP_ERR_INVALID_CRC). En las muestras con
+ *              error temp y hum pueden ir vacíos. Las líneas que empiezan
+ *              por '#' o que no empiezan por un número (cabecera) se ignoran.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_SENSOR_REPLAY_H_
+#define MAIN_SENSOR_REPLAY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/**
+ * @brief Muestra de la traza
+ */
+typedef struct {
+  uint32_t t_ms;       // Instante desde el inicio de la traza
+  esp_err_t status;    // Resultado de la lectura simulada
+  int16_t temperature; // Décimas de °C (0 si la muestra es un error)
+  int16_t humidity;    // Décimas de % (0 si la muestra es un error)
+} sensor_replay_record_t;
+
+typedef struct sensor_replay sensor_replay_t;
+
+/**
+ * @brief Abre una traza
+ *
+ * @param path Ruta del archivo CSV
+ * @param loop Volver al principio al llegar al final
+ * @param[out] out Traza abierta
+ * @return esp_err_t ESP_OK, ESP_ERR_NOT_FOUND si no se pudo abrir el archivo
+ */
+esp_err_t sensor_replay_open(const char *path, bool loop, sensor_replay_t **out);
+
+/**
+ * @brief Lee la siguiente muestra
+ *
+ * @param r Traza
+ * @param[out] rec Muestra
+ * @param[out] delay_ms Tiempo de traza desde la muestra anterior; al dar la
+ *             vuelta se repite el último intervalo
+ * @return esp_err_t ESP_OK, ESP_ERR_NOT_FOUND al final de una traza sin
+ *         bucle o si no contiene ninguna muestra válida
+ */
+esp_err_t sensor_replay_next(sensor_replay_t *r, sensor_replay_record_t *rec,
+                             uint32_t *delay_ms);
+
+/**
+ * @brief Cierra la traza y libera su memoria
+ */
+void sensor_replay_close(sensor_replay_t *r);
+
+/**
+ * @brief Interpreta una línea de la traza
+ *
+ * @param line Línea terminada en '\0' (puede incluir el salto de línea)
+ * @param[out] rec Muestra
+ * @return esp_err_t ESP_OK si es una muestra, ESP_ERR_NOT_FOUND si es un
+ *         comentario, una cabecera o una línea vacía, ESP_ERR_INVALID_ARG
+ *         si está mal formada
+ */
+esp_err_t sensor_replay_parse_line(const char *line,
+                                   sensor_replay_record_t *rec);
+
+#endif /* MAIN_SENSOR_REPLAY_H_ */
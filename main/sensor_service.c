@@ -0,0 +1,532 @@
+/* Archivo: sensor_service.c
+ * Descripción: Servicio de lectura del sensor DHT con caché, intervalo
+ *              mínimo entre lecturas y reintentos con espera exponencial.
+ *              La planificación física la hace dht_array; este módulo
+ *              decide cuándo volver a intentar y publica los resultados.
+ *              Con CONFIG_SENSOR_SOURCE_REPLAY las lecturas salen de una
+ *              traza CSV (sensor_replay.c) a la velocidad configurada, sin
+ *              tocar el hardware.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "sensor_service.h"
+
+#include <stdio.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/event_groups.h"
+#include "freertos/task.h"
+
+#include "fmt.h"
+
+#if CONFIG_SENSOR_SOURCE_REPLAY
+#include "sensor_replay.h"
+#else
+#include "dht_array.h"
+#include "dht_diag.h"
+#endif
+
+// Reintentos antes de publicar un error a los consumidores
+#define SENSOR_RETRIES 3
+// Espera del primer reintento; se duplica en cada fallo
+#define SENSOR_RETRY_BASE_MS 1000
+
+#define SENSOR_NEW_RESULT_BIT BIT0
+
+static const char *TAG = "SENSOR";
+
+#if CONFIG_SENSOR_SOURCE_REPLAY
+// Muestras seguidas sin esperar antes de ceder un tick al resto de tareas
+#define SENSOR_REPLAY_BURST 64
+
+#if CONFIG_SENSOR_REPLAY_LOOP
+#define SENSOR_REPLAY_LOOP true
+#else
+#define SENSOR_REPLAY_LOOP false
+#endif
+
+static sensor_replay_t *s_replay = NULL;
+#else
+static dht_array_handle_t s_array = NULL;
+static int s_index = 0;
+
+// Línea de tiempo de las lecturas: un esp_timer periódico avisa a la tarea
+// del sensor en t0 + k * periodo, sin deriva, y otro de un disparo los
+// reintentos
+static TaskHandle_t s_task = NULL;
+static esp_timer_handle_t s_tick_timer = NULL;
+static esp_timer_handle_t s_retry_timer = NULL;
+static volatile uint32_t s_ticks = 0; // Disparos del periódico
+static sensor_timing_t s_timing;      // Protegido por s_lock
+#endif
+static gpio_num_t s_pin = GPIO_NUM_NC;
+static uint32_t s_period_ms = 0;
+
+// Muestra publicada; protegida por s_lock (tarea del sensor vs. consumidores)
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static sensor_sample_t s_sample = {.status = ESP_ERR_INVALID_STATE};
+static EventGroupHandle_t s_events = NULL;
+
+static bool is_transient(esp_err_t err) {
+  return err == ESP_ERR_INVALID_CRC || err == ESP_ERR_TIMEOUT ||
+         err == ESP_ERR_INVALID_RESPONSE;
+}
+
+/**
+ * @brief Guarda el resultado de un intento y decide la siguiente espera
+ *
+ * @param status Resultado del intento
+ * @param temperature Décimas de °C, si status es ESP_OK
+ * @param humidity Décimas de %, si status es ESP_OK
+ * @param timestamp esp_timer_get_time() de la lectura
+ * @return uint32_t Milisegundos hasta el siguiente intento
+ */
+static uint32_t publish_attempt(esp_err_t status, int16_t temperature,
+                                int16_t humidity, int64_t timestamp) {
+  bool notify = false;
+  uint32_t failures;
+
+  taskENTER_CRITICAL(&s_lock);
+  if (status == ESP_OK) {
+    s_sample.temperature = temperature;
+    s_sample.humidity = humidity;
+    s_sample.timestamp = timestamp;
+    s_sample.failures = 0;
+  } else {
+    s_sample.failures++;
+  }
+  s_sample.status = status;
+  failures = s_sample.failures;
+  // Los errores aislados se reintentan sin molestar a los consumidores
+  if (failures == 0 || failures >= SENSOR_RETRIES) {
+    s_sample.seq++;
+    notify = true;
+  }
+  taskEXIT_CRITICAL(&s_lock);
+
+  if (notify) {
+    xEventGroupSetBits(s_events, SENSOR_NEW_RESULT_BIT);
+  }
+  if (failures == 0) {
+    return s_period_ms;
+  }
+
+  ESP_LOGW(TAG, "Lectura fallida (%s), intento %lu", esp_err_to_name(status),
+           (unsigned long)failures);
+  if (!is_transient(status)) {
+    return s_period_ms;
+  }
+  uint32_t delay = SENSOR_RETRY_BASE_MS << (failures - 1 < 5 ? failures - 1 : 5);
+  return delay < s_period_ms ? delay : s_period_ms;
+}
+
+#if CONFIG_SENSOR_SOURCE_REPLAY
+
+/**
+ * @brief Publica las muestras de la traza al ritmo de CONFIG_SENSOR_REPLAY_SPEED
+ *
+ * Los intervalos de la traza se dividen por la velocidad y se acumulan en
+ * un plazo absoluto: solo se duerme cuando el plazo va al menos un tick por
+ * delante, así el ritmo medio es exacto aunque el intervalo escalado sea
+ * menor que un tick. Con velocidad 0, o si la tarea no llega al ritmo
+ * pedido, se publica sin esperas cediendo un tick cada SENSOR_REPLAY_BURST
+ * muestras para no dejar sin CPU al resto de tareas.
+ */
+static void replay_task(void *pvParameters) {
+  sensor_replay_record_t rec;
+  uint32_t delay_ms;
+  uint32_t count = 0;
+  uint32_t since_sleep = 0;
+#if CONFIG_SENSOR_REPLAY_SPEED > 0
+  int64_t deadline = esp_timer_get_time();
+#endif
+
+  while (sensor_replay_next(s_replay, &rec, &delay_ms) == ESP_OK) {
+    TickType_t ticks = 0;
+#if CONFIG_SENSOR_REPLAY_SPEED > 0
+    deadline += (int64_t)delay_ms * 1000 / CONFIG_SENSOR_REPLAY_SPEED;
+    int64_t ahead_us = deadline - esp_timer_get_time();
+    ticks = ahead_us > 0 ? ahead_us / 1000 / portTICK_PERIOD_MS : 0;
+#endif
+    if (ticks == 0 && ++since_sleep == SENSOR_REPLAY_BURST) {
+      ticks = 1;
+    }
+    if (ticks > 0) {
+      vTaskDelay(ticks);
+      since_sleep = 0;
+    }
+    publish_attempt(rec.status, rec.temperature, rec.humidity,
+                    esp_timer_get_time());
+    count++;
+  }
+
+  ESP_LOGI(TAG, "Fin de la traza tras %lu muestras", (unsigned long)count);
+  sensor_replay_close(s_replay);
+  s_replay = NULL;
+  vTaskDelete(NULL);
+}
+
+#else
+
+static void tick_cb(void *arg) {
+  s_ticks++;
+  xTaskNotifyGive(s_task);
+}
+
+static void retry_cb(void *arg) {
+  xTaskNotifyGive(s_task);
+}
+
+/**
+ * @brief Indica si una lectura dentro de wait_ms deja al sensor descansar
+ *        rest_ms antes del siguiente instante
+ *
+ * Se guarda un margen de un tick más el mayor jitter medido: si la tarea
+ * despierta tarde en el instante, el sensor ya debe poder leerse.
+ */
+static bool retry_fits(uint32_t wait_ms, uint32_t rest_ms, int64_t next_tick) {
+  taskENTER_CRITICAL(&s_lock);
+  int64_t margin = portTICK_PERIOD_MS * 1000 + s_timing.max_jitter_us;
+  taskEXIT_CRITICAL(&s_lock);
+
+  int64_t retry = esp_timer_get_time() + (int64_t)wait_ms * 1000;
+  return wait_ms < s_period_ms &&
+         retry + (int64_t)rest_ms * 1000 + margin <= next_tick;
+}
+
+/**
+ * @brief Lee el sensor en cada instante de la línea de tiempo
+ *
+ * Cada disparo del periódico marca el instante de una lectura; el retraso
+ * con que despierta la tarea es el jitter. Si llegan varios disparos a la
+ * vez la tarea no llegó a tiempo: se lee una sola vez y los demás cuentan
+ * como perdidos. Los reintentos tras un error transitorio van entre dos
+ * instantes solo si dejan al sensor descansar antes del siguiente. Si en
+ * un instante el sensor aún no puede leerse, la lectura se aplaza hasta
+ * que pueda o, si no cabe antes del siguiente, el instante cuenta como
+ * saltado.
+ */
+static void sensor_task(void *pvParameters) {
+  int64_t period_us = (int64_t)s_period_ms * 1000;
+  uint32_t seen = 0;
+  uint32_t last_reads = 0;
+  uint32_t rest_ms = 0; // Intervalo mínimo del sensor tras una lectura
+
+  // La primera lectura es ahora, en el instante 0 de la línea de tiempo
+  esp_timer_start_periodic(s_tick_timer, period_us);
+  int64_t next_tick = esp_timer_get_time() + period_us;
+
+  while (1) {
+    uint32_t next_due_ms = 0;
+    dht_array_scan(s_array, &next_due_ms);
+
+    dht_array_value_t value;
+    dht_array_get(s_array, s_index, &value);
+    if (value.reads != last_reads) {
+      last_reads = value.reads;
+      rest_ms = next_due_ms;
+      uint32_t wait_ms = publish_attempt(value.status, value.temperature,
+                                         value.humidity, value.timestamp);
+      // dht_array no lee antes del intervalo mínimo del sensor, ni en el
+      // reintento ni en el siguiente instante
+      if (wait_ms < next_due_ms) {
+        wait_ms = next_due_ms;
+      }
+      if (retry_fits(wait_ms, rest_ms, next_tick)) {
+        esp_timer_start_once(s_retry_timer, (uint64_t)wait_ms * 1000);
+      }
+    } else if (next_due_ms > 0) {
+      // El sensor aún no puede leerse: se lee en cuanto pueda, sin que
+      // eso le quite el descanso antes del siguiente instante
+      if (retry_fits(next_due_ms, rest_ms, next_tick)) {
+        esp_timer_start_once(s_retry_timer, (uint64_t)next_due_ms * 1000);
+      } else {
+        taskENTER_CRITICAL(&s_lock);
+        s_timing.skipped++;
+        taskEXIT_CRITICAL(&s_lock);
+      }
+    }
+
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+    uint32_t fired = s_ticks - seen;
+    seen += fired;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (fired == 0) {
+      s_timing.retries++;
+    } else {
+      // Retraso respecto al último instante vencido
+      int64_t due = next_tick + (int64_t)(fired - 1) * period_us;
+      uint32_t jitter = now > due ? now - due : 0;
+      next_tick = due + period_us;
+      s_timing.ticks += fired;
+      s_timing.overruns += fired - 1;
+      s_timing.last_jitter_us = jitter;
+      if (jitter > s_timing.max_jitter_us) {
+        s_timing.max_jitter_us = jitter;
+      }
+      s_timing.total_jitter_us += jitter;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    if (fired > 0) {
+      esp_timer_stop(s_retry_timer);
+    }
+  }
+}
+
+#endif // CONFIG_SENSOR_SOURCE_REPLAY
+
+esp_err_t sensor_service_start(dht_sensor_type_t type, gpio_num_t pin,
+                               uint32_t period_ms) {
+  s_period_ms = period_ms;
+  s_pin = pin;
+
+  s_events = xEventGroupCreate();
+  if (s_events == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+
+#if CONFIG_SENSOR_SOURCE_REPLAY
+  esp_err_t ret = sensor_replay_open(CONFIG_SENSOR_REPLAY_PATH,
+                                     SENSOR_REPLAY_LOOP, &s_replay);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo abrir la traza %s: %s", CONFIG_SENSOR_REPLAY_PATH,
+             esp_err_to_name(ret));
+    return ret;
+  }
+
+  if (xTaskCreate(replay_task, "sensor_task", 3072, NULL, 6, NULL) != pdPASS) {
+    return ESP_ERR_NO_MEM;
+  }
+  ESP_LOGW(TAG, "Reproduciendo %s a velocidad x%d", CONFIG_SENSOR_REPLAY_PATH,
+           CONFIG_SENSOR_REPLAY_SPEED);
+#else
+  esp_err_t ret = dht_array_new(&s_array);
+  if (ret == ESP_OK) {
+    ret = dht_array_add(s_array, type, pin, 0, &s_index);
+  }
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo configurar el sensor: %s", esp_err_to_name(ret));
+    return ret;
+  }
+
+  const esp_timer_create_args_t tick_args = {.callback = tick_cb,
+                                             .name = "sensor_tick"};
+  const esp_timer_create_args_t retry_args = {.callback = retry_cb,
+                                              .name = "sensor_retry"};
+  if (esp_timer_create(&tick_args, &s_tick_timer) != ESP_OK ||
+      esp_timer_create(&retry_args, &s_retry_timer) != ESP_OK) {
+    return ESP_ERR_NO_MEM;
+  }
+  s_timing.period_ms = period_ms;
+
+  if (xTaskCreate(sensor_task, "sensor_task", 3072, NULL, 6, &s_task) !=
+      pdPASS) {
+    return ESP_ERR_NO_MEM;
+  }
+  ESP_LOGI(TAG, "Servicio de sensor en GPIO %d, periodo %lu ms", pin,
+           (unsigned long)period_ms);
+#endif
+  return ESP_OK;
+}
+
+esp_err_t sensor_service_get(sensor_sample_t *out) {
+  taskENTER_CRITICAL(&s_lock);
+  *out = s_sample;
+  taskEXIT_CRITICAL(&s_lock);
+
+  if (out->timestamp == 0) {
+    out->age_ms = UINT32_MAX;
+    return ESP_ERR_INVALID_STATE;
+  }
+  out->age_ms = (esp_timer_get_time() - out->timestamp) / 1000;
+  return ESP_OK;
+}
+
+esp_err_t sensor_service_wait(sensor_sample_t *out, uint32_t last_seq,
+                              TickType_t timeout) {
+  TickType_t start = xTaskGetTickCount();
+
+  while (1) {
+    sensor_service_get(out);
+    if (out->seq != last_seq) {
+      return ESP_OK;
+    }
+    TickType_t waited = xTaskGetTickCount() - start;
+    if (s_events == NULL || waited >= timeout) {
+      return ESP_ERR_TIMEOUT;
+    }
+    xEventGroupWaitBits(s_events, SENSOR_NEW_RESULT_BIT, pdTRUE, pdFALSE,
+                        timeout - waited);
+  }
+}
+
+esp_err_t sensor_service_get_timing(sensor_timing_t *out) {
+#if CONFIG_SENSOR_SOURCE_REPLAY
+  // El ritmo lo marca la traza
+  *out = (sensor_timing_t){0};
+  return ESP_ERR_NOT_SUPPORTED;
+#else
+  taskENTER_CRITICAL(&s_lock);
+  *out = s_timing;
+  taskEXIT_CRITICAL(&s_lock);
+  return ESP_OK;
+#endif
+}
+
+static esp_err_t sensor_api_handler(httpd_req_t *req) {
+  sensor_sample_t sample;
+  char json[160];
+
+  if (sensor_service_get(&sample) != ESP_OK) {
+    snprintf(json, sizeof(json), "{\"status\": \"%s\"}",
+             esp_err_to_name(sample.status));
+  } else {
+    snprintf(json, sizeof(json),
+             "{\"temp\": " DECI_FMT ", \"hum\": " DECI_FMT ", \"age_ms\": %lu, "
+             "\"status\": \"%s\", \"failures\": %lu}",
+             DECI_ARGS(sample.temperature), DECI_ARGS(sample.humidity),
+             (unsigned long)sample.age_ms, esp_err_to_name(sample.status),
+             (unsigned long)sample.failures);
+  }
+
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  return httpd_resp_send(req, json, HTTPD_RESP_USE_STRLEN);
+}
+
+/**
+ * @brief Devuelve la regularidad de las lecturas en JSON
+ */
+static esp_err_t sensor_timing_handler(httpd_req_t *req) {
+  sensor_timing_t timing;
+  char json[256];
+
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+  esp_err_t ret = sensor_service_get_timing(&timing);
+  if (ret != ESP_OK) {
+    snprintf(json, sizeof(json), "{\"status\": \"%s\"}",
+             esp_err_to_name(ret));
+    return httpd_resp_send(req, json, HTTPD_RESP_USE_STRLEN);
+  }
+  uint32_t woken = timing.ticks - timing.overruns;
+  snprintf(json, sizeof(json),
+           "{\"period_ms\": %lu, \"ticks\": %lu, \"overruns\": %lu, "
+           "\"retries\": %lu, \"skipped\": %lu, \"last_jitter_us\": %lu, "
+           "\"avg_jitter_us\": %lu, \"max_jitter_us\": %lu}",
+           (unsigned long)timing.period_ms, (unsigned long)timing.ticks,
+           (unsigned long)timing.overruns, (unsigned long)timing.retries,
+           (unsigned long)timing.skipped,
+           (unsigned long)timing.last_jitter_us,
+           (unsigned long)(woken ? timing.total_jitter_us / woken : 0),
+           (unsigned long)timing.max_jitter_us);
+  return httpd_resp_send(req, json, HTTPD_RESP_USE_STRLEN);
+}
+
+#if !CONFIG_SENSOR_SOURCE_REPLAY
+static esp_err_t send_hist(httpd_req_t *req, char *buf, size_t size,
+                           const char *name, const uint32_t *hist) {
+  int len = snprintf(buf, size, ", \"%s\": [", name);
+  for (int i = 0; i < DHT_DIAG_BUCKETS; i++) {
+    len += snprintf(buf + len, size - len, "%s%lu", i ? ", " : "",
+                    (unsigned long)hist[i]);
+  }
+  len += snprintf(buf + len, size - len, "]");
+  return httpd_resp_send_chunk(req, buf, len);
+}
+
+/**
+ * @brief Devuelve los diagnósticos de lectura del sensor en JSON
+ *
+ * Incluye los contadores por fase de fallo, los histogramas de duración de
+ * los pulsos de datos (cubetas de DHT_DIAG_BUCKET_US µs, la última acumula
+ * los más largos) y el margen de decisión del bit más débil. El JSON se
+ * genera por trozos en un buffer de pila.
+ */
+static esp_err_t sensor_diag_handler(httpd_req_t *req) {
+  dht_diag_t diag;
+  char buf[512];
+
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+  esp_err_t ret = dht_diag_get(s_pin, &diag);
+  if (ret != ESP_OK) {
+    snprintf(buf, sizeof(buf), "{\"status\": \"%s\"}", esp_err_to_name(ret));
+    return httpd_resp_send(req, buf, HTTPD_RESP_USE_STRLEN);
+  }
+
+  int64_t since_failure_ms =
+      diag.last_failure ? (esp_timer_get_time() - diag.last_failure) / 1000 : -1;
+  int len = snprintf(buf, sizeof(buf),
+                     "{\"pin\": %d, \"last_margin\": %u, \"worst_margin\": %d, "
+                     "\"ms_since_failure\": %lld, \"bucket_us\": %d, \"counts\": {",
+                     diag.pin, diag.last_margin,
+                     diag.worst_margin == UINT8_MAX ? -1 : diag.worst_margin,
+                     (long long)since_failure_ms, DHT_DIAG_BUCKET_US);
+  for (int i = 0; i < DHT_DIAG_MAX; i++) {
+    len += snprintf(buf + len, sizeof(buf) - len, "%s\"%s\": %lu",
+                    i ? ", " : "", dht_diag_event_name(i),
+                    (unsigned long)diag.count[i]);
+  }
+  len += snprintf(buf + len, sizeof(buf) - len, "}");
+  if (httpd_resp_send_chunk(req, buf, len) != ESP_OK ||
+      send_hist(req, buf, sizeof(buf), "low_hist", diag.low_hist) != ESP_OK ||
+      send_hist(req, buf, sizeof(buf), "high_hist", diag.high_hist) != ESP_OK) {
+    return ESP_FAIL;
+  }
+  httpd_resp_send_chunk(req, "}", 1);
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+#else
+static esp_err_t sensor_diag_handler(httpd_req_t *req) {
+  // Sin sensor físico no hay diagnósticos de lectura
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  return httpd_resp_send(req, "{\"status\": \"ESP_ERR_NOT_SUPPORTED\"}",
+                         HTTPD_RESP_USE_STRLEN);
+}
+#endif // !CONFIG_SENSOR_SOURCE_REPLAY
+
+esp_err_t sensor_service_register(httpd_handle_t server) {
+  httpd_uri_t api = {.uri = "/api/sensor",
+                     .method = HTTP_GET,
+                     .handler = sensor_api_handler,
+                     .user_ctx = NULL};
+  esp_err_t ret = httpd_register_uri_handler(server, &api);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo registrar /api/sensor: %s",
+             esp_err_to_name(ret));
+    return ret;
+  }
+
+  httpd_uri_t diag = {.uri = "/api/sensor/diag",
+                      .method = HTTP_GET,
+                      .handler = sensor_diag_handler,
+                      .user_ctx = NULL};
+  ret = httpd_register_uri_handler(server, &diag);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo registrar /api/sensor/diag: %s",
+             esp_err_to_name(ret));
+    return ret;
+  }
+
+  httpd_uri_t timing = {.uri = "/api/sensor/timing",
+                        .method = HTTP_GET,
+                        .handler = sensor_timing_handler,
+                        .user_ctx = NULL};
+  ret = httpd_register_uri_handler(server, &timing);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo registrar /api/sensor/timing: %s",
+             esp_err_to_name(ret));
+  }
+  return ret;
+}
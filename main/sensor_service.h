@@ -0,0 +1,125 @@
+/* Archivo: sensor_service.h
+ * Descripción: Servicio de lectura del sensor DHT con caché.
+ *              Una única tarea es dueña del bus del sensor: lo lee con un
+ *              periodo fijo, nunca más rápido que el intervalo mínimo del
+ *              sensor, y reintenta con espera exponencial ante errores de
+ *              CRC o timeout. Los consumidores (pantalla, Telegram, HTTP)
+ *              obtienen la última muestra válida y su antigüedad sin
+ *              provocar lecturas físicas adicionales. Las lecturas pueden
+ *              venir también de una traza CSV (CONFIG_SENSOR_SOURCE_REPLAY).
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_SENSOR_SERVICE_H_
+#define MAIN_SENSOR_SERVICE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "freertos/FreeRTOS.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+// Sin driver de GPIO: en el host solo existe la fuente de reproducción
+#include "dht_decode.h"
+typedef int gpio_num_t;
+#define GPIO_NUM_NC (-1)
+#else
+#include "dht.h"
+#endif
+
+/**
+ * @brief Muestra del sensor tal como la ven los consumidores
+ */
+typedef struct {
+  int16_t temperature; // Décimas de °C de la última lectura válida
+  int16_t humidity;    // Décimas de % de la última lectura válida
+  int64_t timestamp;   // esp_timer_get_time() de la lectura válida, 0 si no hay
+  uint32_t age_ms;     // Antigüedad de la lectura válida al consultarla
+  uint32_t seq;        // Se incrementa con cada resultado publicado
+  esp_err_t status;    // Resultado del último intento publicado
+  uint32_t failures;   // Errores consecutivos desde la última lectura válida
+} sensor_sample_t;
+
+/**
+ * @brief Regularidad de las lecturas del sensor
+ *
+ * Las lecturas van en una línea de tiempo absoluta de esp_timer (arranque
+ * + k * periodo) que no acumula deriva; el jitter es el retraso con que la
+ * tarea del sensor atiende cada instante.
+ */
+typedef struct {
+  uint32_t period_ms;
+  uint32_t ticks;    // Instantes vencidos desde el arranque
+  uint32_t overruns; // Instantes sin lectura: la tarea no llegó a tiempo
+  uint32_t retries;  // Reintentos entre dos instantes tras un error
+  uint32_t skipped;  // Instantes sin lectura: el sensor aún no podía leerse
+  uint32_t last_jitter_us;
+  uint32_t max_jitter_us;
+  uint64_t total_jitter_us; // Suma para la media (ticks - overruns)
+} sensor_timing_t;
+
+/**
+ * @brief Arranca la tarea que lee el sensor
+ *
+ * Con la fuente de reproducción se ignoran type y period_ms: el ritmo lo
+ * marca la traza.
+ *
+ * @param type Tipo de sensor
+ * @param pin GPIO del sensor
+ * @param period_ms Periodo de la línea de tiempo de lecturas; no debe ser
+ *        menor que el intervalo mínimo del sensor
+ * @return esp_err_t ESP_OK si la tarea quedó en marcha
+ */
+esp_err_t sensor_service_start(dht_sensor_type_t type, gpio_num_t pin,
+                               uint32_t period_ms);
+
+/**
+ * @brief Copia la última muestra sin tocar el bus
+ *
+ * @param[out] out Muestra en caché, con age_ms calculado al momento
+ * @return esp_err_t ESP_OK si hay una lectura válida,
+ *         ESP_ERR_INVALID_STATE si aún no la hay (out se rellena igualmente)
+ */
+esp_err_t sensor_service_get(sensor_sample_t *out);
+
+/**
+ * @brief Espera a que se publique un resultado posterior a last_seq
+ *
+ * Se publica un resultado con cada lectura válida y, tras agotar los
+ * reintentos, con cada error. Pensada para un único consumidor bloqueante
+ * (la tarea de pantalla); el resto debe usar sensor_service_get().
+ *
+ * @param[out] out Muestra publicada
+ * @param last_seq Último seq procesado por el llamador
+ * @param timeout Espera máxima
+ * @return esp_err_t ESP_OK si llegó un resultado nuevo, ESP_ERR_TIMEOUT si no
+ */
+esp_err_t sensor_service_wait(sensor_sample_t *out, uint32_t last_seq,
+                              TickType_t timeout);
+
+/**
+ * @brief Copia las estadísticas de regularidad de las lecturas
+ *
+ * @param[out] out Estadísticas
+ * @return esp_err_t ESP_OK, ESP_ERR_NOT_SUPPORTED con la fuente de
+ *         reproducción (out a cero)
+ */
+esp_err_t sensor_service_get_timing(sensor_timing_t *out);
+
+/**
+ * @brief Registra GET /api/sensor (muestra en caché), GET /api/sensor/diag
+ *        (diagnósticos de lectura del sensor) y GET /api/sensor/timing
+ *        (regularidad de las lecturas), todos en JSON
+ *
+ * @param server Servidor HTTP ya iniciado
+ * @return esp_err_t Resultado del registro del handler
+ */
+esp_err_t sensor_service_register(httpd_handle_t server);
+
+#endif /* MAIN_SENSOR_SERVICE_H_ */
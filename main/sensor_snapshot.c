@@ -0,0 +1,58 @@
+/* Archivo: sensor_snapshot.c
+ * Descripción: Publicación de la instantánea del monitor con un seqlock de
+ *              dos copias. El contador par/impar indica qué copia es estable:
+ *              el escritor incrementa el contador (los lectores pasan a la
+ *              otra copia), escribe la copia que acaba de quedar libre y
+ *              repite con la otra. Un lector copia la copia estable y solo
+ *              reintenta si el contador cambió entretanto, así nunca espera
+ *              a una escritura a medias ni impide que el escritor avance,
+ *              aunque tenga más prioridad que él.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "sensor_snapshot.h"
+
+#include <stdatomic.h>
+
+static atomic_uint s_seq = 0;
+static sensor_snapshot_t s_copies[2];
+
+// Estado del escritor; solo lo toca la tarea que publica
+static sensor_snapshot_t s_state;
+
+static void write_copy(int index) {
+  // El contador ya apunta a la otra copia: nadie empieza a leer esta
+  atomic_thread_fence(memory_order_release);
+  s_copies[index] = s_state;
+  atomic_thread_fence(memory_order_release);
+}
+
+void sensor_snapshot_publish(int16_t temperature, int16_t humidity, bool relay,
+                             int64_t timestamp) {
+  s_state.temperature = temperature;
+  s_state.humidity = humidity;
+  s_state.relay = relay;
+  s_state.timestamp = timestamp;
+  s_state.seq++;
+
+  // Impar: los lectores usan la copia 1 mientras se escribe la 0
+  atomic_fetch_add_explicit(&s_seq, 1, memory_order_relaxed);
+  write_copy(0);
+  // Par: los lectores usan la copia 0 mientras se escribe la 1
+  atomic_fetch_add_explicit(&s_seq, 1, memory_order_relaxed);
+  write_copy(1);
+}
+
+void sensor_snapshot_read(sensor_snapshot_t *out) {
+  unsigned seq;
+
+  do {
+    seq = atomic_load_explicit(&s_seq, memory_order_acquire);
+    *out = s_copies[seq & 1];
+    atomic_thread_fence(memory_order_acquire);
+  } while (atomic_load_explicit(&s_seq, memory_order_relaxed) != seq);
+}
@@ -0,0 +1,57 @@
+/* Archivo: sensor_snapshot.h
+ * Descripción: Estado publicado del monitor (última lectura y estado del
+ *              relé) como una única instantánea. Mínimos y máximos están
+ *              en rolling_stats.h.
+ *              Una sola tarea escribe; cualquier número de tareas lee una
+ *              copia coherente sin bloqueos y sin frenar al escritor.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_SENSOR_SNAPSHOT_H_
+#define MAIN_SENSOR_SNAPSHOT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Instantánea del estado del monitor
+ *
+ * Temperaturas en décimas de °C y humedades en décimas de %.
+ */
+typedef struct {
+  int16_t temperature; // Última lectura válida
+  int16_t humidity;
+  bool relay;          // Estado del relé tras la última lectura
+  int64_t timestamp;   // esp_timer_get_time() de la lectura, 0 si no hay
+  uint32_t seq;        // Número de publicaciones, 0 si aún no hay ninguna
+} sensor_snapshot_t;
+
+/**
+ * @brief Publica una lectura válida
+ *
+ * Solo puede llamarla una tarea (la que consume las lecturas del servicio de
+ * sensor). Nunca espera a los lectores.
+ *
+ * @param temperature Décimas de °C
+ * @param humidity Décimas de %
+ * @param relay Estado del relé decidido para esta lectura
+ * @param timestamp esp_timer_get_time() de la lectura
+ */
+void sensor_snapshot_publish(int16_t temperature, int16_t humidity, bool relay,
+                             int64_t timestamp);
+
+/**
+ * @brief Copia la última instantánea publicada
+ *
+ * Segura desde cualquier tarea y sin bloqueos: solo repite la copia si el
+ * escritor publicó mientras se copiaba.
+ *
+ * @param[out] out Instantánea; out->seq es 0 si aún no hay lecturas
+ */
+void sensor_snapshot_read(sensor_snapshot_t *out);
+
+#endif /* MAIN_SENSOR_SNAPSHOT_H_ */
@@ -0,0 +1,193 @@
+/* Archivo: sink.c
+ * Descripción: Colas, tareas y estadísticas de los destinos de las
+ *              lecturas. Ver sink.h.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "sink.h"
+
+#include <stdio.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+static const char *TAG = "SINK";
+
+typedef struct {
+  sink_config_t config;
+  QueueHandle_t queue;
+  sink_stats_t stats;
+} sink_t;
+
+static sink_t s_sinks[SINK_MAX];
+static int s_count = 0;
+// Protege las estadísticas (productor, tareas de destino y HTTP)
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void sink_task(void *pvParameters) {
+  sink_t *sink = pvParameters;
+  sink_event_t event;
+
+  while (1) {
+    if (xQueueReceive(sink->queue, &event, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+    esp_err_t ret = sink->config.deliver(&event, sink->config.ctx);
+    uint32_t latency = esp_timer_get_time() - event.enqueued;
+    payload_release(event.payload);
+
+    taskENTER_CRITICAL(&s_lock);
+    if (ret == ESP_OK) {
+      sink->stats.delivered++;
+    } else {
+      sink->stats.failed++;
+    }
+    sink->stats.last_latency_us = latency;
+    if (latency > sink->stats.max_latency_us) {
+      sink->stats.max_latency_us = latency;
+    }
+    sink->stats.total_latency_us += latency;
+    taskEXIT_CRITICAL(&s_lock);
+  }
+}
+
+esp_err_t sink_register(const sink_config_t *config) {
+  if (s_count == SINK_MAX || config->depth == 0) {
+    return ESP_ERR_NO_MEM;
+  }
+
+  sink_t *sink = &s_sinks[s_count];
+  sink->config = *config;
+  sink->queue = xQueueCreate(config->depth, sizeof(sink_event_t));
+  if (sink->queue == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  if (xTaskCreate(sink_task, config->name, config->stack, sink,
+                  config->priority, NULL) != pdPASS) {
+    vQueueDelete(sink->queue);
+    return ESP_ERR_NO_MEM;
+  }
+
+  // El productor solo ve el destino cuando ya está completo
+  taskENTER_CRITICAL(&s_lock);
+  s_count++;
+  taskEXIT_CRITICAL(&s_lock);
+  ESP_LOGI(TAG, "Destino %s: cola de %d", config->name, config->depth);
+  return ESP_OK;
+}
+
+void sink_publish(esp_err_t status, const sensor_snapshot_t *snap,
+                  payload_t *payload) {
+  sink_event_t event = {.status = status,
+                        .snap = *snap,
+                        .payload = payload,
+                        .enqueued = esp_timer_get_time()};
+  int count = s_count;
+
+  for (int i = 0; i < count; i++) {
+    sink_t *sink = &s_sinks[i];
+    bool dropped = false;
+
+    rolling_stats_get(sink->config.window, &event.stats);
+    // La referencia viaja con el evento; la suelta quien lo saca
+    payload_ref(payload);
+    if (xQueueSend(sink->queue, &event, 0) != pdTRUE) {
+      if (sink->config.drop == SINK_DROP_OLDEST) {
+        // Si la tarea del destino sacó uno entre medias no se descarta
+        // nada; solo hay un productor: tras sacar uno siempre hay sitio
+        sink_event_t oldest;
+        if (xQueueReceive(sink->queue, &oldest, 0) == pdTRUE) {
+          payload_release(oldest.payload);
+          dropped = true;
+        }
+        xQueueSend(sink->queue, &event, 0);
+      } else {
+        payload_release(payload);
+        dropped = true;
+      }
+    }
+    uint8_t depth = uxQueueMessagesWaiting(sink->queue);
+
+    taskENTER_CRITICAL(&s_lock);
+    if (dropped) {
+      sink->stats.dropped++;
+    }
+    if (!dropped || sink->config.drop == SINK_DROP_OLDEST) {
+      sink->stats.enqueued++;
+    }
+    if (depth > sink->stats.max_depth) {
+      sink->stats.max_depth = depth;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+  }
+}
+
+esp_err_t sink_get_stats(int index, const char **name, sink_stats_t *stats) {
+  if (index < 0 || index >= s_count) {
+    return ESP_ERR_NOT_FOUND;
+  }
+  sink_t *sink = &s_sinks[index];
+
+  taskENTER_CRITICAL(&s_lock);
+  *stats = sink->stats;
+  taskEXIT_CRITICAL(&s_lock);
+  stats->depth = uxQueueMessagesWaiting(sink->queue);
+  *name = sink->config.name;
+  return ESP_OK;
+}
+
+/**
+ * @brief Devuelve las estadísticas de todos los destinos en JSON
+ *
+ * Un objeto por destino, enviado por trozos desde un buffer de pila.
+ */
+static esp_err_t sinks_handler(httpd_req_t *req) {
+  char buf[256];
+  const char *name;
+  sink_stats_t stats;
+
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+  if (httpd_resp_send_chunk(req, "[", 1) != ESP_OK) {
+    return ESP_FAIL;
+  }
+  for (int i = 0; sink_get_stats(i, &name, &stats) == ESP_OK; i++) {
+    uint32_t done = stats.delivered + stats.failed;
+    int len = snprintf(
+        buf, sizeof(buf),
+        "%s{\"name\": \"%s\", \"enqueued\": %lu, \"dropped\": %lu, "
+        "\"delivered\": %lu, \"failed\": %lu, \"depth\": %u, "
+        "\"max_depth\": %u, \"last_latency_us\": %lu, "
+        "\"avg_latency_us\": %lu, \"max_latency_us\": %lu}",
+        i ? ", " : "", name, (unsigned long)stats.enqueued,
+        (unsigned long)stats.dropped, (unsigned long)stats.delivered,
+        (unsigned long)stats.failed, stats.depth, stats.max_depth,
+        (unsigned long)stats.last_latency_us,
+        (unsigned long)(done ? stats.total_latency_us / done : 0),
+        (unsigned long)stats.max_latency_us);
+    if (httpd_resp_send_chunk(req, buf, len) != ESP_OK) {
+      return ESP_FAIL;
+    }
+  }
+  httpd_resp_send_chunk(req, "]", 1);
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+esp_err_t sink_register_http(httpd_handle_t server) {
+  httpd_uri_t uri = {.uri = "/api/sinks",
+                     .method = HTTP_GET,
+                     .handler = sinks_handler,
+                     .user_ctx = NULL};
+  esp_err_t ret = httpd_register_uri_handler(server, &uri);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo registrar /api/sinks: %s", esp_err_to_name(ret));
+  }
+  return ret;
+}
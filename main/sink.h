@@ -0,0 +1,128 @@
+/* Archivo: sink.h
+ * Descripción: Reparto de cada resultado del sensor a los destinos
+ *              (pantalla, MQTT, WebSocket, Telegram...). Cada destino tiene
+ *              su propia cola acotada, su política de descarte y su tarea,
+ *              así un destino lento (red caída, HTTPS) no retrasa la
+ *              siguiente lectura ni a los demás destinos. El productor nunca
+ *              espera: si la cola está llena se descarta según la política.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_SINK_H_
+#define MAIN_SINK_H_
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "freertos/FreeRTOS.h"
+#include "payload.h"
+#include "rolling_stats.h"
+#include "sensor_snapshot.h"
+
+#define SINK_MAX 6
+
+/**
+ * @brief Evento entregado a los destinos
+ */
+typedef struct {
+  esp_err_t status;       // ESP_OK o error de lectura (snap es el anterior)
+  sensor_snapshot_t snap; // Estado publicado tras el resultado
+  rolling_stats_t stats;  // Ventana config.window al encolarlo
+  payload_t *payload;     // Lectura ya codificada, NULL si hubo error
+  int64_t enqueued;       // esp_timer_get_time() al encolarlo
+} sink_event_t;
+
+/**
+ * @brief Qué hacer con un evento nuevo si la cola está llena
+ */
+typedef enum {
+  SINK_DROP_OLDEST, // Descarta el más antiguo: importa el último estado
+  SINK_DROP_NEWEST, // Descarta el nuevo: se conserva lo ya encolado
+} sink_drop_t;
+
+/**
+ * @brief Entrega un evento al destino
+ *
+ * Se ejecuta en la tarea del destino; puede bloquear. La referencia de
+ * event->payload es de la tarea: se suelta al volver.
+ *
+ * @return esp_err_t ESP_OK si se entregó
+ */
+typedef esp_err_t (*sink_deliver_t)(const sink_event_t *event, void *ctx);
+
+/**
+ * @brief Configuración de un destino
+ */
+typedef struct {
+  const char *name;       // Nombre para logs y estadísticas
+  sink_deliver_t deliver; // Función de entrega
+  void *ctx;              // Argumento de deliver
+  uint8_t depth;          // Tamaño de la cola
+  sink_drop_t drop;       // Política con la cola llena
+  uint32_t stack;         // Pila de la tarea
+  UBaseType_t priority;   // Prioridad de la tarea
+  // Ventana de estadísticas de cada evento (ROLLING_SHORT por defecto)
+  rolling_window_t window;
+} sink_config_t;
+
+/**
+ * @brief Estadísticas de un destino
+ */
+typedef struct {
+  uint32_t enqueued;       // Eventos aceptados en la cola
+  uint32_t dropped;        // Eventos descartados por cola llena
+  uint32_t delivered;      // Entregas con éxito
+  uint32_t failed;         // Entregas con error
+  uint8_t depth;           // Eventos en cola ahora
+  uint8_t max_depth;       // Máximo de eventos en cola
+  uint32_t last_latency_us; // Desde que se encoló hasta que se entregó
+  uint32_t max_latency_us;
+  uint64_t total_latency_us; // Suma para la media (delivered + failed)
+} sink_stats_t;
+
+/**
+ * @brief Añade un destino y arranca su tarea
+ *
+ * @param config Configuración (se copia)
+ * @return esp_err_t ESP_OK, ESP_ERR_NO_MEM si no caben más destinos o no
+ *         se pudo crear la cola o la tarea
+ */
+esp_err_t sink_register(const sink_config_t *config);
+
+/**
+ * @brief Encola un evento en todos los destinos sin esperar
+ *
+ * Cada destino recibe las estadísticas de la ventana a la que se suscribió
+ * y una referencia propia a payload mientras el evento está en su cola.
+ *
+ * @param status Resultado de la lectura
+ * @param snap Estado publicado
+ * @param payload Lectura codificada o NULL; el llamante conserva la suya
+ */
+void sink_publish(esp_err_t status, const sensor_snapshot_t *snap,
+                  payload_t *payload);
+
+/**
+ * @brief Copia las estadísticas de un destino
+ *
+ * @param index Índice de registro, desde 0
+ * @param[out] name Nombre del destino
+ * @param[out] stats Estadísticas
+ * @return esp_err_t ESP_OK, ESP_ERR_NOT_FOUND si el índice no existe
+ */
+esp_err_t sink_get_stats(int index, const char **name, sink_stats_t *stats);
+
+/**
+ * @brief Registra GET /api/sinks (estadísticas de los destinos en JSON)
+ *
+ * @param server Servidor HTTP ya iniciado
+ * @return esp_err_t Resultado del registro del handler
+ */
+esp_err_t sink_register_http(httpd_handle_t server);
+
+#endif /* MAIN_SINK_H_ */
@@ -0,0 +1,249 @@
+/* Archivo: sys_metrics.c
+ * Descripción: Muestreo periódico de pilas, CPU y heap. Ver sys_metrics.h.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "sys_metrics.h"
+
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "json_writer.h"
+
+#if !CONFIG_FREERTOS_USE_TRACE_FACILITY
+#error "sys_metrics necesita CONFIG_FREERTOS_USE_TRACE_FACILITY"
+#endif
+
+#define PERIOD_MS (CONFIG_SYS_METRICS_PERIOD_S * 1000)
+
+// Documento para el callback: cabecera y unas 60 B por tarea
+#define DOC_SIZE (160 + SYS_METRICS_MAX_TASKS * 64)
+
+static const char *TAG = "SYS_METRICS";
+
+static sys_metrics_t s_metrics;
+static bool s_valid;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static sys_metrics_cb_t s_cb;
+static void *s_cb_ctx;
+
+// Solo los usa la tarea de métricas
+static TaskStatus_t s_status[SYS_METRICS_MAX_TASKS];
+static sys_metrics_t s_sample;
+static char s_doc[DOC_SIZE];
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+// Contadores de la muestra anterior para calcular el uso en el intervalo
+static TaskHandle_t s_prev_handle[SYS_METRICS_MAX_TASKS];
+static configRUN_TIME_COUNTER_TYPE s_prev_counter[SYS_METRICS_MAX_TASKS];
+static UBaseType_t s_prev_count;
+static configRUN_TIME_COUNTER_TYPE s_prev_total;
+
+// Contador de la muestra anterior; 0 para las tareas nuevas
+static configRUN_TIME_COUNTER_TYPE prev_counter(TaskHandle_t handle) {
+  for (UBaseType_t i = 0; i < s_prev_count; i++) {
+    if (s_prev_handle[i] == handle) {
+      return s_prev_counter[i];
+    }
+  }
+  return 0;
+}
+#endif
+
+static bool sample(sys_metrics_t *m) {
+  configRUN_TIME_COUNTER_TYPE total = 0;
+  UBaseType_t n =
+      uxTaskGetSystemState(s_status, SYS_METRICS_MAX_TASKS, &total);
+
+  if (n == 0) {
+    ESP_LOGW(TAG, "Hay %u tareas, más que SYS_METRICS_MAX_TASKS",
+             (unsigned)uxTaskGetNumberOfTasks());
+    return false;
+  }
+
+  m->uptime_s = esp_timer_get_time() / 1000000;
+  m->heap_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  m->heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+  m->heap_largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  m->heap_total = heap_caps_get_total_size(MALLOC_CAP_8BIT);
+  m->task_count = n;
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+  // Resta sin signo: sobrevive a una vuelta del contador en el intervalo
+  configRUN_TIME_COUNTER_TYPE elapsed = total - s_prev_total;
+#endif
+  for (UBaseType_t i = 0; i < n; i++) {
+    const TaskStatus_t *st = &s_status[i];
+    sys_task_metrics_t *t = &m->tasks[i];
+
+    strlcpy(t->name, st->pcTaskName, sizeof(t->name));
+    // En ESP-IDF la pila se cuenta en bytes
+    t->stack_free = st->usStackHighWaterMark;
+    t->priority = st->uxCurrentPriority;
+    t->cpu_permille = 0;
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    configRUN_TIME_COUNTER_TYPE used =
+        st->ulRunTimeCounter - prev_counter(st->xHandle);
+    if (elapsed > 0) {
+      t->cpu_permille = (uint64_t)used * 1000 / elapsed;
+    }
+#endif
+  }
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+  for (UBaseType_t i = 0; i < n; i++) {
+    s_prev_handle[i] = s_status[i].xHandle;
+    s_prev_counter[i] = s_status[i].ulRunTimeCounter;
+  }
+  s_prev_count = n;
+  s_prev_total = total;
+#endif
+  return true;
+}
+
+static void write_head(json_writer_t *j, const sys_metrics_t *m) {
+  json_object_begin(j);
+  json_key(j, "uptime_s");
+  json_uint(j, m->uptime_s);
+  json_key(j, "heap");
+  json_object_begin(j);
+  json_key(j, "free");
+  json_uint(j, m->heap_free);
+  json_key(j, "min_free");
+  json_uint(j, m->heap_min_free);
+  json_key(j, "largest_block");
+  json_uint(j, m->heap_largest_block);
+  json_key(j, "total");
+  json_uint(j, m->heap_total);
+  json_object_end(j);
+  json_key(j, "tasks");
+  json_object_begin(j);
+}
+
+static void write_task(json_writer_t *j, const sys_task_metrics_t *t) {
+  json_key(j, t->name);
+  json_object_begin(j);
+  json_key(j, "stack_free");
+  json_uint(j, t->stack_free);
+  json_key(j, "cpu");
+  json_deci(j, t->cpu_permille);
+  json_key(j, "prio");
+  json_uint(j, t->priority);
+  json_object_end(j);
+}
+
+static void write_tail(json_writer_t *j) {
+  json_object_end(j);
+  json_object_end(j);
+}
+
+static void sys_metrics_task(void *arg) {
+  TickType_t last_wake = xTaskGetTickCount();
+
+  for (;;) {
+    if (sample(&s_sample)) {
+      taskENTER_CRITICAL(&s_lock);
+      s_metrics = s_sample;
+      s_valid = true;
+      taskEXIT_CRITICAL(&s_lock);
+
+      if (s_cb != NULL) {
+        json_writer_t j;
+        json_init(&j, s_doc, sizeof(s_doc));
+        write_head(&j, &s_sample);
+        for (int i = 0; i < s_sample.task_count; i++) {
+          write_task(&j, &s_sample.tasks[i]);
+        }
+        write_tail(&j);
+        if (j.out.overflow) {
+          ESP_LOGW(TAG, "Documento truncado en %u bytes", (unsigned)DOC_SIZE);
+        } else {
+          s_cb(s_doc, j.out.len, s_cb_ctx);
+        }
+      }
+    }
+    xTaskDelayUntil(&last_wake, pdMS_TO_TICKS(PERIOD_MS));
+  }
+}
+
+esp_err_t sys_metrics_start(sys_metrics_cb_t cb, void *ctx) {
+  s_cb = cb;
+  s_cb_ctx = ctx;
+  // Prioridad mínima sobre la tarea idle: la muestra no corre prisa
+  if (xTaskCreate(sys_metrics_task, "sys_metrics", 3072, NULL, 1, NULL) !=
+      pdPASS) {
+    ESP_LOGE(TAG, "No se pudo crear la tarea de métricas");
+    return ESP_ERR_NO_MEM;
+  }
+  return ESP_OK;
+}
+
+esp_err_t sys_metrics_get(sys_metrics_t *out) {
+  taskENTER_CRITICAL(&s_lock);
+  bool valid = s_valid;
+  if (valid) {
+    *out = s_metrics;
+  }
+  taskEXIT_CRITICAL(&s_lock);
+  return valid ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+/**
+ * @brief Devuelve la última muestra en JSON
+ *
+ * La muestra (unos 500 bytes) se copia a un buffer estático, no a la
+ * pila: el servidor atiende las peticiones de una en una. El JSON sale por
+ * trozos de un buffer de pila.
+ */
+static esp_err_t system_handler(httpd_req_t *req) {
+  static sys_metrics_t m;
+  char buf[384];
+  json_writer_t j;
+
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+  if (sys_metrics_get(&m) != ESP_OK) {
+    return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND,
+                               "Todavía no hay métricas");
+  }
+
+  json_init(&j, buf, sizeof(buf));
+  write_head(&j, &m);
+  for (int i = 0; i < m.task_count; i++) {
+    // Una tarea ocupa menos de 100 bytes
+    if (j.out.len > sizeof(buf) - 100) {
+      if (httpd_resp_send_chunk(req, buf, j.out.len) != ESP_OK) {
+        return ESP_FAIL;
+      }
+      fmt_init(&j.out, buf, sizeof(buf));
+    }
+    write_task(&j, &m.tasks[i]);
+  }
+  write_tail(&j);
+  if (httpd_resp_send_chunk(req, buf, j.out.len) != ESP_OK) {
+    return ESP_FAIL;
+  }
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+esp_err_t sys_metrics_register_http(httpd_handle_t server) {
+  httpd_uri_t uri = {.uri = "/api/system",
+                     .method = HTTP_GET,
+                     .handler = system_handler,
+                     .user_ctx = NULL};
+  esp_err_t ret = httpd_register_uri_handler(server, &uri);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "No se pudo registrar /api/system: %s",
+             esp_err_to_name(ret));
+  }
+  return ret;
+}
@@ -0,0 +1,96 @@
+/* Archivo: sys_metrics.h
+ * Descripción: Métricas del sistema para dimensionar pilas y memoria y ver
+ *              fugas: por tarea, el mínimo de pila libre que ha tenido
+ *              (high-water mark) y su uso de CPU; del heap, la memoria
+ *              libre, el mínimo histórico y el mayor bloque libre (si es
+ *              mucho menor que la libre, el heap está fragmentado).
+ *
+ *              Una tarea de baja prioridad toma una muestra cada
+ *              CONFIG_SYS_METRICS_PERIOD_S; el uso de CPU es el del
+ *              intervalo entre dos muestras. Necesita
+ *              CONFIG_FREERTOS_USE_TRACE_FACILITY y, para la CPU,
+ *              CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS (sdkconfig.defaults).
+ *
+ *              Documento JSON (GET /api/system y MQTT):
+ *
+ *                {"uptime_s": 3600, "heap": {"free": 123456,
+ *                 "min_free": 100000, "largest_block": 65536, "total":
+ *                 250000}, "tasks": {"sensor_task": {"stack_free": 1200,
+ *                 "cpu": 0.4, "prio": 6}, ...}}
+ *
+ *              stack_free en bytes y cpu en % con un decimal.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_SYS_METRICS_H_
+#define MAIN_SYS_METRICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "freertos/FreeRTOS.h"
+
+#define SYS_METRICS_MAX_TASKS 24
+
+/**
+ * @brief Métricas de una tarea
+ */
+typedef struct {
+  char name[configMAX_TASK_NAME_LEN];
+  uint32_t stack_free;  // Mínimo de pila libre desde que arrancó, en bytes
+  uint16_t cpu_permille; // Uso de CPU en el último intervalo, en ‰
+  uint8_t priority;
+} sys_task_metrics_t;
+
+/**
+ * @brief Muestra de las métricas del sistema
+ */
+typedef struct {
+  uint32_t uptime_s;
+  uint32_t heap_free;
+  uint32_t heap_min_free;
+  uint32_t heap_largest_block;
+  uint32_t heap_total;
+  uint8_t task_count;
+  sys_task_metrics_t tasks[SYS_METRICS_MAX_TASKS];
+} sys_metrics_t;
+
+/**
+ * @brief Se llama tras cada muestra desde la tarea de métricas
+ *
+ * @param json Documento JSON de la muestra
+ * @param len Longitud de json
+ */
+typedef void (*sys_metrics_cb_t)(const char *json, size_t len, void *ctx);
+
+/**
+ * @brief Arranca la tarea que toma las muestras
+ *
+ * @param cb Llamada tras cada muestra (p. ej. para publicarla), nullable
+ * @param ctx Argumento de cb
+ * @return esp_err_t ESP_OK, ESP_ERR_NO_MEM si no se pudo crear la tarea
+ */
+esp_err_t sys_metrics_start(sys_metrics_cb_t cb, void *ctx);
+
+/**
+ * @brief Copia la última muestra
+ *
+ * @return esp_err_t ESP_OK, ESP_ERR_INVALID_STATE si aún no hay muestra
+ */
+esp_err_t sys_metrics_get(sys_metrics_t *out);
+
+/**
+ * @brief Registra GET /api/system (la última muestra en JSON)
+ *
+ * @param server Servidor HTTP ya iniciado
+ * @return esp_err_t Resultado del registro del handler
+ */
+esp_err_t sys_metrics_register_http(httpd_handle_t server);
+
+#endif /* MAIN_SYS_METRICS_H_ */
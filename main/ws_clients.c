@@ -0,0 +1,337 @@
+/* Archivo: ws_clients.c
+ * Descripción: Clientes del WebSocket de lecturas y sus suscripciones. Ver
+ *              ws_clients.h.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include "ws_clients.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "json_writer.h"
+
+// Tantos como sockets abre el servidor HTTP por defecto
+#define WS_CLIENTS_MAX 7
+#define INTERVAL_MAX_MS 3600000
+// Documento con parte de los campos; el completo ocupa menos de 100 bytes
+#define DOC_MAX 128
+#define REPLY_MAX 128
+
+typedef struct {
+  payload_format_t format;
+  uint32_t fields;      // Máscara de PAYLOAD_FIELD()
+  uint32_t interval_ms; // 0: todas las lecturas
+} ws_sub_t;
+
+typedef struct {
+  int fd; // -1 si el hueco está libre
+  ws_sub_t sub;
+  int64_t last_sent; // esp_timer_get_time() del último envío, 0 si ninguno
+} ws_client_t;
+
+static const char *TAG = "WS_CLIENTS";
+
+static const ws_sub_t s_default_sub = {
+    .format = PAYLOAD_JSON, .fields = PAYLOAD_ALL_FIELDS, .interval_ms = 0};
+
+// Protegidos por s_lock (handlers HTTP, close_fn y destino ws)
+static ws_client_t s_clients[WS_CLIENTS_MAX] = {
+    [0 ... WS_CLIENTS_MAX - 1] = {.fd = -1}};
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static esp_err_t parse_fields(const char *list, uint32_t *fields) {
+  uint32_t mask = 0;
+
+  if (strcmp(list, "all") == 0) {
+    *fields = PAYLOAD_ALL_FIELDS;
+    return ESP_OK;
+  }
+  while (*list != '\0') {
+    size_t n = strcspn(list, ",");
+    int field = 0;
+    while (field < PAYLOAD_FIELDS &&
+           (strlen(payload_field_name(field)) != n ||
+            strncmp(list, payload_field_name(field), n) != 0)) {
+      field++;
+    }
+    if (field == PAYLOAD_FIELDS) {
+      return ESP_ERR_INVALID_ARG;
+    }
+    mask |= PAYLOAD_FIELD(field);
+    list += n;
+    if (*list == ',') {
+      list++;
+    }
+  }
+  if (mask == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  *fields = mask;
+  return ESP_OK;
+}
+
+/**
+ * @brief Aplica a sub los parámetros de query que aparecen
+ *
+ * @param[out] bad Qué parámetro no es válido si no devuelve ESP_OK
+ * @return esp_err_t ESP_OK, ESP_ERR_INVALID_ARG sin tocar sub
+ */
+static esp_err_t parse_sub(const char *query, ws_sub_t *sub,
+                           const char **bad) {
+  ws_sub_t next = *sub;
+  char value[64];
+  esp_err_t ret;
+
+  ret = httpd_query_key_value(query, "format", value, sizeof(value));
+  if (ret == ESP_OK && strcmp(value, "json") == 0) {
+    next.format = PAYLOAD_JSON;
+  } else if (ret == ESP_OK && strcmp(value, "cbor") == 0) {
+    next.format = PAYLOAD_CBOR;
+  } else if (ret != ESP_ERR_NOT_FOUND) {
+    *bad = "format no válido";
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  ret = httpd_query_key_value(query, "fields", value, sizeof(value));
+  if (ret != ESP_ERR_NOT_FOUND &&
+      (ret != ESP_OK || parse_fields(value, &next.fields) != ESP_OK)) {
+    *bad = "fields no válido";
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  ret = httpd_query_key_value(query, "interval_ms", value, sizeof(value));
+  if (ret != ESP_ERR_NOT_FOUND) {
+    char *end;
+    unsigned long ms = strtoul(value, &end, 10);
+    if (ret != ESP_OK || end == value || *end != '\0' ||
+        ms > INTERVAL_MAX_MS) {
+      *bad = "interval_ms no válido";
+      return ESP_ERR_INVALID_ARG;
+    }
+    next.interval_ms = ms;
+  }
+
+  *sub = next;
+  return ESP_OK;
+}
+
+// Hueco del cliente fd, o uno libre si no está; -1 si no hay
+static int find_slot(int fd) {
+  int free_slot = -1;
+
+  for (int i = 0; i < WS_CLIENTS_MAX; i++) {
+    if (s_clients[i].fd == fd) {
+      return i;
+    }
+    if (s_clients[i].fd < 0 && free_slot < 0) {
+      free_slot = i;
+    }
+  }
+  return free_slot;
+}
+
+esp_err_t ws_clients_open(httpd_req_t *req) {
+  int fd = httpd_req_to_sockfd(req);
+  ws_sub_t sub = s_default_sub;
+  char query[WS_COMMAND_MAX + 1];
+  const char *bad;
+  esp_err_t ret = ESP_ERR_NO_MEM;
+
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      parse_sub(query, &sub, &bad) != ESP_OK) {
+    ESP_LOGW(TAG, "Cliente %d: %s, suscripción por defecto", fd, bad);
+  }
+
+  taskENTER_CRITICAL(&s_lock);
+  int i = find_slot(fd);
+  if (i >= 0) {
+    s_clients[i] = (ws_client_t){.fd = fd, .sub = sub};
+    ret = ESP_OK;
+  }
+  taskEXIT_CRITICAL(&s_lock);
+
+  if (ret == ESP_OK) {
+    ESP_LOGI(TAG, "Cliente %d conectado (%s, cada %lu ms)", fd,
+             sub.format == PAYLOAD_CBOR ? "CBOR" : "JSON",
+             (unsigned long)sub.interval_ms);
+  } else {
+    ESP_LOGW(TAG, "Sin hueco para el cliente %d", fd);
+  }
+  return ret;
+}
+
+static size_t write_reply(char *buf, size_t size, const ws_sub_t *sub,
+                          const char *error) {
+  json_writer_t j;
+
+  json_init(&j, buf, size);
+  json_object_begin(&j);
+  if (error != NULL) {
+    json_key(&j, "error");
+    json_string(&j, error);
+  } else {
+    json_key(&j, "format");
+    json_string(&j, sub->format == PAYLOAD_CBOR ? "cbor" : "json");
+    json_key(&j, "fields");
+    json_array_begin(&j);
+    for (int i = 0; i < PAYLOAD_FIELDS; i++) {
+      if (sub->fields & PAYLOAD_FIELD(i)) {
+        json_string(&j, payload_field_name(i));
+      }
+    }
+    json_array_end(&j);
+    json_key(&j, "interval_ms");
+    json_uint(&j, sub->interval_ms);
+  }
+  json_object_end(&j);
+  return j.out.len;
+}
+
+esp_err_t ws_clients_command(httpd_req_t *req, const char *text, size_t len) {
+  int fd = httpd_req_to_sockfd(req);
+  char query[WS_COMMAND_MAX + 1];
+  char reply[REPLY_MAX];
+  const char *error = NULL;
+  const char *bad = NULL;
+  ws_sub_t sub = s_default_sub;
+  bool found = false;
+
+  if (len > WS_COMMAND_MAX) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  memcpy(query, text, len);
+  query[len] = '\0';
+
+  taskENTER_CRITICAL(&s_lock);
+  int i = find_slot(fd);
+  if (i >= 0 && s_clients[i].fd == fd) {
+    sub = s_clients[i].sub;
+    found = true;
+  }
+  taskEXIT_CRITICAL(&s_lock);
+
+  if (!found) {
+    error = "sin hueco para más clientes";
+  } else if (parse_sub(query, &sub, &bad) != ESP_OK) {
+    error = bad;
+  } else {
+    // Si el cliente se ha ido mientras tanto, su hueco ya no es suyo
+    taskENTER_CRITICAL(&s_lock);
+    if (s_clients[i].fd == fd) {
+      s_clients[i].sub = sub;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+  }
+
+  if (error != NULL) {
+    ESP_LOGW(TAG, "Comando del cliente %d no válido: %s", fd, error);
+  } else {
+    ESP_LOGI(TAG, "Cliente %d suscrito (%s, cada %lu ms)", fd,
+             sub.format == PAYLOAD_CBOR ? "CBOR" : "JSON",
+             (unsigned long)sub.interval_ms);
+  }
+  httpd_ws_frame_t ws_pkt = {
+      .payload = (uint8_t *)reply,
+      .len = write_reply(reply, sizeof(reply), &sub, error),
+      .type = HTTPD_WS_TYPE_TEXT};
+  return httpd_ws_send_frame(req, &ws_pkt);
+}
+
+void ws_clients_on_close(int fd) {
+  taskENTER_CRITICAL(&s_lock);
+  for (int i = 0; i < WS_CLIENTS_MAX; i++) {
+    if (s_clients[i].fd == fd) {
+      s_clients[i].fd = -1;
+    }
+  }
+  taskEXIT_CRITICAL(&s_lock);
+}
+
+// Vence un poco antes para que el retraso de una lectura no salte a la
+// siguiente: con lecturas cada 5 s e interval_ms 10000 llegan 1 de cada 2
+static bool due(const ws_client_t *c, int64_t now) {
+  int64_t interval_us = (int64_t)c->sub.interval_ms * 1000;
+
+  return c->last_sent == 0 ||
+         now - c->last_sent >= interval_us - interval_us / 8;
+}
+
+esp_err_t ws_clients_send(httpd_handle_t server, const payload_t *p) {
+  ws_client_t clients[WS_CLIENTS_MAX];
+  int count = 0;
+  int64_t now = esp_timer_get_time();
+  esp_err_t result = ESP_OK;
+  // Último documento parcial, reutilizable por clientes con la misma
+  // suscripción
+  char doc[DOC_MAX];
+  size_t doc_len = 0;
+  payload_format_t doc_format = PAYLOAD_JSON;
+  uint32_t doc_fields = 0;
+
+  // El envío cuenta aunque falle: un cliente lento no recibe más por ello
+  taskENTER_CRITICAL(&s_lock);
+  for (int i = 0; i < WS_CLIENTS_MAX; i++) {
+    if (s_clients[i].fd >= 0 && due(&s_clients[i], now)) {
+      s_clients[i].last_sent = now;
+      clients[count++] = s_clients[i];
+    }
+  }
+  taskEXIT_CRITICAL(&s_lock);
+
+  for (int i = 0; i < count; i++) {
+    const ws_sub_t *sub = &clients[i].sub;
+    if (httpd_ws_get_fd_info(server, clients[i].fd) !=
+        HTTPD_WS_CLIENT_WEBSOCKET) {
+      ESP_LOGD(TAG, "Cliente %d desconectado", clients[i].fd);
+      ws_clients_on_close(clients[i].fd);
+      continue;
+    }
+    size_t len;
+    const char *data;
+    if (sub->fields == PAYLOAD_ALL_FIELDS) {
+      data = payload_data(p, sub->format, &len);
+    } else {
+      if (doc_fields != sub->fields || doc_format != sub->format) {
+        doc_len = payload_encode_fields(p, sub->format, sub->fields, doc,
+                                        sizeof(doc));
+        doc_fields = sub->fields;
+        doc_format = sub->format;
+      }
+      data = doc;
+      len = doc_len;
+    }
+    httpd_ws_frame_t ws_pkt = {
+        .payload = (uint8_t *)data,
+        .len = len,
+        .type = sub->format == PAYLOAD_CBOR ? HTTPD_WS_TYPE_BINARY
+                                            : HTTPD_WS_TYPE_TEXT};
+    esp_err_t ret = httpd_ws_send_frame_async(server, clients[i].fd, &ws_pkt);
+    if (ret != ESP_OK) {
+      ESP_LOGW(TAG, "Error enviando a cliente %d: %s", clients[i].fd,
+               esp_err_to_name(ret));
+      result = ret;
+    }
+  }
+  return result;
+}
+
+int ws_clients_count(void) {
+  int count = 0;
+
+  taskENTER_CRITICAL(&s_lock);
+  for (int i = 0; i < WS_CLIENTS_MAX; i++) {
+    if (s_clients[i].fd >= 0) {
+      count++;
+    }
+  }
+  taskEXIT_CRITICAL(&s_lock);
+  return count;
+}
@@ -0,0 +1,95 @@
+/* Archivo: ws_clients.h
+ * Descripción: Clientes del WebSocket de lecturas (/ws) y la suscripción
+ *              de cada uno: formato, campos y ritmo máximo. Se elige al
+ *              conectar con los parámetros de la URL y se cambia en
+ *              cualquier momento enviando un frame de texto con la misma
+ *              sintaxis:
+ *
+ *                format=json|cbor      JSON en frames de texto (por
+ *                                      defecto) o CBOR en frames binarios
+ *                fields=temp,hum,...   Campos de payload.h o "all" (por
+ *                                      defecto)
+ *                interval_ms=N         Mínimo entre dos lecturas al
+ *                                      cliente; 0 (por defecto), todas
+ *
+ *              p. ej. /ws?format=cbor&fields=temp,hum&interval_ms=60000
+ *              o el frame "fields=all&interval_ms=0". Los parámetros que
+ *              faltan no cambian. Cada comando se responde con un frame de
+ *              texto con la suscripción resultante,
+ *
+ *                {"format": "cbor", "fields": ["temp", "hum"],
+ *                 "interval_ms": 60000}
+ *
+ *              o con {"error": "..."} si no es válido, y entonces no cambia
+ *              nada.
+ *
+ *              Cada cliente recibe solo lo que pidió: un panel en un móvil
+ *              lento puede pedir una lectura por minuto mientras un
+ *              colector recibe todas. Con todos los campos se envían los
+ *              bytes ya codificados de la lectura; con menos se codifican
+ *              por cliente en un buffer de pila.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#ifndef MAIN_WS_CLIENTS_H_
+#define MAIN_WS_CLIENTS_H_
+
+#include <stddef.h>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "payload.h"
+
+// Longitud máxima de un comando; uno mayor cierra la conexión
+#define WS_COMMAND_MAX 128
+
+/**
+ * @brief Da de alta al cliente del handshake de /ws con la suscripción de
+ * la URL
+ *
+ * Llamar desde el handler de /ws cuando req->method es HTTP_GET.
+ *
+ * @return esp_err_t ESP_OK, ESP_ERR_NO_MEM si no caben más clientes
+ */
+esp_err_t ws_clients_open(httpd_req_t *req);
+
+/**
+ * @brief Aplica un comando de suscripción recibido en un frame de texto y
+ * responde al cliente
+ *
+ * Llamar desde el handler de /ws.
+ *
+ * @param text Comando, sin terminar en '\0'
+ * @param len Longitud de text, como mucho WS_COMMAND_MAX
+ * @return esp_err_t Resultado del envío de la respuesta
+ */
+esp_err_t ws_clients_command(httpd_req_t *req, const char *text, size_t len);
+
+/**
+ * @brief Olvida un cliente cuyo socket se ha cerrado
+ *
+ * Debe llamarse desde el close_fn del servidor HTTP.
+ */
+void ws_clients_on_close(int fd);
+
+/**
+ * @brief Envía una lectura a cada cliente según su suscripción
+ *
+ * Se salta a los clientes que recibieron la anterior hace menos de su
+ * interval_ms. Los clientes cuyo socket ya no es un WebSocket se dan de
+ * baja.
+ *
+ * @return esp_err_t ESP_OK, o el último error de envío a un cliente
+ */
+esp_err_t ws_clients_send(httpd_handle_t server, const payload_t *p);
+
+/**
+ * @brief Número de clientes dados de alta
+ */
+int ws_clients_count(void);
+
+#endif /* MAIN_WS_CLIENTS_H_ */
@@ -8,6 +8,10 @@
  *  - Reconexión automática con backoff exponencial
  *  - Actualización de temperatura y humedad en tiempo real
  *  - Indicador visual del estado de conexión
+ *  - Lecturas en CBOR (por defecto) o JSON; con ?format=json en la URL de la
+ *    página se piden en JSON
+ *  - ?interval_ms= en la URL de la página se pasa a /ws para recibir menos
+ *    lecturas (p. ej. en un móvil lento)
  * 
  * Autor: migbertweb
  * Fecha: 21/11/2025
@@ -25,13 +29,94 @@ const limitValEl = document.getElementById('limit-val');
 // Configuración de la URL WebSocket
 // Detecta automáticamente el protocolo (ws:// o wss://) según la página
 const wsProtocol = window.location.protocol === 'https:' ? 'wss://' : 'ws://';
-const wsUrl = `${wsProtocol}${window.location.hostname}/ws`;
+// CBOR ocupa unos 20 bytes por lectura frente a unos 90 en JSON
+const pageParams = new URLSearchParams(window.location.search);
+const wsFormat = pageParams.get('format') === 'json' ? 'json' : 'cbor';
+// La página usa todos los campos; solo se puede pedir un ritmo menor
+const wsInterval = pageParams.has('interval_ms') ? `&interval_ms=${encodeURIComponent(pageParams.get('interval_ms'))}` : '';
+const wsUrl = `${wsProtocol}${window.location.hostname}/ws?format=${wsFormat}${wsInterval}`;
+
+// Claves enteras del mapa CBOR (main/payload.h); los valores van en décimas
+const cborKeys = ['temp', 'hum', 'min_t', 'max_t', 'relay', 'limit'];
 
 // Variables de estado de la conexión
 let websocket;
 let reconnectAttempts = 0;
 const maxReconnectAttempts = 5;
 
+/**
+ * Decodifica un documento CBOR (RFC 8949)
+ * Solo lo que envía el servidor: enteros, texto, listas y mapas de
+ * longitud conocida, y los valores simples false, true y null
+ * @param {ArrayBuffer} buffer - Frame binario recibido
+ * @returns {*} Valor decodificado
+ */
+function decodeCbor(buffer) {
+    const view = new DataView(buffer);
+    let pos = 0;
+
+    function readArg(info) {
+        if (info < 24) return info;
+        if (info === 24) return view.getUint8(pos++);
+        if (info === 25) { pos += 2; return view.getUint16(pos - 2); }
+        if (info === 26) { pos += 4; return view.getUint32(pos - 4); }
+        throw new Error('Longitud CBOR no soportada: ' + info);
+    }
+
+    function readItem() {
+        const initial = view.getUint8(pos++);
+        const major = initial >> 5;
+        const info = initial & 0x1f;
+
+        switch (major) {
+            case 0: return readArg(info);
+            case 1: return -1 - readArg(info);
+            case 3: {
+                const len = readArg(info);
+                const text = new TextDecoder().decode(new Uint8Array(buffer, pos, len));
+                pos += len;
+                return text;
+            }
+            case 4: {
+                const items = [];
+                for (let n = readArg(info); n > 0; n--) items.push(readItem());
+                return items;
+            }
+            case 5: {
+                const map = {};
+                for (let n = readArg(info); n > 0; n--) {
+                    const key = readItem();
+                    map[key] = readItem();
+                }
+                return map;
+            }
+            case 7:
+                if (info === 20) return false;
+                if (info === 21) return true;
+                if (info === 22) return null;
+        }
+        throw new Error('Tipo CBOR no soportado: ' + initial);
+    }
+
+    return readItem();
+}
+
+/**
+ * Convierte una lectura en CBOR al mismo objeto que el JSON
+ * @param {ArrayBuffer} buffer - Frame binario recibido
+ * @returns {Object} {temp, hum, min_t, max_t, relay, limit}
+ */
+function readingFromCbor(buffer) {
+    const map = decodeCbor(buffer);
+    const data = {};
+    cborKeys.forEach((name, key) => {
+        if (map[key] !== undefined) {
+            data[name] = name === 'relay' ? map[key] : map[key] / 10;
+        }
+    });
+    return data;
+}
+
 /**
  * Inicializa y configura la conexión WebSocket
  * Maneja todos los eventos de la conexión: open, close, error, message
@@ -39,6 +124,7 @@ const maxReconnectAttempts = 5;
 function initWebSocket() {
     console.log('Intentando abrir conexión WebSocket a:', wsUrl);
     websocket = new WebSocket(wsUrl);
+    websocket.binaryType = 'arraybuffer';
 
     /**
      * Evento: Conexión establecida exitosamente
@@ -82,14 +168,16 @@ function initWebSocket() {
 
     /**
      * Evento: Mensaje recibido del servidor
-     * Parsea el JSON y actualiza los valores de temperatura y humedad en la interfaz
+     * Decodifica la lectura (texto JSON o binario CBOR) y actualiza los valores de
+     * temperatura y humedad en la interfaz
      * Formato esperado: {"temp": 25.5, "hum": 65.0}
      */
     websocket.onmessage = (event) => {
-        console.log('Mensaje recibido:', event.data);
         try {
-            // Parsear el JSON recibido
-            const data = JSON.parse(event.data);
+            const data = typeof event.data === 'string'
+                ? JSON.parse(event.data)
+                : readingFromCbor(event.data);
+            console.log('Lectura recibida:', data);
             
             // Actualizar temperatura si está presente
             if (data.temp !== undefined) {
@@ -117,7 +205,7 @@ function initWebSocket() {
                 }
             }
         } catch (e) {
-            console.error('Error al parsear JSON:', e);
+            console.error('Error al decodificar la lectura:', e);
         }
     };
 }
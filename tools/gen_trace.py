@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+# Archivo: gen_trace.py
+# Descripción: Genera una traza CSV sintética para la fuente de reproducción
+#              del servicio de sensor (formato en main/sensor_replay.h):
+#              ciclo diario de temperatura y humedad con ruido y fallos de
+#              lectura aleatorios, agrupados en rachas como los reales.
+#
+# Autor: migbertweb
+# Fecha: 18/10/2026
+# Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+# Licencia: MIT License
+
+import argparse
+import math
+import random
+
+FAILURES = ["crc", "crc", "crc", "timeout", "response"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Genera una traza CSV del sensor")
+    parser.add_argument("--samples", type=int, default=17280, help="número de muestras")
+    parser.add_argument("--period-ms", type=int, default=5000, help="intervalo entre muestras")
+    parser.add_argument("--fail-rate", type=float, default=0.02, help="probabilidad de iniciar una racha de fallos")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    burst = 0
+    print("t_ms,temp,hum,status")
+    for i in range(args.samples):
+        t_ms = i * args.period_ms
+        if burst == 0 and rng.random() < args.fail_rate:
+            burst = rng.randint(1, 4)
+        if burst:
+            burst -= 1
+            print(f"{t_ms},,,{rng.choice(FAILURES)}")
+            continue
+        day = 2 * math.pi * (t_ms / 86400000)
+        temp = 24 + 6 * math.sin(day) + rng.gauss(0, 0.2)
+        hum = 55 - 15 * math.sin(day) + rng.gauss(0, 0.5)
+        print(f"{t_ms},{temp:.1f},{min(max(hum, 0), 100):.1f},ok")
+
+
+if __name__ == "__main__":
+    main()
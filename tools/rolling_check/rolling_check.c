@@ -0,0 +1,101 @@
+/* Archivo: rolling_check.c
+ * Descripción: Comprobación en el host de las ventanas de rolling_stats.c.
+ *              Tras una lectura de 20,0 °C / 60,0 % llega una entrada
+ *              constante de 24,0 °C / 40,0 % cada 5 s (el periodo por
+ *              defecto) durante cinco constantes de tiempo de la ventana
+ *              larga. La EWMA de las dos ventanas debe seguir la curva
+ *              1 - e^(-t/tau) y acabar en la entrada, y la ventana larga
+ *              solo debe ver la entrada constante cuando la lectura inicial
+ *              ha salido.
+ *
+ *              Uso (desde este directorio):
+ *                make run
+ *
+ *              Sale con código distinto de cero si falla alguna
+ *              comprobación.
+ *
+ * Autor: migbertweb
+ * Fecha: 18/10/2026
+ * Repositorio: https://github.com/migbertweb/DHT11_Oled_Info
+ * Licencia: MIT License
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rolling_stats.h"
+
+#define PERIOD_S 5
+#define FROM_TEMP 200
+#define FROM_HUM 600
+#define TO_TEMP 240
+#define TO_HUM 400
+
+static int failures;
+
+static void check(bool ok, const char *what, int got, int expected) {
+  printf("%-44s %5d (esperado %5d) %s\n", what, got, expected,
+         ok ? "ok" : "FALLO");
+  if (!ok) {
+    failures++;
+  }
+}
+
+// Valor de la EWMA tras t segundos de entrada constante, en décimas
+static int expected_ewma(int from, int to, double t, double tau) {
+  return (int)lround(to + (from - to) * exp(-t / tau));
+}
+
+static void check_ewma(rolling_window_t window, const char *name, double t) {
+  rolling_stats_t stats;
+  char what[64];
+
+  rolling_stats_get(window, &stats);
+  int temp = expected_ewma(FROM_TEMP, TO_TEMP, t, stats.window_s);
+  int hum = expected_ewma(FROM_HUM, TO_HUM, t, stats.window_s);
+  snprintf(what, sizeof(what), "%s: EWMA temp. a %.0f h", name, t / 3600);
+  check(abs(stats.temperature.ewma - temp) <= 1, what,
+        stats.temperature.ewma, temp);
+  snprintf(what, sizeof(what), "%s: EWMA hum. a %.0f h", name, t / 3600);
+  check(abs(stats.humidity.ewma - hum) <= 1, what, stats.humidity.ewma, hum);
+}
+
+int main(void) {
+  // Instantes (en constantes de tiempo de la ventana larga) a comprobar
+  static const int checkpoints[] = {1, 2, 3, 5};
+  const int64_t start_s = 1; // 0 es «sin lecturas» para la EWMA
+  size_t next = 0;
+
+  rolling_stats_add(start_s * 1000000, FROM_TEMP, FROM_HUM);
+  for (int64_t t = PERIOD_S;
+       next < sizeof(checkpoints) / sizeof(checkpoints[0]); t += PERIOD_S) {
+    rolling_stats_add((start_s + t) * 1000000, TO_TEMP, TO_HUM);
+    if (t == (int64_t)checkpoints[next] * CONFIG_ROLLING_LONG_WINDOW_S) {
+      check_ewma(ROLLING_LONG, "24 h", t);
+      next++;
+    }
+    if (t == CONFIG_ROLLING_SHORT_WINDOW_S) {
+      check_ewma(ROLLING_SHORT, "1 h", t);
+    }
+  }
+  check_ewma(ROLLING_SHORT, "1 h", 5.0 * CONFIG_ROLLING_LONG_WINDOW_S);
+
+  rolling_stats_t stats;
+  rolling_stats_get(ROLLING_LONG, &stats);
+  check(stats.temperature.min == TO_TEMP, "24 h: mínimo", stats.temperature.min,
+        TO_TEMP);
+  check(stats.temperature.max == TO_TEMP, "24 h: máximo", stats.temperature.max,
+        TO_TEMP);
+  check(stats.humidity.mean == TO_HUM, "24 h: media hum.", stats.humidity.mean,
+        TO_HUM);
+  check(stats.humidity.stddev == 0, "24 h: desviación hum.",
+        stats.humidity.stddev, 0);
+
+  if (failures) {
+    printf("\n%d comprobación(es) fallida(s)\n", failures);
+    return 1;
+  }
+  return 0;
+}